@@ -15,7 +15,11 @@
 #include "vex.h"
 #include "../core/include/robot_specs.h"
 #include "../core/include/utils/pid.h"
+#include "../core/include/utils/state_space.h"
+#include "../core/include/utils/control_loop.h"
 #include <atomic>
+#include <vector>
+#include <functional>
 
 using namespace vex;
 
@@ -27,13 +31,74 @@ using namespace vex;
  * 
 */
 class Flywheel{
+  public:
+
+  /**
+  * The control schemes the flywheel can use. Can be changed at runtime with setControlStyle
+  */
   enum FlywheelControlStyle{
     PID_Feedforward,
     Feedforward,
     Take_Back_Half,
     Bang_Bang,
+    State_Space,
+  };
+
+  /**
+  * How long the control loop takes to run, measured every tick. See ControlLoop
+  */
+  typedef ControlLoop::tick_stats_t tick_stats_t;
+
+  /**
+  * One sample of telemetry, recorded every tick of the control loop. Floats, to keep the buffer small
+  */
+  struct telemetry_sample_t
+  {
+    float time;     ///< seconds since telemetry was started
+    float setpoint; ///< target RPM
+    float rpm;      ///< measured (filtered) RPM
+    float volts;    ///< voltage sent to the motors
+    float current;  ///< current drawn by the motors, amps
+  };
+
+  /**
+  * Performance metrics, calculated as the telemetry is recorded.
+  * Rise time, overshoot and steady state error are for the most recent change of setpoint.
+  */
+  struct metrics_t
+  {
+    double rise_time;          ///< seconds to go from 10% to 90% of the last setpoint change. 0 if it hasn't yet
+    double overshoot;          ///< the furthest past the setpoint the RPM went, after rising (RPM)
+    double steady_state_error; ///< mean error (setpoint - RPM) once settled, not counting shot recoveries (RPM)
+    double last_recovery_time; ///< seconds it took to recover from the last shot
+    double avg_recovery_time;  ///< mean recovery time over all shots
+    int shots;                 ///< how many shot recoveries the average covers
+  };
+
+  /**
+  * shot_config_t holds the parameters for detecting discs being launched, and for recovering from them.
+  * A shot is detected when the flywheel was up to speed, and then either drops more than drop_rpm below its
+  * target or draws more than current_spike amps. Until it is back within recovered_rpm of the target, boost is
+  * added to the output of the control loop, so it spins back up faster than the loop alone would.
+  */
+  struct shot_config_t
+  {
+    double drop_rpm;       ///< how far below the target the RPM must drop to count as a shot
+    double current_spike;  ///< current (amps) that counts as a shot. 0 to only use drop_rpm
+    double recovered_rpm;  ///< how close to the target the RPM must be to be recovered (and to detect the next shot)
+    double boost;          ///< extra output (percent) added while recovering
+    double max_boost_time; ///< the most time (seconds) to boost for, after each shot
+  };
+
+  /**
+  * A detected shot
+  */
+  struct shot_event_t
+  {
+    double time;          ///< when the shot was detected, in seconds since the flywheel was created
+    double min_rpm;       ///< the lowest RPM the flywheel dropped to
+    double recovery_time; ///< seconds from the shot until the flywheel recovered. 0 while still recovering
   };
-  public:
 
   // CONSTRUCTORS, GETTERS, AND SETTERS
   /**
@@ -68,6 +133,16 @@ class Flywheel{
   */
   Flywheel(motor_group &motors, const double ratio);
 
+  /**
+  * Create the Flywheel object using a state space controller: a Kalman filter estimates the RPM from the
+  * motor position, and an LQR gain corrects the error on top of the feedforward. See VelocityStateSpace.
+  * @param motors    the motors on the fly wheel
+  * @param ff_config the feedforward config to use. kV and kA must be identified (see SysId)
+  * @param ss_config the state space tuning parameters
+  * @param ratio     ratio of the whatever just multiplies the velocity
+  */
+  Flywheel(motor_group &motors, FeedForward::ff_config_t &ff_config, VelocityStateSpace::ss_config_t &ss_config, const double ratio);
+
   /**
   * Return the RPM that the flywheel is currently trying to achieve
   * @return RPM  the target rpm
@@ -75,8 +150,8 @@ class Flywheel{
   double getDesiredRPM();
 
   /**
-  * Checks if the background RPM controlling task is running
-  * @return true if the task is running
+  * Checks if the background control loop is controlling the RPM
+  * @return true if the RPM is being controlled
   */
   bool isTaskRunning();
 
@@ -126,6 +201,121 @@ class Flywheel{
 */
   void updatePID(double value);
 
+  // CONTROL SERVICE
+
+  /**
+  * Change the control scheme. Takes effect on the next tick, without restarting the control task.
+  * PID_Feedforward needs a PID config, and State_Space needs the state space constructor.
+  * @param style the control scheme to use
+  */
+  void setControlStyle(FlywheelControlStyle style);
+
+  /**
+  * @return the control scheme currently in use
+  */
+  FlywheelControlStyle getControlStyle();
+
+  /**
+  * Change how often the control loop runs. The RPM filter is resized to keep the same window in time.
+  * The state space gains are calculated for one period, so it keeps its own.
+  * @param period_ms the time between ticks, in milliseconds
+  */
+  void setControlPeriod(int period_ms);
+
+  /**
+  * @return the time between ticks of the control loop, in milliseconds
+  */
+  int getControlPeriod();
+
+  /**
+  * Run one tick of the control loop: sample the sensors once, then run the current control scheme.
+  * Does nothing but sample the sensors if the flywheel was stopped.
+  * FOR USE BY TASKS ONLY
+  */
+  void controlTick();
+
+  /**
+  * @return how much CPU time the control loop is using
+  */
+  tick_stats_t getTickStats();
+
+  /**
+  * Reset the tick time statistics
+  */
+  void resetTickStats();
+
+  // SHOT DETECTION
+
+  /**
+  * Start detecting shots, and boosting the output to recover from them
+  * @param shot_config the shot detection parameters
+  */
+  void setShotDetection(shot_config_t &shot_config);
+
+  /**
+  * Check the RPM and current for a shot, and track the recovery from the last one.
+  * Should be called once per loop, after the RPM is measured
+  * FOR USE BY TASKS ONLY
+  */
+  void updateShotDetection();
+
+  /**
+  * @return true if a shot was detected and the flywheel hasn't gotten back up to speed yet
+  */
+  bool isRecovering();
+
+  /**
+  * @return how many shots have been detected
+  */
+  int getShotCount();
+
+  /**
+  * @return the last shot that was detected. All zeros if there haven't been any
+  */
+  shot_event_t getLastShot();
+
+  /**
+  * @return seconds since the last shot was detected, or -1 if there haven't been any
+  */
+  double getTimeSinceShot();
+
+  // TELEMETRY
+
+  /**
+  * Start recording telemetry every tick into a ring buffer. Once it's full, the oldest samples are overwritten.
+  * The buffer is allocated here, once. Calling again clears it
+  * @param size how many samples to keep. At the default 10ms control period, 2000 is the last 20 seconds
+  */
+  void startTelemetry(int size=2000);
+
+  /**
+  * @return how many samples are in the telemetry buffer
+  */
+  int getTelemetrySize();
+
+  /**
+  * Get a sample from the telemetry buffer
+  * @param i which sample. 0 is the oldest, getTelemetrySize() - 1 the newest
+  */
+  telemetry_sample_t getTelemetrySample(int i);
+
+  /**
+  * @return performance metrics for the control loop
+  */
+  metrics_t getMetrics();
+
+  /**
+  * Reset the metrics, without clearing the telemetry buffer
+  */
+  void resetMetrics();
+
+  /**
+  * Save the telemetry buffer and the metrics to the SD card as CSV
+  * @param filename the file to write
+  * @return false if there was no SD card or no telemetry
+  */
+  bool saveTelemetry(const char *filename);
+
   // SPINNERS AND STOPPERS
 
   /** 
@@ -145,14 +335,21 @@ class Flywheel{
   void spin_manual(double speed, directionType dir=fwd);
   
   /**
-  * starts or sets the RPM thread at new value
+  * sets the RPM the control loop should hold, starting the control task the first time it's called
   * what control scheme is dependent on control_style
   * @param rpm - the RPM we want to spin at
   */
   void spinRPM(int rpm);
 
   /**
-  * stop the RPM thread and the wheel
+  * Spin at an RPM that is recalculated every tick, e.g. from the distance to the goal, so the flywheel is
+  * already at the right speed when the robot stops moving. Cancelled by spinRPM() or stop()
+  * @param rpm_source called every tick to get the RPM to spin at
+  */
+  void spinRPMTracking(std::function<double(void)> rpm_source);
+
+  /**
+  * stop controlling the RPM and stop the wheel. The control task keeps running, idle
   */
   void stop();
 
@@ -169,15 +366,69 @@ class Flywheel{
 
   private:
 
+  /**
+  * Read each sensor once, for this tick
+  */
+  void sampleSensors();
+
+  /**
+  * Reset the state of the control schemes, so they start fresh
+  */
+  void resetControl();
+
+  // One tick of each control scheme
+  void tickBangBang();
+  void tickFeedforward();
+  void tickPIDFeedforward();
+  void tickTBH();
+  void tickStateSpace();
+
+  /**
+  * Record this tick's telemetry, and update the metrics from it
+  */
+  void recordTelemetry();
+
   motor_group &motors;                // motors that make up the flywheel
-  bool taskRunning = false;           // is the task (thread but not) currently running?
+  bool taskRunning = false;           // is the control loop currently controlling the RPM?
+  bool serviceStarted = false;        // has the control task been started?
   PID pid;                            // PID on the flywheel
   FeedForward ff;                     // FF constants for the flywheel
   double TBH_gain;                    // TBH gain parameter for the flywheel
   double ratio;                       // multiplies the velocity by this value
   std::atomic<double> RPM;            // Desired RPM of the flywheel. 
-  task rpmTask;                       // task (thread but not) that handles spinning the wheel at a given RPM
+  task rpmTask;                       // task (thread but not) that runs the control loop, started once
   FlywheelControlStyle control_style; // how the flywheel should be controlled
   double smoothedRPM;
   MovingAverage RPM_avger;
+  VelocityStateSpace *state_space = NULL; // state space controller, only used with State_Space control
+  int control_period_ms = 10;             // how often the control loop runs, in milliseconds
+  tick_stats_t tick_stats = {};           // CPU time used by the control loop
+  double sampled_rpm = 0;                 // raw RPM, sampled once per tick
+  double sampled_position = 0;            // position (revolutions), sampled once per tick
+  double sampled_current = 0;             // current (amps), sampled once per tick
+  double tbh = 0;                         // TBH: output at the last zero crossing
+  double tbh_output = 0;                  // TBH: current output
+  double tbh_previous_error = 0;          // TBH: error at the last zero crossing
+  std::function<double(void)> rpm_source; // where the RPM comes from each tick, while tracking
+  double last_volts = 0;                  // voltage last sent to the motors
+  std::vector<telemetry_sample_t> telemetry; // ring buffer of telemetry samples, empty until startTelemetry
+  int telemetry_next = 0;                 // where the next sample goes in the buffer
+  int telemetry_count = 0;                // how many samples are in the buffer
+  timer telemetry_tmr;                    // timestamps for telemetry samples
+  metrics_t metrics = {};                 // performance metrics
+  double step_setpoint = 0;               // the setpoint the current metrics are for
+  double step_start_rpm = 0;              // the RPM when the setpoint changed
+  double step_rise_start = -1;            // when the RPM passed 10% of the step, -1 if it hasn't yet
+  double step_rise_end = -1;              // when the RPM passed 90% of the step, -1 if it hasn't yet
+  double sse_sum = 0;                     // sum of the settled error, for the steady state error
+  int sse_count = 0;                      // number of settled samples
+  double counted_shot_time = -1;          // time of the last shot counted in the recovery metrics
+  shot_config_t *shot_cfg = NULL;         // shot detection parameters, NULL if shots aren't detected
+  timer shot_tmr;                         // timestamps for shot events
+  bool shot_armed = false;                // has the flywheel been up to speed since the last shot?
+  bool shot_dropped = false;              // has the RPM dropped out of recovered_rpm since the last shot?
+  bool recovering = false;                // is the flywheel recovering from a shot?
+  double shot_boost = 0;                  // extra output added to spin_raw while recovering
+  int shot_count = 0;                     // how many shots have been detected
+  shot_event_t last_shot = {};            // the last shot that was detected
   };
\ No newline at end of file
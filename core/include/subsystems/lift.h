@@ -2,6 +2,9 @@
 
 #include "vex.h"
 #include "../core/include/utils/pid.h"
+#include "../core/include/utils/feedforward.h"
+#include "../core/include/utils/trapezoid_profile.h"
+#include "../core/include/utils/battery_compensation.h"
 #include <iostream>
 #include <map>
 #include <atomic>
@@ -15,6 +18,12 @@ using namespace std;
  * A general class for lifts (e.g. 4bar, dr4bar, linear, etc)
  * Uses a PID to hold the lift at a certain height under load, and to move the lift to different heights
  *
+ * If max_v and accel are set, moves to a new position follow a trapezoid motion profile instead of stepping the
+ * setpoint, and a feedforward (with a gravity term) does most of the work while the PID corrects the error.
+ *
+ * Homing runs in the lift's background task, so it doesn't block the caller. The lift is homed when it presses the
+ * homing switch or, without one, when it stalls against the hard stop (high current and no movement).
+ *
  * @author Ryan McGee
  */
 template <typename T>
@@ -22,6 +31,17 @@ class Lift
 {
   public:
 
+  /**
+   * Where the lift is in homing
+   */
+  enum HomingState
+  {
+    NOT_HOMED,    ///< homing has never been started
+    HOMING,       ///< driving down, waiting for the switch or a stall
+    HOMED,        ///< found the bottom, and the position was reset to 0
+    HOME_TIMEOUT  ///< gave up after home_timeout. The position was reset anyway, but may be wrong
+  };
+
   /**
    * lift_cfg_t holds the physical parameter specifications of a lify system.
    * includes:
@@ -34,6 +54,20 @@ class Lift
     double softstop_up, softstop_down;
 
     PID::pid_config_t lift_pid_cfg;
+
+    // Motion profiling. Leave max_v or accel at 0 to step to new positions with only the PID
+    double max_v, accel; ///< profile limits, in position units per second (per second)
+    FeedForward::ff_config_t lift_ff_cfg; ///< output is in volts, like the PID
+    double rad_per_unit; ///< arm angle (radians) per unit of position, so kG can be scaled by cos(angle). 0 for a linear lift
+    double level_pos; ///< the position where the arm is level, and gravity pulls hardest
+    int period_ms; ///< how often the lift is updated, in milliseconds. 0 for the default of 10
+
+    // Homing. Leave any of these at 0 for the default
+    double home_volts; ///< voltage to drive down with while homing (default 6)
+    double home_current; ///< current (amps) above which the lift might be stalled (default 1.5)
+    double home_stall_vel; ///< speed (position units per second) below which the lift might be stalled (default 0.1)
+    int home_debounce_ms; ///< how long the lift has to look stalled before it counts (default 100)
+    double home_timeout; ///< seconds before homing gives up (default 3)
   };
 
   /**
@@ -58,28 +92,38 @@ class Lift
     *   A map of enum type T, in which each enum entry corresponds to a different lift height
     */
   Lift(motor_group &lift_motors, lift_cfg_t &lift_cfg, map<T, double> &setpoint_map, limit *homing_switch=NULL)
-  : lift_motors(lift_motors), cfg(lift_cfg), lift_pid(cfg.lift_pid_cfg), setpoint_map(setpoint_map), homing_switch(homing_switch)
+  : lift_motors(lift_motors), cfg(lift_cfg), lift_pid(cfg.lift_pid_cfg), lift_ff(cfg.lift_ff_cfg), profile(cfg.max_v, cfg.accel),
+    setpoint_map(&setpoint_map), homing_switch(homing_switch)
   {
+    start_task();
+  }
 
-    is_async = true;
-    setpoint = 0;
-    
-    // Create a background task that is constantly updating the lift PID, if requested.
-    // Set once, and forget.
-    task t([](void* ptr){
-      Lift &lift = *((Lift*) ptr);
-
-      while(true)
-      {
-        if(lift.get_async())
-          lift.hold();
-
-        vexDelay(50);
-      }
-
-      return 0;
-    }, this);
-
+  /**
+    * Construct the Lift object with an array of setpoints indexed by the enum, instead of a map.
+    * Lookups are a single array index, and the enum must end with a COUNT entry so a missing setpoint is a
+    * compile error instead of a lift sent to 0.
+    *
+    * Usage example:
+    * /code{.cpp}
+    * enum Positions {DOWN, MID, UP, COUNT};
+    * constexpr double setpts[] = {0.0, 0.5, 1.0}; // leave the size empty, so it's checked against COUNT
+    * Lift<Positions> my_lift(motors, lift_cfg, setpts);
+    * /endcode
+    *
+    * @param lift_motors
+    *   A set of motors, all set that positive rotation correlates with the lift going up
+    * @param lift_cfg
+    *   Lift characterization information; PID tunings and movement speeds
+    * @param setpoint_array
+    *   The height of each enum entry, in enum order. Must outlive the lift (e.g. a global constexpr array)
+    */
+  template <size_t N>
+  Lift(motor_group &lift_motors, lift_cfg_t &lift_cfg, const double (&setpoint_array)[N], limit *homing_switch=NULL)
+  : lift_motors(lift_motors), cfg(lift_cfg), lift_pid(cfg.lift_pid_cfg), lift_ff(cfg.lift_ff_cfg), profile(cfg.max_v, cfg.accel),
+    setpoint_array(setpoint_array), homing_switch(homing_switch)
+  {
+    static_assert(N == (size_t)T::COUNT, "Lift: there must be exactly one setpoint for each position, in enum order");
+    start_task();
   }
 
   /**
@@ -104,7 +148,7 @@ class Lift
 
     if(up_ctrl && cur_pos < cfg.softstop_up)
     {
-      lift_motors.spin(directionType::fwd, cfg.up_speed, volt);
+      lift_motors.spin(directionType::fwd, BatteryCompensation::volts(cfg.up_speed), volt);
       setpoint = cur_pos + .3;
 
       // std::cout << "DEBUG OUT: UP " << setpoint << ", " << tmr.time(sec) << ", " << cfg.down_speed << "\n";
@@ -155,9 +199,9 @@ class Lift
       down_hold = false;
 
     if(up_btn && rev < cfg.softstop_up)
-      lift_motors.spin(directionType::fwd, volt_up, voltageUnits::volt);
+      lift_motors.spin(directionType::fwd, BatteryCompensation::volts(volt_up), voltageUnits::volt);
     else if(down_btn && rev > cfg.softstop_down && !down_hold)
-      lift_motors.spin(directionType::rev, volt_down, voltageUnits::volt);
+      lift_motors.spin(directionType::rev, BatteryCompensation::volts(volt_down), voltageUnits::volt);
     else
       lift_motors.spin(directionType::fwd, 0, voltageUnits::volt);
   
@@ -213,10 +257,22 @@ class Lift
     */
   bool set_position(T pos)
   {
-    this->setpoint = setpoint_map[pos];
+    if(setpoint_array != NULL)
+    {
+      move_to(setpoint_array[(size_t)pos]);
+    }
+    else
+    {
+      // Don't use operator[], it would insert (and go to) 0 for a position that isn't in the map
+      typename map<T, double>::iterator it = setpoint_map->find(pos);
+      if(it != setpoint_map->end())
+        move_to(it->second);
+      else
+        printf("(lift.h): Warning - position %d has no setpoint. Holding the current setpoint\n", (int)pos);
+    }
     is_async = true;
 
-    return (lift_pid.get_target() == this->setpoint) && lift_pid.is_on_target();
+    return is_settled();
   }
 
   /**
@@ -227,8 +283,16 @@ class Lift
     */
   bool set_setpoint(double val)
   {
-    this->setpoint = val;
-    return (lift_pid.get_target() == this->setpoint) && lift_pid.is_on_target();
+    move_to(val);
+    return is_settled();
+  }
+
+  /**
+    * @return True once the lift has finished its motion profile to the setpoint, and the PID is on target
+    */
+  bool is_settled()
+  {
+    return !new_goal && !profiling && (lift_pid.get_target() == this->setpoint) && lift_pid.is_on_target();
   }
   
   /**
@@ -240,49 +304,94 @@ class Lift
   }
 
   /**
-    * Target the class's setpoint.
-    * Calculate the PID output and set the lift motors accordingly.
+    * Target the class's setpoint, following the motion profile to it if there is one.
+    * Calculate the PID + feedforward output and set the lift motors accordingly.
     */
   void hold()
   {
-    lift_pid.set_target(setpoint);
-    // std::cout << "DEBUG OUT: SETPOINT " << setpoint << "\n";
+    double cur_pos = (get_sensor != NULL) ? get_sensor() : lift_motors.position(rev);
+    // Take the request before reading the setpoint, so a move_to() in between is planned on the next loop instead
+    // of being mistaken for a direct setpoint change
+    bool plan = new_goal.exchange(false);
+    double goal = setpoint;
+
+    // Plan a profile to a new position, starting from wherever the last profile left off
+    if(plan)
+    {
+      bool continuing = profiling;
+      profiling = cfg.max_v > 0 && cfg.accel > 0;
 
-    if(get_sensor != NULL)
-      lift_pid.update(get_sensor());
-    else
-      lift_pid.update(lift_motors.position(rev));
+      if(profiling)
+      {
+        double start = continuing ? reference.pos : cur_pos;
+        double start_vel = (continuing && sign(reference.vel) == sign(goal - start)) ? fabs(reference.vel) : 0;
+        profile.set_endpts(start, goal);
+        profile.set_vel_endpts(start_vel, 0);
+        profile_tmr.reset();
+      }
+      profile_goal = goal;
+    }
+    // The setpoint was moved directly (e.g. by control_continuous), so stop profiling and follow it
+    else if(goal != profile_goal)
+    {
+      profiling = false;
+      profile_goal = goal;
+    }
 
-    // std::cout << "DEBUG OUT: ROTATION " << lift_motors.rotation(rev) << "\n\n";
+    if(profiling)
+    {
+      double t = profile_tmr.time(sec);
+      reference = profile.calculate(t);
+      if(t >= profile.get_movement_time())
+        profiling = false;
+    }
 
-    lift_motors.spin(fwd, lift_pid.get(), volt);
+    if(!profiling)
+      reference = {.pos = goal, .vel = 0, .accel = 0};
+
+    lift_pid.set_target(reference.pos);
+    lift_pid.update(cur_pos);
+
+    // Gravity pulls on an arm in proportion to how level it is
+    double kg_scale = (cfg.rad_per_unit != 0) ? cos((cur_pos - cfg.level_pos) * cfg.rad_per_unit) : 1.0;
+    double out = lift_pid.get() + lift_ff.calculate(reference.vel, reference.accel, lift_pid.get(), kg_scale);
+
+    lift_motors.spin(fwd, BatteryCompensation::volts(out), volt);
   }
 
   /**
-   * A blocking function that automatically homes the lift based on a sensor or hard stop, 
-   * and sets the position to 0. A watchdog times out after 3 seconds, to avoid damage.
+   * Start homing the lift in the background, based on a sensor or hard stop. When it finds the bottom the position
+   * is set to 0, and the lift goes back to its setpoint. A watchdog times out after home_timeout, to avoid damage.
+   * Setpoints can be set while homing; the lift moves to them once it's done.
+   * Don't run the lift manually (control_manual, control_continuous) while it is homing.
    */
-  void home()
+  void start_homing()
   {
-    static timer tmr;
-    tmr.reset();
-    
-    while(tmr.time(sec) < 3)
-    {
-      lift_motors.spin(directionType::rev, 6, volt);
+    home_tmr.reset();
+    stall_tmr.reset();
+    home_last_pos = (get_sensor != NULL) ? get_sensor() : lift_motors.position(rev);
+    homing_state = HOMING;
+  }
 
-      if (homing_switch == NULL && lift_motors.current(currentUnits::amp) > 1.5)
-        break;
-      else if (homing_switch != NULL && homing_switch->pressing())
-        break;
-    }
+  /**
+   * A blocking function that homes the lift (see start_homing) and waits for it to finish.
+   * @return true if the lift found the bottom, false if it timed out
+   */
+  bool home()
+  {
+    start_homing();
+    while(homing_state == HOMING)
+      vexDelay(10);
 
-    if(reset_sensor != NULL)
-      reset_sensor();
-    
-    lift_motors.resetPosition();
-    lift_motors.stop();
+    return homing_state == HOMED;
+  }
 
+  /**
+   * @return where the lift is in homing. Anything but HOMING means it is done
+   */
+  HomingState get_homing_state()
+  {
+    return homing_state;
   }
 
   /**
@@ -330,11 +439,119 @@ class Lift
 
   private:
 
+  /**
+   * Create a background task that is constantly updating the lift PID, if requested.
+   * Set once, and forget.
+   */
+  void start_task()
+  {
+    is_async = true;
+    setpoint = 0;
+
+    task t([](void* ptr){
+      Lift &lift = *((Lift*) ptr);
+
+      while(true)
+      {
+        if(lift.homing_state == HOMING)
+          lift.home_step();
+        else if(lift.get_async())
+          lift.hold();
+
+        vexDelay(lift.cfg.period_ms > 0 ? lift.cfg.period_ms : 10);
+      }
+
+      return 0;
+    }, this);
+  }
+
+  /**
+   * Run one loop of homing: drive down, and check for the switch or a stall
+   */
+  void home_step()
+  {
+    double volts = (cfg.home_volts > 0) ? cfg.home_volts : 6;
+    double stall_current = (cfg.home_current > 0) ? cfg.home_current : 1.5;
+    double stall_vel = (cfg.home_stall_vel > 0) ? cfg.home_stall_vel : 0.1;
+    int debounce_ms = (cfg.home_debounce_ms > 0) ? cfg.home_debounce_ms : 100;
+    double timeout = (cfg.home_timeout > 0) ? cfg.home_timeout : 3;
+    int period_ms = (cfg.period_ms > 0) ? cfg.period_ms : 10;
+
+    double cur_pos = (get_sensor != NULL) ? get_sensor() : lift_motors.position(rev);
+    double vel = (cur_pos - home_last_pos) / (period_ms / 1000.0);
+    home_last_pos = cur_pos;
+
+    bool found = false;
+    if(homing_switch != NULL)
+    {
+      found = homing_switch->pressing();
+    }
+    else
+    {
+      // The motors draw a lot of current getting started too, so only count a stall after they've had time to move
+      bool stalled = home_tmr.time(sec) > HOME_STARTUP_TIME
+                     && lift_motors.current(currentUnits::amp) > stall_current && fabs(vel) < stall_vel;
+      if(!stalled)
+        stall_tmr.reset();
+
+      found = stalled && stall_tmr.time(msec) >= debounce_ms;
+    }
+
+    bool timed_out = !found && home_tmr.time(sec) > timeout;
+    if(!found && !timed_out)
+    {
+      lift_motors.spin(directionType::rev, BatteryCompensation::volts(volts), volt);
+      return;
+    }
+
+    if(timed_out)
+      printf("(lift.h): Warning - homing timed out after %.1fs\n", timeout);
+
+    if(reset_sensor != NULL)
+      reset_sensor();
+
+    lift_motors.resetPosition();
+    lift_motors.stop();
+
+    // Start over from the new zero, and go to whatever setpoint was asked for in the meantime
+    lift_pid.reset();
+    profiling = false;
+    new_goal = true;
+    homing_state = timed_out ? HOME_TIMEOUT : HOMED;
+  }
+
+  /**
+   * Set a new goal for the lift, which hold() will plan a profile to
+   */
+  void move_to(double val)
+  {
+    if(val == this->setpoint && !new_goal)
+      return;
+
+    this->setpoint = val;
+    new_goal = true;
+  }
+
   motor_group &lift_motors;
   lift_cfg_t &cfg;
   PID lift_pid;
-  map<T, double> &setpoint_map;
+  FeedForward lift_ff;
+  TrapezoidProfile profile;
+  timer profile_tmr;
+  motion_t reference = {};          // where the profile says the lift should be right now
+  atomic<bool> new_goal = {false};  // a new setpoint is waiting for a profile to be planned
+  bool profiling = false;           // is the lift following a profile?
+  double profile_goal = 0;          // the setpoint the current profile (or hold) is for
+  map<T, double> *setpoint_map = NULL;    // setpoints by position, when constructed with a map
+  const double *setpoint_array = NULL;    // setpoints by position, when constructed with an array
   limit *homing_switch;
+  atomic<HomingState> homing_state = {NOT_HOMED};
+  timer home_tmr;                   // time since homing started, for the watchdog
+  timer stall_tmr;                  // time the lift has looked stalled for
+  double home_last_pos = 0;         // position last loop, to find the velocity while homing
+
+  // Time (seconds) after homing starts before a stall can be detected
+  static constexpr double HOME_STARTUP_TIME = 0.25;
   
   atomic<double> setpoint;
   atomic<bool> is_async;
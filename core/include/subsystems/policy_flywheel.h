@@ -0,0 +1,462 @@
+#pragma once
+
+#include "vex.h"
+#include "../core/include/utils/pid.h"
+#include "../core/include/utils/feedforward.h"
+#include "../core/include/utils/state_space.h"
+#include "../core/include/utils/battery_compensation.h"
+#include "../core/include/utils/control_loop.h"
+#include "../core/include/utils/math_util.h"
+#include <math.h>
+
+using namespace vex;
+
+/**
+ * POLICY FLYWHEEL
+ * A flywheel whose control scheme and RPM filter are chosen at compile time, as template parameters.
+ *
+ * Flywheel picks its control scheme at runtime, which is what you want while tuning. Once the scheme is picked,
+ * PolicyFlywheel<Controller, Filter> builds the same loop with no runtime dispatch: the filter and controller are
+ * plain members, so each tick compiles down to one sensor read, the filter math, and the controller math.
+ * Only the sensor the filter needs is read. The loop is scheduled and timed by ControlLoop, the same as Flywheel.
+ *
+ * Controllers: BangBangControl, TBHControl, FeedforwardControl, PIDFFControl, StateSpaceControl
+ * Filters: MovingAverageFilter, EMAFilter, KalmanFilter
+ *
+ * Usage example:
+ * /code{.cpp}
+ * PIDFFControl::config_t fw_ctrl_cfg = {.pid = {.p = .001}, .ff = {.kV = .0003}};
+ * EMAFilter::config_t fw_filter_cfg = {.time_constant = .03};
+ * PolicyFlywheel<PIDFFControl, EMAFilter> fw(flywheel_motors, fw_ctrl_cfg, fw_filter_cfg, 18);
+ * /endcode
+ *
+ * Every policy is constructed from (config_t &cfg, int period_ms), and may keep a reference to its config.
+ * A Filter provides:
+ *   static const bool uses_position;                         true to be given position, false for velocity
+ *   void reset(double rpm);
+ *   double update(double raw_rpm, double position);          returns the filtered RPM
+ * A Controller provides:
+ *   void reset();
+ *   double update(double rpm, double target);                returns the output, in percent
+ */
+template <typename Controller, typename Filter>
+class PolicyFlywheel
+{
+  public:
+
+  /**
+   * Create the flywheel. The control task starts the first time spinRPM() is called
+   * @param motors         the motors on the fly wheel
+   * @param controller_cfg the configuration of the controller policy
+   * @param filter_cfg     the configuration of the filter policy
+   * @param ratio          ratio of the whatever just multiplies the velocity
+   * @param period_ms      how often the control loop runs, in milliseconds
+   */
+  PolicyFlywheel(motor_group &motors, typename Controller::config_t &controller_cfg, typename Filter::config_t &filter_cfg, const double ratio, int period_ms=10)
+    : motors(motors), controller(controller_cfg, period_ms), filter(filter_cfg, period_ms), ratio(ratio), period_ms(period_ms)
+  {}
+
+  /**
+   * sets the RPM the control loop should hold, starting the control task the first time it's called
+   * @param rpm the RPM we want to spin at. 0 stops the flywheel
+   */
+  void spinRPM(int rpm)
+  {
+    if (rpm == 0)
+    {
+      stop();
+      return;
+    }
+
+    target = rpm;
+    if (!running)
+    {
+      filter.reset(ratio * motors.velocity(velocityUnits::rpm));
+      controller.reset();
+      running = true;
+    }
+
+    if (!task_started)
+    {
+      control_task = task(control_loop, this);
+      task_started = true;
+    }
+  }
+
+  /**
+   * stop controlling the RPM and stop the wheel. The control task keeps running, idle
+   */
+  void stop()
+  {
+    running = false;
+    target = 0;
+    rpm = 0;
+    motors.stop();
+  }
+
+  /**
+   * @return the RPM the flywheel is trying to hold
+   */
+  double getDesiredRPM() { return target; }
+
+  /**
+   * @return the filtered RPM from the last tick
+   */
+  double getRPM() { return rpm; }
+
+  /**
+   * @return the output (percent) from the last tick
+   */
+  double getOutput() { return output; }
+
+  /**
+   * @return true if the RPM is being controlled
+   */
+  bool isTaskRunning() { return running; }
+
+  /**
+   * @return how much CPU time the control loop is using
+   */
+  ControlLoop::tick_stats_t getTickStats() { return tick_stats; }
+
+  /**
+   * Reset the tick time statistics
+   */
+  void resetTickStats() { tick_stats = {}; }
+
+  /**
+   * @return the controller, to read its state
+   */
+  Controller &getController() { return controller; }
+
+  /**
+   * @return the filter, to read its state
+   */
+  Filter &getFilter() { return filter; }
+
+  /**
+   * Run one tick of the control loop: read the sensor the filter needs, filter it, and set the motors.
+   * Does nothing if the flywheel was stopped.
+   * FOR USE BY TASKS ONLY
+   */
+  void controlTick()
+  {
+    if (!running)
+      return;
+
+    uint64_t start_us = ControlLoop::start_tick();
+
+    // Filter::uses_position is known at compile time, so only one sensor is read
+    if (Filter::uses_position)
+      rpm = filter.update(0, ratio * motors.position(rotationUnits::rev));
+    else
+      rpm = filter.update(ratio * motors.velocity(velocityUnits::rpm), 0);
+
+    output = controller.update(rpm, target);
+    motors.spin(fwd, BatteryCompensation::percent_to_volts(output), voltageUnits::volt);
+
+    ControlLoop::end_tick(tick_stats, start_us, period_ms);
+  }
+
+  private:
+
+  /**
+   * Runs the control loop at a fixed rate, forever
+   */
+  static int control_loop(void *self)
+  {
+    PolicyFlywheel &fw = *(PolicyFlywheel *)self;
+    uint32_t next_tick = timer::system();
+    while (true)
+    {
+      fw.controlTick();
+      ControlLoop::wait_for_next_tick(next_tick, fw.period_ms);
+    }
+    return 0;
+  }
+
+  motor_group &motors;
+  Controller controller;
+  Filter filter;
+  double ratio;
+  int period_ms;
+
+  task control_task;
+  bool task_started = false;
+  bool running = false;
+
+  double target = 0;
+  double rpm = 0;
+  double output = 0;
+  ControlLoop::tick_stats_t tick_stats = {};
+};
+
+// ======================== FILTERS ========================
+
+/**
+ * Average of the last window_size velocity readings
+ */
+class MovingAverageFilter
+{
+  public:
+  struct config_t
+  {
+    int window_size; ///< how many readings to average
+  };
+
+  static const bool uses_position = false;
+
+  MovingAverageFilter(config_t &cfg, int /*period_ms*/) : avg(cfg.window_size > 0 ? cfg.window_size : 1) {}
+
+  void reset(double rpm) { avg = MovingAverage(avg.get_size(), rpm); }
+
+  double update(double raw_rpm, double /*position*/)
+  {
+    avg.add_entry(raw_rpm);
+    return avg.get_average();
+  }
+
+  private:
+  MovingAverage avg;
+};
+
+/**
+ * Exponential moving average of the velocity readings. Same smoothing as a moving average, with no buffer
+ */
+class EMAFilter
+{
+  public:
+  struct config_t
+  {
+    double time_constant; ///< seconds. larger is smoother, but lags more
+  };
+
+  static const bool uses_position = false;
+
+  EMAFilter(config_t &cfg, int period_ms)
+  {
+    double dt = period_ms / 1000.0;
+    alpha = dt / (cfg.time_constant + dt);
+  }
+
+  void reset(double rpm) { value = rpm; }
+
+  double update(double raw_rpm, double /*position*/)
+  {
+    value += alpha * (raw_rpm - value);
+    return value;
+  }
+
+  private:
+  double alpha = 1;
+  double value = 0;
+};
+
+/**
+ * Kalman filter that estimates velocity from the motor position, modeling the flywheel as constant velocity
+ * with random changes in speed (like shots). Position is much less noisy than the motor's velocity reading.
+ * The gains are steady state, calculated once in the constructor.
+ */
+class KalmanFilter
+{
+  public:
+  struct config_t
+  {
+    double accel_stdev;   ///< how much the velocity changes each tick that the model doesn't know about (RPM)
+    double encoder_stdev; ///< standard deviation of the position measurement (revolutions)
+  };
+
+  static const bool uses_position = true;
+
+  KalmanFilter(config_t &cfg, int period_ms)
+  {
+    dt = period_ms / 60000.0; // minutes, to match RPM
+    double qv = cfg.accel_stdev * cfg.accel_stdev;
+    double rp = cfg.encoder_stdev * cfg.encoder_stdev;
+
+    // F = [1 dt; 0 1], H = [1 0]. Iterate the riccati equation until the gains settle
+    double p00 = rp, p01 = 0, p11 = qv;
+    for (int i = 0; i < 1000; i++)
+    {
+      double m00 = p00 + (2 * dt * p01) + (dt * dt * p11);
+      double m01 = p01 + (dt * p11);
+      double m11 = p11 + qv;
+
+      double s = m00 + rp;
+      l_pos = m00 / s;
+      l_vel = m01 / s;
+
+      p00 = (1 - l_pos) * m00;
+      p01 = (1 - l_pos) * m01;
+      p11 = m11 - (l_vel * m01);
+    }
+  }
+
+  void reset(double rpm)
+  {
+    vel = rpm;
+    initialized = false;
+  }
+
+  double update(double /*raw_rpm*/, double position)
+  {
+    if (!initialized)
+    {
+      pos = position;
+      initialized = true;
+    }
+
+    pos += vel * dt;
+    double innovation = position - pos;
+    pos += l_pos * innovation;
+    vel += l_vel * innovation;
+    return vel;
+  }
+
+  private:
+  double dt = 0;
+  double l_pos = 0, l_vel = 0;
+  double pos = 0, vel = 0;
+  bool initialized = false;
+};
+
+// ======================== CONTROLLERS ========================
+
+/**
+ * Full power below the target, nothing above it
+ */
+class BangBangControl
+{
+  public:
+  struct config_t
+  {
+  };
+
+  BangBangControl(config_t &/*cfg*/, int /*period_ms*/) {}
+
+  void reset() {}
+
+  double update(double rpm, double target) { return (rpm < target) ? 1 : 0; }
+};
+
+/**
+ * Take Back Half
+ * https://www.vexwiki.org/programming/controls_algorithms/tbh
+ */
+class TBHControl
+{
+  public:
+  struct config_t
+  {
+    double gain; ///< per millisecond, the same as Flywheel's TBH gain
+  };
+
+  TBHControl(config_t &cfg, int period_ms) : cfg(cfg), period_ms(period_ms) {}
+
+  void reset()
+  {
+    out = 0;
+    tbh = 0;
+    previous_error = 0;
+  }
+
+  double update(double rpm, double target)
+  {
+    double error = target - rpm;
+    out += cfg.gain * error * period_ms;
+    out = clamp(out, 0, 1);
+
+    if (sign(error) != sign(previous_error))
+    {
+      out = .5 * (out + tbh);
+      tbh = out;
+      previous_error = error;
+    }
+    return out;
+  }
+
+  private:
+  config_t &cfg;
+  int period_ms;
+  double out = 0, tbh = 0, previous_error = 0;
+};
+
+/**
+ * Feedforward only
+ */
+class FeedforwardControl
+{
+  public:
+  struct config_t
+  {
+    FeedForward::ff_config_t ff;
+  };
+
+  FeedforwardControl(config_t &cfg, int /*period_ms*/) : ff(cfg.ff) {}
+
+  void reset() {}
+
+  double update(double /*rpm*/, double target) { return ff.calculate(target, 0); }
+
+  private:
+  FeedForward ff;
+};
+
+/**
+ * PID + Feedforward
+ */
+class PIDFFControl
+{
+  public:
+  struct config_t
+  {
+    PID::pid_config_t pid;
+    FeedForward::ff_config_t ff;
+  };
+
+  PIDFFControl(config_t &cfg, int /*period_ms*/) : pid(cfg.pid), ff(cfg.ff) {}
+
+  void reset() { pid.reset(); }
+
+  double update(double rpm, double target)
+  {
+    pid.set_target(target);
+    return pid.update(rpm) + ff.calculate(target, 0);
+  }
+
+  private:
+  PID pid;
+  FeedForward ff;
+};
+
+/**
+ * Feedforward plus an LQR gain on the velocity error. The gain comes from VelocityStateSpace, but the velocity
+ * comes from the Filter policy, so pair it with KalmanFilter for the full state space controller.
+ */
+class StateSpaceControl
+{
+  public:
+  struct config_t
+  {
+    FeedForward::ff_config_t ff; ///< kV and kA must be identified (see SysId)
+    VelocityStateSpace::ss_config_t ss; ///< only the controller parameters are used. period_ms should match the loop
+  };
+
+  StateSpaceControl(config_t &cfg, int period_ms) : cfg(cfg), ss(cfg.ff, cfg.ss)
+  {
+    if (cfg.ss.period_ms != period_ms)
+      printf("(policy_flywheel.h): Warning - the state space gains are for %dms, but the loop runs every %dms\n", cfg.ss.period_ms, period_ms);
+  }
+
+  void reset() {}
+
+  double update(double rpm, double target)
+  {
+    double u_ff = (target != 0) ? (cfg.ff.kS * sign(target)) + (cfg.ff.kV * target) : 0;
+    return clamp(u_ff + (ss.get_control_gain() * (target - rpm)), -1, 1);
+  }
+
+  private:
+  config_t &cfg;
+  VelocityStateSpace ss;
+};
@@ -15,6 +15,8 @@
 
 using namespace vex;
 
+class MotionController;
+
 /**
  * TankDrive is a class to run a tank drive system.
  * A tank drive system, sometimes called differential drive, has a motor (or group of synchronized motors) on the left and right side
@@ -23,6 +25,50 @@ class TankDrive
 {
 public:
 
+  /**
+   * The state of one autonomous movement: the target it worked out when it started, and how far along it is.
+   * 
+   * Every autonomous drive function has a version that takes a drive_motion_t. Each movement that keeps its
+   * own drive_motion_t can be prepared, interleaved or restarted without touching any other movement. The
+   * versions without one share a drive_motion_t inside the TankDrive, so only one of those can be in progress
+   * at a time.
+   * 
+   * A movement starts over from the robot's current position the next time it is run after it finishes or is reset.
+   *
+   * A movement can't be copied, because its heading correction PID runs on the movement's own copy of the gains.
+   */
+  struct drive_motion_t
+  {
+    drive_motion_t() {}
+    drive_motion_t(const drive_motion_t &) = delete;
+    drive_motion_t &operator=(const drive_motion_t &) = delete;
+
+    bool initialized = false; ///< true once the movement has set its target, until it finishes or is reset
+    point_t target = {0, 0}; ///< where drive_forward is driving to
+    double target_heading = 0; ///< where turn_degrees is turning to (degrees)
+
+    bool arc_fallback = false; ///< true if drive_arc_to_point handed the movement off to drive_to_point
+    double arc_start_heading = 0; ///< heading of travel at the start of the arc (degrees)
+    double arc_angle = 0; ///< total change in heading along the arc (degrees, CCW positive)
+    double arc_length = 0; ///< length of the arc (inches)
+    bool is_pure_pursuit = false; ///< true if pure pursuit is driving this movement
+
+    PID::pid_config_t correction_cfg = {}; ///< the drive's correction_pid gains, copied when the movement starts
+    PID correction_pid{correction_cfg}; ///< keeps the robot pointed at the target during this movement
+    double handoff_speed = 0; ///< the speed (inches/second) to start at, handed off by a movement blended into this one
+
+    /**
+     * Forget the movement's progress and any speed handed off to it, so it starts over the next time it is run
+     */
+    void reset()
+    {
+      initialized = false;
+      arc_fallback = false;
+      is_pure_pursuit = false;
+      handoff_speed = 0;
+    }
+  };
+
   /**
    * Create the TankDrive object 
    * @param left_motors left side drive motors
@@ -69,9 +115,18 @@ public:
    * @param dir        the direction we want to travel forward and backward
    * @param feedback   the custom feedback controller we will use to travel. controls the rate at which we accelerate and drive.
    * @param max_speed  the maximum percentage of robot speed at which the robot will travel. 1 = full power
+   * @param end_speed  the speed (inches/second) the robot should still be moving at when it reaches the target. 0 stops at the target
+   * @return true when we have reached our target distance
+   */
+  bool drive_forward(double inches, directionType dir, Feedback &feedback, double max_speed=1, double end_speed=0);
+
+  /**
+   * Use odometry to drive forward a certain distance, keeping the movement's state in `motion`
+   * @param motion     the state of this movement. See drive_motion_t
+   * (the rest are the same as above)
    * @return true when we have reached our target distance
    */
-  bool drive_forward(double inches, directionType dir, Feedback &feedback, double max_speed=1);
+  bool drive_forward(drive_motion_t &motion, double inches, directionType dir, Feedback &feedback, double max_speed=1, double end_speed=0);
 
   /**
    * Autonomously drive the robot forward a certain distance
@@ -80,8 +135,9 @@ public:
    * @param inches      degrees by which we will turn relative to the robot (+) turns ccw, (-) turns cw
    * @param dir        the direction we want to travel forward and backward
    * @param max_speed   the maximum percentage of robot speed at which the robot will travel. 1 = full power
+   * @param end_speed   the speed (inches/second) the robot should still be moving at when it reaches the target. 0 stops at the target
    */
-  bool drive_forward(double inches, directionType dir, double max_speed=1);
+  bool drive_forward(double inches, directionType dir, double max_speed=1, double end_speed=0);
 
   /**
    * Autonomously turn the robot X degrees counterclockwise (negative for clockwise), with a maximum motor speed
@@ -95,6 +151,13 @@ public:
    */
   bool turn_degrees(double degrees, Feedback &feedback, double max_speed=1);
 
+  /**
+   * Autonomously turn the robot X degrees counterclockwise, keeping the movement's state in `motion`
+   * @param motion      the state of this movement. See drive_motion_t
+   * (the rest are the same as above)
+   */
+  bool turn_degrees(drive_motion_t &motion, double degrees, Feedback &feedback, double max_speed=1);
+
   /**
    * Autonomously turn the robot X degrees to counterclockwise (negative for clockwise), with a maximum motor speed
    * of percent_speed (-1.0 -> 1.0)
@@ -116,8 +179,16 @@ public:
    * @param dir        the direction we want to travel forward and backward
    * @param feedback   the feedback controller we will use to travel. controls the rate at which we accelerate and drive.
    * @param max_speed  the maximum percentage of robot speed at which the robot will travel. 1 = full power
+   * @param end_speed  the speed (inches/second) the robot should still be moving at when it reaches the point. 0 stops at the point
    */
-  bool drive_to_point(double x, double y, vex::directionType dir, Feedback &feedback, double max_speed=1);
+  bool drive_to_point(double x, double y, vex::directionType dir, Feedback &feedback, double max_speed=1, double end_speed=0);
+
+  /**
+   * Use odometry to automatically drive the robot to a point on the field, keeping the movement's state in `motion`
+   * @param motion     the state of this movement. See drive_motion_t
+   * (the rest are the same as above)
+   */
+  bool drive_to_point(drive_motion_t &motion, double x, double y, vex::directionType dir, Feedback &feedback, double max_speed=1, double end_speed=0);
   
   /**
    * Use odometry to automatically drive the robot to a point on the field.
@@ -129,18 +200,62 @@ public:
    * @param y          the y position of the target
    * @param dir        the direction we want to travel forward and backward
    * @param max_speed  the maximum percentage of robot speed at which the robot will travel. 1 = full power
+   * @param end_speed  the speed (inches/second) the robot should still be moving at when it reaches the point. 0 stops at the point
    */
-  bool drive_to_point(double x, double y, vex::directionType dir, double max_speed=1);
+  bool drive_to_point(double x, double y, vex::directionType dir, double max_speed=1, double end_speed=0);
+
+  /**
+   * Use odometry to drive the robot to a point on the field along a circular arc, starting tangent to the robot's
+   * current heading. Unlike drive_to_point, turning and driving are planned together: the heading setpoint is taken
+   * from the same motion profile as the distance (heading = start + curvature * distance travelled), so both finish
+   * at the same time and the robot always takes the same path. The turn is fed forward from the arc between where
+   * the robot is and the point, so a robot that drifts off the planned arc steers onto one that still ends at the
+   * point. The profile's velocity and acceleration are only scaled down if the outside wheels of the arc would need
+   * more than full power.
+   *
+   * The arc is longer than a straight line, so to just reach the point drive_to_point is faster. Use the arc when the
+   * robot should also end up facing along it: that's faster than drive_to_point and then turn_to_heading.
+   * 
+   * Points more than 90 degrees off of the robot's heading can't be reached with a sensible arc, so those fall back
+   * to drive_to_point.
+   *
+   * Returns whether or not the robot has reached it's destination.
+   * @param x          the x position of the target
+   * @param y          the y position of the target
+   * @param dir        the direction we want to travel forward and backward
+   * @param feedback   the motion profile we will use to travel along the arc
+   * @param max_speed  the maximum percentage of robot speed at which the robot will travel. 1 = full power
+   * @return true when we have reached the point
+   */
+  bool drive_arc_to_point(double x, double y, vex::directionType dir, MotionController &feedback, double max_speed=1);
+
+  /**
+   * Drive the robot to a point on the field along a circular arc, keeping the movement's state in `motion`
+   * @param motion     the state of this movement. See drive_motion_t
+   * (the rest are the same as above)
+   */
+  bool drive_arc_to_point(drive_motion_t &motion, double x, double y, vex::directionType dir, MotionController &feedback, double max_speed=1);
 
   /**
    * Turn the robot in place to an exact heading relative to the field.
    * 0 is forward.
    * 
+   * For a profiled turn, pass a MotionController whose profile is in degrees/second and whose feedforward was
+   * found with MotionController::tune_feedforward_angular(). The heading then follows a trapezoid profile, with
+   * the angular feedforward doing most of the work and the PID correcting.
+   * 
    * @param heading_deg the heading to which we will turn 
    * @param feedback    the feedback controller we will use to travel. controls the rate at which we accelerate and drive.
    * @param max_speed  the maximum percentage of robot speed at which the robot will travel. 1 = full power
    */
   bool turn_to_heading(double heading_deg, Feedback &feedback, double max_speed=1);
+
+  /**
+   * Turn the robot in place to an exact heading relative to the field, keeping the movement's state in `motion`
+   * @param motion      the state of this movement. See drive_motion_t
+   * (the rest are the same as above)
+   */
+  bool turn_to_heading(drive_motion_t &motion, double heading_deg, Feedback &feedback, double max_speed=1);
   /**
    * Turn the robot in place to an exact heading relative to the field.
    * 0 is forward. Uses the defualt turn feedback of the drive system 
@@ -151,10 +266,50 @@ public:
   bool turn_to_heading(double heading_deg, double max_speed=1);
 
   /**
-   * Reset the initialization for autonomous drive functions
+   * Reset the initialization for the autonomous drive functions that don't take a drive_motion_t, and forget any speed
+   * handed off by a blended movement
    */
   void reset_auto();
 
+  /**
+   * Calculate how fast the robot can pass through a point on the way to the next one, for blending
+   * consecutive drive_to_point movements. The robot is assumed to be driving to `pt` from where it is now.
+   * Straight lines keep the full speed, and the speed drops off with the cosine of the corner angle,
+   * down to 0 for corners of 90 degrees or more.
+   * 
+   * @param pt the point the robot is driving to now
+   * @param next_pt the point the robot will drive to after that
+   * @param speed the speed (inches/second) to use for a straight line
+   * @return the speed (inches/second) to hand off to the next movement at `pt`
+   */
+  double corner_speed(point_t pt, point_t next_pt, double speed);
+
+  /**
+   * @param inches how far to drive
+   * @param dir the direction to drive
+   * @return the point drive_forward would drive to, starting from where the robot is now
+   */
+  point_t forward_target(double inches, directionType dir);
+
+  /**
+   * Where the robot will be when it reaches a point, driving straight to it from where it is now
+   * @param pt the point the robot is driving to
+   * @param dir the direction it is driving
+   * @return the point, with the heading the robot faces when it drives straight there
+   */
+  pose_t arrival_pose(point_t pt, directionType dir);
+
+  /**
+   * How much drive_arc_to_point slows its motion profile down, so the outside wheels, which travel further than
+   * the center of the robot, never need more than full power.
+   *
+   * @param feedback the motion profile the arc is driven with
+   * @param arc_angle the total change in heading along the arc (degrees)
+   * @param arc_length the length of the arc (inches)
+   * @return the fraction (0 -> 1.0) of the profile's max_v and accel the arc uses
+   */
+  double arc_speed_scale(MotionController &feedback, double arc_angle, double arc_length);
+
   /**
    * Create a curve for the inputs, so that drivers have more control at lower speeds.
    * Curves are exponential, with the default being squaring the inputs.
@@ -178,11 +333,18 @@ public:
    */
   bool pure_pursuit(std::vector<PurePursuit::hermite_point> path, directionType dir, double radius, double res, Feedback &feedback, double max_speed=1);
 
+  /**
+   * Follow a hermite curve using the pure pursuit algorithm, keeping the movement's state in `motion`
+   * @param motion the state of this movement. See drive_motion_t
+   * (the rest are the same as above)
+   * @return true when we reach the end of the path
+   */
+  bool pure_pursuit(drive_motion_t &motion, std::vector<PurePursuit::hermite_point> path, directionType dir, double radius, double res, Feedback &feedback, double max_speed=1);
+
 private:
   motor_group &left_motors; ///< left drive motors
   motor_group &right_motors; ///< right drive motors
 
-  PID correction_pid; ///< PID controller used to drive in as straight a line as possible
   Feedback *drive_default_feedback = NULL; ///< feedback to use to drive if none is specified
   Feedback *turn_default_feedback = NULL; ///< feedback to use to turn if none is specified
 
@@ -190,6 +352,5 @@ private:
 
   robot_specs_t &config; ///< configuration holding physical dimensions of the robot. see robot_specs_t for more information
 
-  bool func_initialized = false; ///< used to control initialization of autonomous driving. (you only wan't to set the target once, not every iteration that you're driving)
-  bool is_pure_pursuit = false; ///< true if we are driving with a pure pursuit system
+  drive_motion_t default_motion; ///< the movement used by the drive functions that aren't given a drive_motion_t
 };
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "vex.h"
+#include "../core/include/utils/logger.h"
+
+/**
+ * BatteryCompensation
+ *
+ * Motors commanded in volts really get a fraction of whatever the battery is putting out, so the same command
+ * makes the robot move slower as the battery sags over a match (12.8V fresh -> ~11V at the end). This also means
+ * feedforward constants (kS, kV, kA) tuned on a fresh battery are wrong on a tired one.
+ *
+ * BatteryCompensation samples the battery voltage at a fixed rate in a background task, low-pass filters it, and
+ * scales every voltage command so that the motors act as if the battery were always at the nominal voltage.
+ * All subsystems that command volts (TankDrive, Flywheel, Lift) pass their outputs through volts(), so
+ * feedforward terms are compensated along with everything else.
+ *
+ * Until start() is called, the scale is 1 and volts() does nothing.
+ */
+class BatteryCompensation
+{
+public:
+  /**
+   * Start sampling the battery in the background.
+   *
+   * @param battery       the brain's battery (Brain.Battery)
+   * @param nominal_volts the battery voltage that feedforward / tuning constants were found at
+   * @param filter_time   time constant (seconds) of the low-pass filter on the battery voltage
+   * @param period_ms     time between battery samples, in milliseconds
+   * @param logger        if not NULL, the filtered voltage and scale are logged here about once a second
+   */
+  static void start(vex::brain::battery &battery, double nominal_volts=12.0, double filter_time=0.5, int period_ms=20, Logger *logger=NULL);
+
+  /**
+   * Stop sampling the battery, and stop compensating outputs
+   */
+  static void stop();
+
+  /**
+   * @return the filtered battery voltage. the nominal voltage if we aren't sampling
+   */
+  static double get_voltage();
+
+  /**
+   * @return what voltage commands are multiplied by: nominal voltage / battery voltage
+   */
+  static double get_scale();
+
+  /**
+   * Compensate a voltage command for the current battery voltage
+   *
+   * @param volts the voltage we want the motor to act like it's getting, as if the battery were at nominal
+   * @return the voltage to command the motor with, limited to what the motors will accept (+/- 12V)
+   */
+  static double volts(double volts);
+
+  /**
+   * Convert a "percent" output (-1.0 -> 1.0) to a compensated voltage command
+   *
+   * @param pct the percentage of full power
+   * @return the voltage to command the motor with
+   */
+  static double percent_to_volts(double pct);
+
+private:
+  /**
+   * Background task that samples and filters the battery voltage
+   */
+  static int sample_task(void *);
+
+  static vex::brain::battery *battery; ///< the battery we are sampling. NULL if not started
+  static Logger *logger; ///< where to log the compensation. NULL for no logging
+  static vex::task *task; ///< the sampling task
+
+  static double nominal_volts; ///< the voltage outputs are compensated to
+  static double filter_time; ///< time constant of the low-pass filter, in seconds
+  static int period_ms; ///< time between samples, in milliseconds
+
+  static double filtered_volts; ///< the latest filtered battery voltage
+  static double scale; ///< the latest compensation scale
+};
@@ -6,11 +6,23 @@
 
 #pragma once
 
+#include <functional>
+#include <vector>
 #include "vex.h"
+#include "../core/include/utils/geometry.h"
+#include "../core/include/utils/command_structure/command_arena.h"
 
 class AutoCommand {
   public:
     static constexpr double default_timeout = 10.0;
+    static constexpr int default_period_ms = 20;
+    virtual ~AutoCommand() {}
+    /**
+     * Commands are allocated in the active CommandArena if there is one, or on the heap if not.
+     * See command_arena.h
+     */
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr);
     /**
      * Executes the command
      * Overridden by child classes
@@ -21,13 +33,95 @@ class AutoCommand {
      * What to do if we timeout instead of finishing. timeout is specified by the timeout seconds in the constructor
     */
     virtual void on_timeout(){}
+    /**
+     * Called exactly once whenever the command stops running, however it stopped. Clean up here (stop motors, etc.)
+     * By default, an interrupted command cleans up with on_timeout(), so commands that only clean up after a
+     * timeout get the same cleanup when they're cancelled or preempted.
+     * @param interrupted false if run() returned true. true if the command timed out, was cancelled, was preempted
+     *                    or its until() condition came true
+     */
+    virtual void end(bool interrupted) { if (interrupted) on_timeout(); }
+    /**
+     * Called by the CommandController right before this command starts, with the command that will run after it,
+     * if the controller is blending commands together. Commands that can carry their motion into the next command
+     * (like consecutive drive movements) override this to end at a non-zero speed. Does nothing by default.
+     * @param next the command that will run after this one
+     * @param speed the speed (inches/second) to carry through a straight line between the two commands
+     */
+    virtual void blend_into(AutoCommand &/*next*/, double /*speed*/){}
+    /**
+     * Commands that drive to a point report it here, so the command before them can blend into them.
+     * @param start where the command before this one will leave the robot, for commands that drive relative to it
+     * @param pt filled in with the point this command drives to
+     * @param dir filled in with the direction this command drives in
+     * @return true if this command drives to a point, false otherwise
+     */
+    virtual bool get_drive_target(const pose_t &/*start*/, point_t &/*pt*/, vex::directionType &/*dir*/){ return false; }
+    /**
+     * Called by the command before this one when it finishes still moving, because it was blended into this one.
+     * Commands that drive override this to start their movement at that speed. Does nothing by default.
+     * @param speed the speed (inches/second) the robot is still moving at
+     */
+    virtual void start_blended(double /*speed*/){}
+    /**
+     * Estimate how long this command takes without running it, to check a route against its time budget.
+     * @param pose the robot's predicted pose when the command starts. Commands that move the robot change it to
+     *             where they will end
+     * @return the estimated time in seconds, or -1 if this command can't tell
+     */
+    virtual double estimate_seconds(pose_t &/*pose*/){ return -1; }
+    /**
+     * When the CommandController should call run() next. By default, every period_ms on a fixed schedule.
+     * Commands that are waiting for a deadline override this, so the controller sleeps straight through to it.
+     * @param last_wake_ms the time (vex::timer::system()) run() was scheduled for last
+     * @return the time (vex::timer::system()) to call run() next
+     */
+    virtual uint32_t next_wake_ms(uint32_t last_wake_ms) { return last_wake_ms + period_ms; }
     AutoCommand* withTimeout(double t_seconds){
       this->timeout_seconds = t_seconds;
       return this;
     }
+    AutoCommand* withPeriod(int ms){
+      this->period_ms = ms;
+      return this;
+    }
+    /**
+     * Interrupt this command as soon as a condition comes true, e.g. a sensor seeing the roller is scored.
+     * The condition is checked after every run(), and the command ends with end(true)
+     * @param condition returns true when the command should stop
+     */
+    AutoCommand* until(std::function<bool(void)> condition){
+      this->interrupt_condition = condition;
+      return this;
+    }
+    /**
+     * Declare a subsystem this command drives. Commands that share a subsystem can't run at the same time
+     * @param subsystem the subsystem (e.g. &drive_sys). Only its address is used
+     */
+    AutoCommand* withRequirement(const void *subsystem){
+      this->requirements.push_back(subsystem);
+      return this;
+    }
+    /**
+     * @return true if this command has an until() condition and it is true
+     */
+    bool should_interrupt(){
+      return interrupt_condition && interrupt_condition();
+    }
+    /**
+     * @param other another command
+     * @return true if this command and other drive the same subsystem
+     */
+    bool conflicts_with(AutoCommand &other){
+      for (const void *mine : requirements)
+        for (const void *theirs : other.requirements)
+          if (mine == theirs)
+            return true;
+      return false;
+    }
     /** 
      * How long to run until we cancel this command. 
-     * If the command is cancelled, on_timeout() is called to allow any cleanup from the function. 
+     * If the command is cancelled, end(true) is called to allow any cleanup from the function. 
      * If the timeout_seconds <= 0, no timeout will be applied and this command will run forever
      * A timeout can come in handy for some commands that can not reach the end due to some physical limitation such as
      * - a drive command hitting a wall and not being able to reach its target
@@ -35,5 +129,18 @@ class AutoCommand {
      * - something else...
     */
     double timeout_seconds = default_timeout;
+    /**
+     * How often (milliseconds) run() is called while this command is running. Commands running a control loop
+     * want it short, commands waiting on a slow condition can make it longer to save CPU.
+     */
+    int period_ms = default_period_ms;
+    /**
+     * The subsystems this command drives, by address. Set by commands that drive a subsystem, or withRequirement()
+     */
+    std::vector<const void *> requirements;
+    /**
+     * Interrupts the command when it returns true. Empty if the command only stops by finishing or timing out
+     */
+    std::function<bool(void)> interrupt_condition;
 
 };
\ No newline at end of file
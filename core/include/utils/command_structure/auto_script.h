@@ -0,0 +1,167 @@
+/**
+ * File: auto_script.h
+ * Desc:
+ *    An AutoScript builds a CommandController from a text file on the SD card, so a route can be changed
+ *    without rebuilding the program. The robot code decides what commands exist (the verbs) and how to make
+ *    each one; the script decides their order, arguments and timeouts.
+ *
+ *    Script format, one command per line:
+ *
+ *      # comments start with #
+ *      drive_to 10 12 fwd @1.5     <- verb, then numbers or keywords, then an optional timeout in seconds
+ *      parallel @3                 <- parallel, race or deadline start a group (see command_groups.h)
+ *        spin_rpm 2900
+ *        drive 6 rev
+ *      end
+ *
+ *    Commas are treated as spaces. Once a script parses, it is saved next to the script as <filename>.bin,
+ *    and loaded from there as long as the script and the verbs haven't changed. The cache is only used without
+ *    the script if load() is asked to.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "../core/include/utils/command_structure/auto_command.h"
+#include "../core/include/utils/command_structure/command_controller.h"
+
+class AutoScript
+{
+public:
+  /**
+   * A command the script can use
+   */
+  struct verb_t
+  {
+    const char *name; ///< the word that starts the line
+    int min_args;     ///< the fewest arguments it takes
+    int max_args;     ///< the most arguments it takes, or -1 for no limit
+  };
+
+  /**
+   * A word that can be used in place of a number, like fwd or rev
+   */
+  struct keyword_t
+  {
+    const char *name;
+    float value;
+  };
+
+  /**
+   * Makes the command for one line of the script
+   * @param verb the index of the verb in the list given to the constructor
+   * @param args the arguments, with keywords replaced by their values
+   * @param argc the number of arguments
+   * @return the new command, or NULL if the arguments don't make sense for it
+   */
+  typedef AutoCommand *(*factory_t)(int verb, const float *args, int argc);
+
+  /**
+   * Create a script loader
+   * @param verbs the commands the script can use
+   * @param keywords the words that can be used in place of numbers
+   * @param factory makes the command for each line
+   */
+  AutoScript(std::vector<verb_t> verbs, std::vector<keyword_t> keywords, factory_t factory);
+
+  /**
+   * Load a script from the SD card, from its cache if it's up to date. Otherwise the script is parsed, and the
+   * cache is written for next time
+   * @param filename the script's file name
+   * @param allow_cache_only if true and the script is missing, run from its cache anyway. The cache can't be
+   *                         checked against anything, so it may be an old version of the route
+   * @return true if the script was loaded without errors
+   */
+  bool load(const std::string &filename, bool allow_cache_only = false);
+
+  /**
+   * Parse a script
+   * @param text the whole script
+   * @return true if it parsed without errors
+   */
+  bool parse(const std::string &text);
+
+  /**
+   * Make the script's commands and add them to a controller, in the controller's arena
+   * @param controller the controller to add to
+   * @return true if every command was made
+   */
+  bool build(CommandController &controller);
+
+  /**
+   * @return every error from the last load, parse or build, as "line N: what's wrong"
+   */
+  std::vector<std::string> get_errors();
+
+  /**
+   * @return true if the last load came from the cache instead of parsing the script
+   */
+  bool is_from_cache();
+
+  /**
+   * @return the number of lines the script compiled to (including group starts and ends)
+   */
+  int get_num_instructions();
+
+private:
+  // Verbs that start and end groups, stored as negative verb numbers
+  enum SpecialVerb
+  {
+    PARALLEL = -1,
+    RACE = -2,
+    DEADLINE = -3,
+    END = -4
+  };
+
+  /**
+   * One compiled line of the script. This is what the cache holds, so it's plain data
+   */
+  struct instruction_t
+  {
+    int16_t verb;       ///< index into verbs, or a SpecialVerb
+    uint16_t line;      ///< line in the script, for errors
+    uint16_t argc;      ///< number of arguments
+    uint16_t first_arg; ///< index of the first argument in args
+    float timeout;      ///< timeout in seconds, or -1 for the default
+  };
+
+  /**
+   * The start of the cache file
+   */
+  struct cache_header_t
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t verb_hash;   ///< hash of the verbs, so a cache from a different program isn't used
+    uint32_t source_hash; ///< hash of the script the cache was made from
+    uint32_t num_instructions;
+    uint32_t num_args;
+  };
+
+  /**
+   * Check that the instructions make sense: verbs and arguments in range, groups closed and not empty
+   */
+  bool validate();
+
+  /**
+   * Make the command for the instruction at i, and move i past it (and past the whole group, for groups)
+   */
+  AutoCommand *build_one(size_t &i);
+
+  bool load_cache(const std::string &data, bool check_source, uint32_t source_hash);
+  std::string make_cache(uint32_t source_hash);
+  uint32_t hash_verbs();
+
+  void error(int line, const char *fmt, ...);
+
+  std::vector<verb_t> verbs;
+  std::vector<keyword_t> keywords;
+  factory_t factory;
+
+  std::vector<instruction_t> instructions;
+  std::vector<float> args;
+  std::vector<std::string> errors;
+  bool from_cache = false;
+};
@@ -0,0 +1,115 @@
+/**
+ * File: command_arena.h
+ * Desc:
+ *    A CommandArena holds the AutoCommands of one autonomous route. Commands are packed into a few large blocks
+ *    instead of one heap allocation each, and are all freed together when the arena is released, so building
+ *    several routes at startup doesn't fragment the heap.
+ *
+ *    AutoCommand overrides operator new: while a CommandArena::Scope is alive, `new SomeCommand(...)` goes into
+ *    that scope's arena. Outside of any scope, commands are allocated on the heap as usual.
+ *
+ *    Usage example:
+ *    /code{.cpp}
+ *    CommandController route;
+ *    CommandArena::Scope arena_scope(route.get_arena());
+ *    route.add(new DriveForwardCommand(...)); // lives in route's arena, freed with route
+ *    /endcode
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+class AutoCommand;
+
+class CommandArena
+{
+public:
+  /**
+   * Makes an arena the one that new AutoCommands are allocated from, until the Scope is destroyed.
+   * Scopes can be nested; the previous arena is used again when the inner one ends.
+   * Scopes are not thread safe: only build routes from one task at a time, and end the scope before running
+   * the route it built.
+   */
+  class Scope
+  {
+  public:
+    Scope(CommandArena &arena);
+    ~Scope();
+
+  private:
+    CommandArena *prev;
+  };
+
+  /**
+   * Create an empty arena. No memory is reserved until the first command is allocated
+   * @param block_size how many bytes to reserve at a time
+   */
+  CommandArena(size_t block_size = 2048);
+
+  /**
+   * Destroy every command in the arena and free its memory
+   */
+  ~CommandArena();
+
+  /**
+   * Allocate memory for a command. Used by AutoCommand::operator new
+   * @param size the size of the command
+   * @return memory for the command, aligned for any type
+   */
+  void *allocate(size_t size);
+
+  /**
+   * Destroy every command in the arena and free its memory. The arena can be used again afterwards
+   */
+  void release();
+
+  /**
+   * @return the number of bytes taken by commands (including each command's bookkeeping)
+   */
+  size_t bytes_used();
+
+  /**
+   * @return the number of bytes reserved from the heap
+   */
+  size_t bytes_reserved();
+
+  /**
+   * @return the number of commands in the arena
+   */
+  int num_commands();
+
+  /**
+   * @return the arena new AutoCommands are allocated from right now, or NULL if they go on the heap
+   */
+  static CommandArena *get_active();
+
+private:
+  // Not copyable: the arena owns its blocks
+  CommandArena(const CommandArena &);
+  CommandArena &operator=(const CommandArena &);
+
+  friend class AutoCommand;
+
+  /**
+   * Bookkeeping stored in front of every command, arena or heap allocated
+   */
+  struct header_t
+  {
+    CommandArena *arena; ///< the arena the command is in, or NULL if it's on the heap
+    header_t *next;      ///< the command allocated before this one, in the same arena
+  };
+
+  static const size_t ALIGN = 8;
+  static const size_t HEADER_SIZE = (sizeof(header_t) + ALIGN - 1) & ~(ALIGN - 1);
+
+  size_t block_size;
+  std::vector<char *> blocks;
+  size_t block_used = 0;     ///< bytes used in the last block
+  size_t used = 0, reserved = 0;
+  int count = 0;
+  header_t *last = NULL;     ///< the last command allocated, for destroying them all
+
+  static CommandArena *active;
+};
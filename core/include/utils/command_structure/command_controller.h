@@ -10,15 +10,35 @@
 #pragma once
 #include <vector>
 #include <queue>
+#include <memory>
+#include <atomic>
 #include "../core/include/utils/command_structure/auto_command.h"
+#include "../core/include/utils/command_structure/command_arena.h"
+
+// How many commands run() records in its profile. The rest of a longer route runs, but isn't recorded
+#define PROFILE_MAX_RECORDS 64
 
 class CommandController
 {
 public:
+  /**
+   * How one command went, recorded by run()
+   */
+  struct command_record_t
+  {
+    uint32_t start_ms;    ///< when the command started, since the start of run()
+    uint32_t duration_ms; ///< how long the command took
+    int ticks;            ///< how many times run() was called
+    uint32_t run_us;      ///< time spent inside the command's run(), in microseconds
+    bool timed_out;       ///< true if the command was cut off by its timeout
+    bool interrupted;     ///< true if the command was cut off by its until() condition, cancel() or preempt()
+    float slack;          ///< seconds left on the timeout when the command ended. 0 if it had no timeout
+  };
+
   /**
    * Adds a command to the queue
    * @param cmd the AutoCommand we want to add to our list
-   * @param timeout_seconds the number of seconds we will let the command run for. If it exceeds this, we cancel it and run on_timeout. if it is <= 0 no time out will be applied
+   * @param timeout_seconds the number of seconds we will let the command run for. If it exceeds this, we cancel it and run end(true). if it is <= 0 no time out will be applied
    */
   void add(AutoCommand *cmd, double timeout_seconds = 10.0);
 
@@ -47,6 +67,39 @@ public:
    * Execute and remove commands in FIFO order
    */
   void run();
+
+  /**
+   * Stop the route from another task, e.g. when the driver takes over. The running command is ended with
+   * end(true), and the rest of the queue is thrown away. Does nothing if the route isn't running
+   */
+  void cancel();
+
+  /**
+   * Interrupt the running command from another task, and run a different one in its place. The running command
+   * is ended with end(true), then cmd runs, then the rest of the queue carries on.
+   * Does nothing if the route isn't running, or if another preempt() hasn't been picked up yet
+   * @param cmd the command to run in place of the current one
+   * @return true if cmd will run, false if it was refused
+   */
+  bool preempt(AutoCommand *cmd);
+
+  /**
+   * @return true while run() is running the queue
+   */
+  bool is_running();
+  /**
+   * Estimate how long the route takes without running it, by following the robot's predicted pose through each
+   * command. Prints the estimate for each command, and a warning if the route is over budget.
+   * Commands that can't be estimated are left out of the estimate and listed. The worst case, where every command
+   * with a timeout runs until it times out, is reported separately.
+   * @param start where the robot starts (an OdomSetPosition in the route replaces it)
+   * @param budget_seconds the time the route has, e.g. 15 for a match or 60 for skills. 0 to skip the check
+   * @param end filled in with where the robot is predicted to end up, if not NULL
+   * @param worst_case filled in with the worst case time in seconds, if not NULL
+   * @return the estimated time in seconds
+   */
+  double estimate(pose_t start, double budget_seconds = 0, pose_t *end = NULL, double *worst_case = NULL);
+
   /**
    * last_command_timed_out tells how the last command ended
    * Use this if you want to make decisions based on the end of the last command
@@ -54,7 +107,69 @@ public:
    */
   bool last_command_timed_out();
 
+  /**
+   * Blend consecutive drive commands together, so the robot carries its speed through the points
+   * between them instead of stopping at each one. Disabled by default.
+   * @param speed the speed (inches/second) to carry through a straight line between two commands. 0 disables blending
+   */
+  void set_blend_speed(double speed);
+
+  /**
+   * The arena this route's commands can be allocated in. It is freed when the last copy of this controller is
+   * destroyed, so the commands in it must not be used after that. See command_arena.h
+   * @return the arena for this route's commands
+   */
+  CommandArena &get_arena();
+
+  /**
+   * @return how each command went the last time run() was called, in order
+   */
+  std::vector<command_record_t> get_profile();
+
+  /**
+   * Copy the profile from the last run() without allocating, e.g. to hand it to another task
+   * @param out where to copy the records to
+   * @param max_records how many records fit in `out`
+   * @return how many records were copied
+   */
+  int copy_profile(command_record_t *out, int max_records);
+
+  /**
+   * Save the profile from the last run() to the SD card as a CSV, one row per command
+   * @param filename the name of the file to save to
+   * @return true if the file was saved, false if there's no SD card or nothing has been run
+   */
+  bool save_profile(const char *filename);
+
 private:
+  std::shared_ptr<CommandArena> arena = std::make_shared<CommandArena>();
   std::queue<AutoCommand *> command_queue;
   bool command_timed_out = false;
+  double blend_speed = 0;
+  // Fixed size, so recording never allocates while the route runs
+  command_record_t profile[PROFILE_MAX_RECORDS];
+  int profile_size = 0;
+  int profile_dropped = 0;
+
+  /**
+   * Requests from other tasks, shared between copies of the controller so they reach the copy that is running
+   */
+  struct signals_t
+  {
+    std::atomic<bool> running{false};
+    std::atomic<bool> cancel{false};
+    std::atomic<AutoCommand *> preempt{nullptr};
+  };
+  std::shared_ptr<signals_t> signals = std::make_shared<signals_t>();
+
+  /**
+   * @return true if cancel() or preempt() has been called since the current command started
+   */
+  bool interrupt_requested();
+
+  /**
+   * Sleep until a time, or until another task calls cancel() or preempt()
+   * @param wake_ms the time (vex::timer::system()) to sleep until
+   */
+  void sleep_until(uint32_t wake_ms);
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+/**
+ * File: command_groups.h
+ * Desc:
+ *    Command groups run several AutoCommands at once, as a single command in a CommandController.
+ *    Each child is run on its own period and timeout, in the same loop as the controller.
+ *
+ *    - ParallelGroup: finishes when every child has finished
+ *    - RaceGroup: finishes when any child finishes, and cancels the rest
+ *    - DeadlineGroup: finishes when the first child finishes, and cancels the rest
+ *
+ *    Every child has end() called when it stops: end(false) if it finished, end(true) if it timed out, its
+ *    until() condition came true, or the group cancelled it.
+ *
+ *    A group requires every subsystem its children do. Two children that require the same subsystem can't run
+ *    at the same time, so a group made with them is invalid: it prints an error when it is made and when it is
+ *    run, and ends right away without running any of its children.
+ */
+
+#pragma once
+
+#include <vector>
+#include "../core/include/utils/command_structure/auto_command.h"
+
+class CommandGroup : public AutoCommand
+{
+public:
+  /**
+   * Create a group of commands that run at the same time
+   * @param cmds the commands in the group. Their timeouts are kept, and apply from the start of the group.
+   *             If two of them require the same subsystem, the group is invalid and won't run. See is_valid()
+   */
+  CommandGroup(std::vector<AutoCommand *> cmds);
+
+  /**
+   * @return false if two of the group's commands require the same subsystem. An invalid group ends as soon as
+   *         it is run, without running any of its commands
+   */
+  bool is_valid();
+
+  /**
+   * Run every child that is due, and check if the group is finished
+   * Overrides run from AutoCommand
+   * @returns true when the group is finished, false otherwise
+   */
+  bool run() override;
+
+  /**
+   * Cancel every child that is still running
+   * Overrides end from AutoCommand
+   */
+  void end(bool interrupted) override;
+
+  /**
+   * Wake up when the next child is due
+   * Overrides next_wake_ms from AutoCommand
+   */
+  uint32_t next_wake_ms(uint32_t last_wake_ms) override;
+
+  /**
+   * Estimate each child (cut off at its timeout), and combine them the way the group finishes.
+   * The children are estimated in order, each starting from where the one before it left the robot
+   * Overrides estimate_seconds from AutoCommand
+   * @return the estimated time, or -1 if the group can't be estimated from its children
+   */
+  double estimate_seconds(pose_t &pose) override;
+
+protected:
+  /**
+   * A command in the group, and where it is in its schedule
+   */
+  struct child_t
+  {
+    AutoCommand *cmd;
+    bool running;
+    uint32_t start_ms, wake_ms;
+  };
+
+  /**
+   * Decide if the group is done, from which children are still running
+   * @return true if the group is finished. Any children still running are cancelled
+   */
+  virtual bool is_finished() = 0;
+
+  /**
+   * Combine the children's estimated times into the group's, the way the group finishes
+   * @param times the estimate for each child, in order. -1 for children that can't be estimated
+   */
+  virtual double combine_estimates(std::vector<double> &times) = 0;
+
+  std::vector<child_t> children;
+
+private:
+  /**
+   * Cancel every child that is still running
+   */
+  void cancel_running();
+
+  bool started = false;
+  bool valid = true;
+};
+
+/**
+ * Runs its commands at the same time, and finishes when all of them have
+ */
+class ParallelGroup : public CommandGroup
+{
+public:
+  ParallelGroup(std::vector<AutoCommand *> cmds) : CommandGroup(cmds) {}
+
+protected:
+  bool is_finished() override;
+  double combine_estimates(std::vector<double> &times) override;
+};
+
+/**
+ * Runs its commands at the same time, and finishes as soon as any of them does. The others are cancelled
+ */
+class RaceGroup : public CommandGroup
+{
+public:
+  RaceGroup(std::vector<AutoCommand *> cmds) : CommandGroup(cmds) {}
+
+protected:
+  bool is_finished() override;
+  double combine_estimates(std::vector<double> &times) override;
+};
+
+/**
+ * Runs its commands at the same time, and finishes when the first one (the deadline) does.
+ * The others are cancelled if they're still running.
+ */
+class DeadlineGroup : public CommandGroup
+{
+public:
+  /**
+   * Create a DeadlineGroup
+   * @param deadline the command that decides when the group is done
+   * @param others commands that run alongside the deadline
+   */
+  DeadlineGroup(AutoCommand *deadline, std::vector<AutoCommand *> others);
+
+protected:
+  bool is_finished() override;
+  double combine_estimates(std::vector<double> &times) override;
+};
@@ -18,16 +18,53 @@ class DelayCommand: public AutoCommand {
     DelayCommand(int ms): ms(ms) {}
     
     /**
-     * Delays for the amount of milliseconds stored in the command
+     * Starts the delay the first time it is run, and checks if it is over after that
      * Overrides run from AutoCommand
      * @returns true when complete
      */
     bool run() override {
-      vexDelay(ms);
+      uint32_t now = vex::timer::system();
+      if(!started)
+      {
+        started = true;
+        end_ms = now + ms;
+      }
+
+      if((int32_t)(now - end_ms) < 0)
+        return false;
+
+      // Ready to be run again, if the route is
+      started = false;
       return true;
     }
 
+    /**
+     * Reset the delay if it was cut short, so it starts over if it's run again
+     * Overrides end from AutoCommand
+     */
+    void end(bool /*interrupted*/) override {
+      started = false;
+    }
+
+    /**
+     * Sleep until the delay is over, instead of waking up every period
+     * Overrides next_wake_ms from AutoCommand
+     */
+    uint32_t next_wake_ms(uint32_t /*last_wake_ms*/) override {
+      return end_ms;
+    }
+
+    /**
+     * A delay takes as long as it's set for
+     * Overrides estimate_seconds from AutoCommand
+     */
+    double estimate_seconds(pose_t &/*pose*/) override {
+      return ms / 1000.0;
+    }
+
   private:
     // amount of milliseconds to wait
     int ms;
+    bool started = false;
+    uint32_t end_ms = 0;
 };
\ No newline at end of file
@@ -7,6 +7,7 @@
  *      - drive_forward
  *      - turn_degrees
  *      - drive_to_point
+ *      - drive_arc_to_point
  *      - turn_to_heading
  *      - stop
  *
@@ -22,6 +23,7 @@
 #include "../core/include/utils/geometry.h"
 #include "../core/include/utils/command_structure/auto_command.h"
 #include "../core/include/subsystems/tank_drive.h"
+#include "../core/include/utils/motion_controller.h"
 
 using namespace vex;
 
@@ -43,15 +45,43 @@ class DriveForwardCommand: public AutoCommand {
      * @returns true when execution is complete, false otherwise
      */
     bool run() override;
+
+    /**
+     * Estimate how long the command takes, and move the predicted pose to where it ends
+     * Overrides estimate_seconds from AutoCommand
+     */
+    double estimate_seconds(pose_t &pose) override;
     /**
      * Cleans up drive system if we time out before finishing
     */
     void on_timeout() override;
 
+    /**
+     * Plan to carry our speed into the next command, if it drives to a point in the same direction
+     * Overrides blend_into from AutoCommand
+     */
+    void blend_into(AutoCommand &next, double speed) override;
+
+    /**
+     * Start our movement at the speed the command before us finished at
+     * Overrides start_blended from AutoCommand
+     */
+    void start_blended(double speed) override;
+
+    /**
+     * Report the point we'll drive to from `start`, so the command before us can blend into us
+     * Overrides get_drive_target from AutoCommand
+     * @returns true
+     */
+    bool get_drive_target(const pose_t &start, point_t &pt, directionType &dir) override;
+
   private:
     // drive system to run the function on
     TankDrive &drive_sys;
 
+    // this command's own movement, so it doesn't share progress with any other
+    TankDrive::drive_motion_t motion;
+
     // feedback controller to use
     Feedback &feedback;
 
@@ -59,6 +89,11 @@ class DriveForwardCommand: public AutoCommand {
     double inches;
     directionType dir;
     double max_speed;
+
+    // blending into the next command
+    AutoCommand *next = NULL;
+    double blend_speed = 0;
+    double end_speed = 0;
 };
 
 /**
@@ -75,6 +110,12 @@ class TurnDegreesCommand: public AutoCommand {
      * @returns true when execution is complete, false otherwise
      */
     bool run() override;
+
+    /**
+     * Estimate how long the command takes, and move the predicted pose to where it ends
+     * Overrides estimate_seconds from AutoCommand
+     */
+    double estimate_seconds(pose_t &pose) override;
     /**
      * Cleans up drive system if we time out before finishing
     */
@@ -84,6 +125,9 @@ class TurnDegreesCommand: public AutoCommand {
   private:
     // drive system to run the function on
     TankDrive &drive_sys;
+
+    // this command's own movement, so it doesn't share progress with any other
+    TankDrive::drive_motion_t motion;
     
     // feedback controller to use
     Feedback &feedback;
@@ -109,9 +153,37 @@ class DriveToPointCommand: public AutoCommand {
      */
     bool run() override;
 
+    /**
+     * Estimate how long the command takes, and move the predicted pose to where it ends
+     * Overrides estimate_seconds from AutoCommand
+     */
+    double estimate_seconds(pose_t &pose) override;
+
+    /**
+     * Plan to carry our speed into the next command, if it drives to a point in the same direction
+     * Overrides blend_into from AutoCommand
+     */
+    void blend_into(AutoCommand &next, double speed) override;
+
+    /**
+     * Start our movement at the speed the command before us finished at
+     * Overrides start_blended from AutoCommand
+     */
+    void start_blended(double speed) override;
+
+    /**
+     * Report the point we're driving to, so the command before us can blend into us
+     * Overrides get_drive_target from AutoCommand
+     * @returns true
+     */
+    bool get_drive_target(const pose_t &start, point_t &pt, directionType &dir) override;
+
   private:
     // drive system to run the function on
     TankDrive &drive_sys;
+
+    // this command's own movement, so it doesn't share progress with any other
+    TankDrive::drive_motion_t motion;
     
     /**
      * Cleans up drive system if we time out before finishing
@@ -127,9 +199,55 @@ class DriveToPointCommand: public AutoCommand {
     double y;
     directionType dir;
     double max_speed;
+
+    // blending into the next command
+    AutoCommand *next = NULL;
+    double blend_speed = 0;
+    double end_speed = 0;
     
 };
 
+/**
+ * AutoCommand wrapper class for the drive_arc_to_point function in the
+ * TankDrive class
+ */
+class DriveArcToPointCommand: public AutoCommand {
+  public:
+    DriveArcToPointCommand(TankDrive &drive_sys, MotionController &feedback, point_t point, directionType dir, double max_speed=1);
+
+    /**
+     * Run drive_arc_to_point
+     * Overrides run from AutoCommand
+     * @returns true when execution is complete, false otherwise
+     */
+    bool run() override;
+
+    /**
+     * Estimate how long the command takes, and move the predicted pose to where it ends
+     * Overrides estimate_seconds from AutoCommand
+     */
+    double estimate_seconds(pose_t &pose) override;
+    /**
+     * Cleans up drive system if we time out before finishing
+    */
+    void on_timeout() override;
+
+  private:
+    // drive system to run the function on
+    TankDrive &drive_sys;
+
+    // this command's own movement, so it doesn't share progress with any other
+    TankDrive::drive_motion_t motion;
+
+    // motion profile to use
+    MotionController &feedback;
+
+    // parameters for drive_arc_to_point
+    point_t point;
+    directionType dir;
+    double max_speed;
+};
+
 /**
  * AutoCommand wrapper class for the turn_to_heading() function in the 
  * TankDrive class
@@ -145,6 +263,12 @@ class TurnToHeadingCommand: public AutoCommand {
      * @returns true when execution is complete, false otherwise
      */
     bool run() override;
+
+    /**
+     * Estimate how long the command takes, and move the predicted pose to where it ends
+     * Overrides estimate_seconds from AutoCommand
+     */
+    double estimate_seconds(pose_t &pose) override;
     /**
      * Cleans up drive system if we time out before finishing
     */
@@ -155,6 +279,9 @@ class TurnToHeadingCommand: public AutoCommand {
     // drive system to run the function on
     TankDrive &drive_sys;
 
+    // this command's own movement, so it doesn't share progress with any other
+    TankDrive::drive_motion_t motion;
+
     // feedback controller to use
     Feedback &feedback;
 
@@ -177,6 +304,12 @@ class DriveStopCommand: public AutoCommand {
      * @returns true when execution is complete, false otherwise
      */
     bool run() override;
+
+    /**
+     * Estimate how long the command takes, and move the predicted pose to where it ends
+     * Overrides estimate_seconds from AutoCommand
+     */
+    double estimate_seconds(pose_t &pose) override;
     void on_timeout() override;
 
   private:
@@ -207,6 +340,12 @@ class OdomSetPosition: public AutoCommand {
      */
     bool run() override;
 
+    /**
+     * Estimate how long the command takes, and move the predicted pose to where it ends
+     * Overrides estimate_seconds from AutoCommand
+     */
+    double estimate_seconds(pose_t &pose) override;
+
   private:
     // drive system with an odometry config
     OdometryBase &odom;
@@ -8,6 +8,8 @@
 
 #include "../core/include/subsystems/flywheel.h"
 #include "../core/include/utils/command_structure/auto_command.h"
+#include "../core/include/subsystems/odometry/odometry_base.h"
+#include "../core/include/utils/rpm_table.h"
 
 /**
  * AutoCommand wrapper class for the spinRPM function
@@ -30,6 +32,12 @@ class SpinRPMCommand: public AutoCommand {
      */
     bool run() override;
 
+    /**
+     * Setting the RPM is instant (waiting for it is a WaitUntilUpToSpeedCommand)
+     * Overrides estimate_seconds from AutoCommand
+     */
+    double estimate_seconds(pose_t &pose) override;
+
   private:
     // Flywheel instance to run the function on
     Flywheel &flywheel;
@@ -38,6 +46,46 @@ class SpinRPMCommand: public AutoCommand {
     int rpm;
 };
 
+/**
+ * AutoCommand that starts the flywheel tracking the RPM for the robot's distance to the goal.
+ * Finishes right away, and the flywheel keeps adjusting its RPM while the robot drives, until the next
+ * SpinRPMCommand or stop.
+ */
+class TrackGoalRPMCommand: public AutoCommand {
+  public:
+    /**
+     * Create a TrackGoalRPMCommand
+     * @param flywheel the flywheel system we are commanding
+     * @param odom     the odometry to find the distance to the goal with
+     * @param table    the RPM for each distance
+     * @param goal     where the goal is on the field
+     */
+    TrackGoalRPMCommand(Flywheel &flywheel, OdometryBase &odom, RPMTable &table, point_t goal);
+
+    /**
+     * Create a TrackGoalRPMCommand that looks up its table and goal while it runs, for when they can change
+     * between building the route and running it (e.g. the flap or the alliance color)
+     * @param flywheel the flywheel system we are commanding
+     * @param odom     the odometry to find the distance to the goal with
+     * @param table    returns the RPM for each distance
+     * @param goal     returns where the goal is on the field
+     */
+    TrackGoalRPMCommand(Flywheel &flywheel, OdometryBase &odom, std::function<RPMTable &(void)> table, std::function<point_t(void)> goal);
+
+    /**
+     * Start tracking the goal
+     * Overrides run from AutoCommand
+     * @returns true when execution is complete, false otherwise
+     */
+    bool run() override;
+
+  private:
+    Flywheel &flywheel;
+    OdometryBase &odom;
+    std::function<RPMTable &(void)> table;
+    std::function<point_t(void)> goal;
+};
+
 /**
  * AutoCommand that listens to the Flywheel and waits until it is at its target speed +/- the specified threshold
  *
@@ -66,6 +114,60 @@ class WaitUntilUpToSpeedCommand: public AutoCommand {
     int threshold_rpm;
 };
 
+/**
+ * AutoCommand that listens to the Flywheel and waits for the shot that was just fired to be detected, and for the
+ * flywheel to recover from it. The disc is usually fed while the shoot command before this one is still running, so a
+ * shot detected up to shot_window_ms before the wait starts counts as the one we're waiting on. It always waits at
+ * least min_wait_ms, so a shot that hasn't been detected yet (the disc hasn't reached the wheel, or the RPM filter
+ * lags) still gets a pause. Give it a timeout as the upper limit, for shots that are never detected. Shot detection
+ * must be set up with setShotDetection
+ */
+class WaitUntilRecoveredCommand: public AutoCommand {
+  public:
+    /**
+     * Create a WaitUntilRecoveredCommand
+     * @param flywheel the flywheel system we are commanding
+     * @param min_wait_ms the least time to wait, even if the flywheel recovers sooner
+     * @param shot_window_ms how long before the wait a shot can be detected and still count, usually as long as the
+     *    shoot command before it runs
+     */
+    WaitUntilRecoveredCommand(Flywheel &flywheel, int min_wait_ms, int shot_window_ms);
+
+    /**
+     * Check if a new shot has been detected and the flywheel has recovered from it
+     * Overrides run from AutoCommand
+     * @returns true when execution is complete, false otherwise
+     */
+    bool run() override;
+
+    /**
+     * Start over the next time we're run
+     * Overrides end from AutoCommand
+     */
+    void end(bool interrupted) override;
+
+    /**
+     * Estimate the wait as the minimum, or the flywheel's average recovery time if that's longer
+     * Overrides estimate_seconds from AutoCommand
+     */
+    double estimate_seconds(pose_t &pose) override;
+
+  private:
+    // Flywheel instance to run the function on
+    Flywheel &flywheel;
+
+    // the least time to wait
+    int min_wait_ms;
+
+    // how long before the wait a shot still counts
+    int shot_window_ms;
+
+    // when we started waiting, and how many shots had been detected then
+    bool started = false;
+    uint32_t start_ms = 0;
+    int start_shot_count = 0;
+};
+
 /**
  * AutoCommand wrapper class for the stop function
  * in the Flywheel class
@@ -0,0 +1,67 @@
+/**
+ * File: lift_commands.h
+ * Desc:
+ *    AutoCommand wrappers for the Lift class. Lift is a template, so these are too.
+ */
+
+#pragma once
+
+#include "../core/include/subsystems/lift.h"
+#include "../core/include/utils/command_structure/auto_command.h"
+
+/**
+ * AutoCommand that starts homing the lift in the background, and finishes right away.
+ * Pair it with a WaitUntilHomedCommand later in the path, so the robot can drive while the lift homes.
+ */
+template <typename T>
+class LiftStartHomingCommand: public AutoCommand {
+  public:
+    /**
+     * Create a LiftStartHomingCommand
+     * @param lift the lift to home
+     */
+    LiftStartHomingCommand(Lift<T> &lift): lift(lift) { requirements.push_back(&lift); }
+
+    /**
+     * Start homing the lift
+     * Overrides run from AutoCommand
+     * @returns true, since homing continues in the lift's task
+     */
+    bool run() override
+    {
+      lift.start_homing();
+      return true;
+    }
+
+  private:
+    // Lift instance to run the function on
+    Lift<T> &lift;
+};
+
+/**
+ * AutoCommand that waits until the lift is done homing.
+ * Finishes right away if the lift isn't homing.
+ */
+template <typename T>
+class WaitUntilHomedCommand: public AutoCommand {
+  public:
+    /**
+     * Create a WaitUntilHomedCommand
+     * @param lift the lift to wait on
+     */
+    WaitUntilHomedCommand(Lift<T> &lift): lift(lift) {}
+
+    /**
+     * Check if the lift is done homing
+     * Overrides run from AutoCommand
+     * @returns true when homing is complete (or timed out), false otherwise
+     */
+    bool run() override
+    {
+      return lift.get_homing_state() != Lift<T>::HOMING;
+    }
+
+  private:
+    // Lift instance to run the function on
+    Lift<T> &lift;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "vex.h"
+
+/**
+ * ControlLoop
+ *
+ * The parts of a control loop task that don't depend on what it controls: keeping the ticks on a fixed schedule,
+ * and measuring how much CPU time each one takes. Flywheel and PolicyFlywheel both run their loops with these,
+ * so the two are scheduled and measured the same way.
+ *
+ * Usage example:
+ * /code{.cpp}
+ * uint32_t next_tick = timer::system();
+ * while (true)
+ * {
+ *   uint64_t start_us = ControlLoop::start_tick();
+ *   // ... read the sensors, update the controller, set the motors
+ *   ControlLoop::end_tick(stats, start_us, period_ms);
+ *   ControlLoop::wait_for_next_tick(next_tick, period_ms);
+ * }
+ * /endcode
+ */
+class ControlLoop
+{
+  public:
+
+  /**
+   * How long the control loop takes to run, measured every tick
+   */
+  struct tick_stats_t
+  {
+    uint32_t last_us;  ///< CPU time of the last tick, in microseconds
+    double avg_us;     ///< average CPU time per tick, in microseconds
+    uint32_t max_us;   ///< the longest tick since the stats were reset, in microseconds
+    uint32_t overruns; ///< how many ticks took longer than the control period
+    uint32_t ticks;    ///< how many ticks the stats cover
+  };
+
+  /**
+   * Start timing a tick
+   * @return the time the tick started, for end_tick()
+   */
+  static uint64_t start_tick();
+
+  /**
+   * Finish timing a tick, and add it to the stats
+   * @param stats the stats to add the tick to
+   * @param start_us what start_tick() returned
+   * @param period_ms how often the loop runs. A tick that takes longer counts as an overrun
+   */
+  static void end_tick(tick_stats_t &stats, uint64_t start_us, int period_ms);
+
+  /**
+   * Wait until the next tick is due, instead of a fixed delay after this one, so the rate doesn't drift.
+   * If the loop fell behind, it waits 1ms and starts the schedule over, instead of catching up with a burst of ticks
+   * @param next_tick when this tick was due (timer::system()). Changed to when the next one is due
+   * @param period_ms how often the loop runs
+   */
+  static void wait_for_next_tick(uint32_t &next_tick, int period_ms);
+};
@@ -25,6 +25,20 @@ public:
      */
     virtual void init(double start_pt, double set_pt) = 0;
 
+    /**
+     * Initialize the feedback controller for a movement that doesn't start or end at rest.
+     * Controllers that don't plan a velocity ignore start_vel and end_vel.
+     *
+     * @param start_pt the current sensor value
+     * @param set_pt where the sensor value should be
+     * @param start_vel the velocity the system is already moving at
+     * @param end_vel the velocity the system should be moving at when it reaches set_pt
+     */
+    virtual void init(double start_pt, double set_pt, double /*start_vel*/, double /*end_vel*/)
+    {
+        init(start_pt, set_pt);
+    }
+
     /**
      * Iterate the feedback loop once with an updated sensor value
      *
@@ -51,6 +65,19 @@ public:
      */
     virtual bool is_on_target() = 0;
 
+    /**
+     * Estimate how long a movement takes, without running it. Used to check autonomous routes against their
+     * time budget.
+     *
+     * @param start_pt where the movement starts
+     * @param set_pt where the movement ends
+     * @return the time in seconds, or -1 if this controller can't tell
+     */
+    virtual double estimate_time(double /*start_pt*/, double /*set_pt*/)
+    {
+        return -1;
+    }
+
     virtual Feedback::FeedbackType get_type()
     {
         return FeedbackType::OtherType;
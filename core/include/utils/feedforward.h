@@ -57,13 +57,15 @@ class FeedForward
      * @brief Perform the feedforward calculation
      * 
      * This calculation is the equation:
-     * F = kG + kS*sgn(v) + kV*v + kA*a
+     * F = kG*kg_scale + kS*sgn(v) + kV*v + kA*a
      * 
      * @param v Requested velocity of system
      * @param a Requested acceleration of system
+     * @param pid_ref Direction to apply kS in when v is 0, usually the PID output
+     * @param kg_scale Multiplies kG, e.g. cos(angle) for an arm, where gravity pulls less as it rises
      * @return A feedforward that should closely represent the system if tuned correctly
      */
-    double calculate(double v, double a, double pid_ref=0.0)
+    double calculate(double v, double a, double pid_ref=0.0, double kg_scale=1.0)
     {
         double ks_sign = 0;
         if(v != 0)
@@ -71,7 +73,7 @@ class FeedForward
         else if(pid_ref != 0)
             ks_sign = sign(pid_ref);
         
-        return (cfg.kS * ks_sign) + (cfg.kV * v) + (cfg.kA * a) + cfg.kG;
+        return (cfg.kS * ks_sign) + (cfg.kV * v) + (cfg.kA * a) + (cfg.kG * kg_scale);
     }
 
     private:
@@ -83,9 +85,10 @@ class FeedForward
 
 /**
 * tune_feedforward takes a group of motors and finds the feedforward conifg parameters automagically.
+* Runs quasistatic and dynamic tests in both directions, and fits kS, kV and kA to the data with least squares (see SysId).
 *  @param motor the motor group to use 
 *  @param pct Maximum velocity in percent (0->1.0)
- * @param duration Amount of time the motors spin for the test
+ * @param duration Amount of time the motors spin for each test
  * @return A tuned feedforward object
  */
 FeedForward::ff_config_t tune_feedforward(vex::motor_group &motor, double pct, double duration);
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <queue>
 #include <map>
+#include <atomic>
 #include "vex.h"
 #include <functional>
 
@@ -10,11 +11,29 @@ typedef std::function<bool(void)> state_ptr;
 /**
  * GenericAuto provides a pleasant interface for organizing an auto path
  * steps of the path can be added with add() and when ready, calling run() will begin executing the path
+ *
+ * Async states run alongside the path on a small pool of worker tasks that every GenericAuto shares, instead of a
+ * new task each. Each GenericAuto keeps its async states (by value) in a fixed set of slots, and join points
+ * added with add_join() hold the path until they're done.
 */
 class GenericAuto
 {
   public:
 
+  static constexpr int MAX_ASYNC = 8; ///< how many async states one GenericAuto can hold
+
+  GenericAuto() {}
+
+  /**
+   * Stop any async states that are still running. Waits for the call they're in to return, so nothing is
+   * left running a state that no longer exists.
+   */
+  ~GenericAuto();
+
+  // Async states are run by pointer from the worker tasks, so a GenericAuto can't be copied
+  GenericAuto(const GenericAuto &) = delete;
+  GenericAuto &operator=(const GenericAuto &) = delete;
+
   /**
   * The method that runs the autonomous. If 'blocking' is true, then
   * this method will run through every state until it finished.
@@ -37,10 +56,24 @@ class GenericAuto
   void add(state_ptr new_state);
 
   /**
-   * Add a new state to the autonomous via function point of type "bool (ptr*)()" that will run asynchronously
-   * @param async_state the function to run
+   * Add a new state to the autonomous via function point of type "bool (ptr*)()" that will run asynchronously.
+   * When the path reaches it, it is handed to a worker task, which calls it every 20ms until it returns true.
+   * The path moves on right away. If every worker is busy, it waits in line for one.
+   * @param async_state the function to run. It is copied, so it can safely capture locals by value
+   * @return an id for add_join(), or -1 if there were already MAX_ASYNC async states. The state is not added
+   */
+  int add_async(state_ptr async_state);
+
+  /**
+   * Add a point where the path waits for every async state added before it to finish
    */
-  void add_async(state_ptr async_state);
+  void add_join();
+
+  /**
+   * Add a point where the path waits for one async state to finish
+   * @param async_id the id add_async() returned
+   */
+  void add_join(int async_id);
 
   /**
    * add_delay adds a period where the auto system will simply wait for the specified time
@@ -50,6 +83,46 @@ class GenericAuto
 
   private:
 
+  /**
+   * Where an async state is
+   */
+  enum AsyncStatus
+  {
+    ASYNC_IDLE,    ///< the path hasn't reached it yet
+    ASYNC_QUEUED,  ///< waiting for a worker
+    ASYNC_RUNNING, ///< a worker is running it
+    ASYNC_DONE     ///< finished, or cancelled
+  };
+
+  /**
+   * An async state, kept in a slot of the GenericAuto that added it
+   */
+  struct async_slot_t
+  {
+    state_ptr fn;
+    std::atomic<int> status{ASYNC_IDLE};
+    std::atomic<bool> cancelled{false};
+  };
+
+  /**
+   * @return true if the async state is waiting for a worker or being run by one
+   */
+  bool async_busy(int async_id);
+
+  /**
+   * Hand an async state to the workers, starting them if they haven't been yet
+   * @return false if the line for the workers is full. Try again later
+   */
+  static bool submit(async_slot_t *slot);
+
+  /**
+   * The worker tasks: take the next async state in line, and run it until it finishes or is cancelled
+   */
+  static int worker_main(void *);
+
   std::queue<state_ptr> state_list;
 
+  async_slot_t async_slots[MAX_ASYNC];
+  int num_async = 0;
+
 };
@@ -55,6 +55,14 @@ class MotionController : public Feedback
      * This will also reset the PID and profile timers.
      */
     void init(double start_pt, double end_pt) override;
+
+    /**
+     * @brief Initialize the motion profile for a new movement that doesn't start or end at rest.
+     * This will also reset the PID and profile timers.
+     * If end_vel is not 0, the movement is on target as soon as the profile finishes,
+     * so the next movement can pick up the velocity without stopping.
+     */
+    void init(double start_pt, double end_pt, double start_vel, double end_vel) override;
     
     /**
      * @brief Update the motion profile with a new sensor value
@@ -90,25 +98,56 @@ class MotionController : public Feedback
     motion_t get_motion();
 
     /**
-     * This method attempts to characterize the robot's drivetrain and automatically tune the feedforward.
-     * It does this by first calculating the kS (voltage to overcome static friction) by slowly increasing
-     * the voltage until it moves.
+     * @return how long a movement takes, in seconds: the motion profile, then on_target_time for the PID to settle
+     */
+    double estimate_time(double start_pt, double set_pt) override;
+
+    /**
+     * @return the most output the feedforward asks for in a movement: at max_v, while still accelerating
+     */
+    double peak_ff_output();
+
+    /**
+     * Scale down the maximum velocity and acceleration of the next movement (the next call to init()).
+     * Used to leave headroom when another axis is sharing the same motors, such as turning while driving.
+     * Only applies to one movement, after which the limits go back to the configured values.
      * 
-     * Next is kV (voltage to sustain a certain velocity), where the robot will record it's steady-state velocity
-     * at 'pct' speed.
+     * @param scale the fraction (0 -> 1.0) of max_v and accel to use
+     */
+    void scale_next_movement(double scale);
+
+    /**
+     * This method attempts to characterize the robot's drivetrain and automatically tune the feedforward.
+     * It does this by running quasistatic tests (slowly ramping up the voltage, so acceleration is ~0) and
+     * dynamic tests (stepping straight to 'pct', so the robot accelerates hard), both forwards and backwards.
      * 
-     * Finally, kA (voltage needed to accelerate by a certain rate), where the robot will record the entire movement's
-     * velocity and acceleration, record a plot of [X=(pct-kV*V-kS), Y=(Acceleration)] along the movement,
-     * and since kA*Accel = pct-kV*V-kS, the reciprocal of the linear regression is the kA value.
+     * kS, kV and kA are then found together with a least squares fit of
+     * pct = kS*sgn(v) + kV*v + kA*a
+     * across all the data. The quality of the fit (R^2 and residuals) is printed, see SysId.
      * 
      * @param drive The tankdrive to operate on
      * @param odometry The robot's odometry subsystem
      * @param pct Maximum velocity in percent (0->1.0)
-     * @param duration Amount of time the robot should be moving for the test
+     * @param duration Amount of time the robot should be moving for each test
      * @return A tuned feedforward object
      */
     static FeedForward::ff_config_t tune_feedforward(TankDrive &drive, OdometryTank &odometry, double pct=0.6, double duration=2);
 
+    /**
+     * Characterize the robot's drivetrain while turning in place, the same way as tune_feedforward().
+     * Angular velocity comes straight from the IMU's gyro rate, instead of being differentiated from odometry.
+     * 
+     * The constants are in percent per degree/second (kV) and percent per degree/second^2 (kA), for use with
+     * a MotionController whose max_v and accel are in degrees, passed to TankDrive::turn_to_heading()
+     * 
+     * @param drive The tankdrive to operate on
+     * @param imu The robot's inertial sensor
+     * @param pct Maximum turning speed in percent (0->1.0)
+     * @param duration Amount of time the robot should be turning for each test
+     * @return A tuned feedforward object
+     */
+    static FeedForward::ff_config_t tune_feedforward_angular(TankDrive &drive, vex::inertial &imu, double pct=0.5, double duration=2);
+
     private: 
 
     m_profile_cfg_t config;
@@ -119,6 +158,8 @@ class MotionController : public Feedback
 
     double lower_limit = 0, upper_limit = 0;
     double out = 0;
+    bool is_blended = false; ///< true if the current movement ends at a non-zero velocity
+    double limit_scale = 1; ///< fraction of max_v and accel to use for the next movement
     motion_t cur_motion;
      
     vex::timer tmr;
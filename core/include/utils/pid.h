@@ -14,6 +14,10 @@ using namespace vex;
  * 
  * out = kP*error + kI*integral(d Error) + kD*(dError/dt)
  * 
+ * Optionally, the derivative can be low-pass filtered and taken from the sensor reading instead of the error
+ * (so jumps in the setpoint don't "kick" the output), and the integral can be unwound with back-calculation
+ * when the output is saturated. See pid_config_t.
+ * 
  * The PID object will determine it is "on target" when the error is within the deadband, for
  * a duration of on_target_time
  * 
@@ -30,12 +34,26 @@ public:
     LINEAR,
     ANGULAR // assumes degrees
   };
+
+  /**
+   * An enum to choose what the derivative term is taken from.
+   */
+  enum DERIV_TYPE{
+    ERROR_DERIV, // d(error)/dt - reacts to changes in the setpoint
+    MEASUREMENT_DERIV // -d(sensor)/dt - ignores changes in the setpoint
+  };
   /**
    * pid_config_t holds the configuration parameters for a pid controller
    * In addtion to the constant of proportional, integral and derivative, these parameters include: 
    * - deadband - 
    * - on_target_time - for how long do we have to be at the target to stop
    * As well, pid_config_t holds an error type which determines whether errors should be calculated as if the sensor position is a measure of distance or an angle
+   * 
+   * The remaining parameters are optional, and leaving them as 0 gives a plain PID controller:
+   * - d_filter_time - time constant of a first order low-pass filter on the derivative term
+   * - deriv_method - whether to take the derivative of the error or of the measurement
+   * - windup_gain - back-calculation anti-windup gain. 0 only integrates while the output is inside the limits
+   * - fixed_dt - loop period to use instead of timing the calls to update(), for loops run on a fixed schedule
   */
   struct pid_config_t
   {
@@ -45,6 +63,10 @@ public:
     double deadband; ///< at what threshold are we close enough to be finished
     double on_target_time; ///< the time in seconds that we have to be on target for to say we are officially at the target
     ERROR_TYPE error_method; ///< Linear or angular. wheter to do error as a simple subtraction or to wrap
+    double d_filter_time; ///< time constant (seconds) of the low-pass filter on the derivative. 0 = no filtering
+    DERIV_TYPE deriv_method; ///< take the derivative of the error, or of the measurement (no "derivative kick" on setpoint changes)
+    double windup_gain; ///< back-calculation gain. each second, unwinds the integral by windup_gain * (saturated out - unsaturated out)
+    double fixed_dt; ///< if not 0, the time (seconds) between update() calls. otherwise it is measured
   };
 
   
@@ -123,8 +145,17 @@ public:
 
 private:
 
+  /**
+   * Calculate the error for a given sensor reading, against the current target
+   * @param sensor_val the sensor reading
+   * @return the error. how it is calculated depends on error_method specified in pid_config_t
+   */
+  double error_at(double sensor_val);
 
   double last_error = 0;  ///< the error measured on the last iteration of update()
+  double last_sensor_val = 0; ///< the sensor reading from the last iteration of update()
+  double d_filtered = 0; ///< the low-pass filtered derivative from the last iteration of update()
+  bool has_last = false; ///< true if update() has been called since reset(), so there is something to take a derivative from
   double accum_error = 0; ///< the integral of error over time since we called init()
   
   double last_time = 0; ///< the time measured the last time update() was called
@@ -2,6 +2,7 @@
 #include "../core/include/utils/feedback_base.h"
 #include "../core/include/utils/pid.h"
 #include "../core/include/utils/feedforward.h"
+#include "../core/include/utils/trapezoid_profile.h"
 
 class PIDFF : public Feedback
 {
@@ -60,6 +61,21 @@ class PIDFF : public Feedback
      */
     bool is_on_target() override;
 
+    /**
+     * Give the controller a rough idea of how fast it moves, so its movements can be estimated.
+     * A PID has no profile of its own, so without this estimate_time() can't tell.
+     * 
+     * @param max_v the typical top speed of a movement (units per second)
+     * @param accel the typical acceleration (units per second^2)
+     */
+    void set_estimate_rate(double max_v, double accel);
+
+    /**
+     * @return how long a movement takes at the rate from set_estimate_rate(), then on_target_time for the PID to
+     * settle. -1 if the rate was never set
+     */
+    double estimate_time(double start_pt, double set_pt) override;
+
     PID pid;
 
 
@@ -71,5 +87,6 @@ class PIDFF : public Feedback
 
     double out;
     double lower_lim, upper_lim;
+    double est_max_v = 0, est_accel = 0;
 
 };
\ No newline at end of file
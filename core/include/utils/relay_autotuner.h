@@ -0,0 +1,154 @@
+#pragma once
+
+#include <string>
+#include "vex.h"
+#include "../core/include/utils/pid.h"
+#include "../core/include/utils/serializer.h"
+
+/**
+ * RelayAutotuner
+ *
+ * Finds PID gains automatically using the Astrom-Hagglund relay method.
+ *
+ * Instead of a PID, the system is driven by a "relay": the output is set to bias + amplitude when the sensor is
+ * below the setpoint, and bias - amplitude when it is above. Almost any real system will settle into a steady
+ * oscillation around the setpoint. From the size of that oscillation (a) and its period, we get:
+ *
+ * ultimate gain:   Ku = 4 * amplitude / (pi * a)
+ * ultimate period: Tu = period of the oscillation
+ *
+ * which are the gain at which a P controller would oscillate forever, and how fast it would oscillate.
+ * A tuning rule then turns Ku and Tu into kP, kI and kD. Because the relay keeps the oscillation bounded,
+ * this is safe to run on the robot - it only ever commands bias +/- amplitude.
+ *
+ * Like the PID, the autotuner is updated in a loop by the caller with new sensor data, and returns an output:
+ *
+ * tuner.init();
+ * while(!tuner.is_done())
+ * {
+ *   motors.spin(fwd, tuner.update(sensor.value()), volt);
+ *   vexDelay(10);
+ * }
+ */
+class RelayAutotuner
+{
+public:
+  /**
+   * Rules for turning the ultimate gain and period into PID gains.
+   * Listed from most aggressive to least.
+   */
+  enum TuningRule
+  {
+    PESSEN_INTEGRAL,  ///< Kp=0.7Ku,  Ti=0.4Tu, Td=0.15Tu. fast, with overshoot
+    ZIEGLER_NICHOLS,  ///< Kp=0.6Ku,  Ti=0.5Tu, Td=0.125Tu. the classic - fast, but overshoots
+    SOME_OVERSHOOT,   ///< Kp=0.33Ku, Ti=0.5Tu, Td=0.33Tu
+    NO_OVERSHOOT,     ///< Kp=0.2Ku,  Ti=0.5Tu, Td=0.33Tu
+    TYREUS_LUYBEN,    ///< Kp=0.45Ku, Ti=2.2Tu, Td=Tu/6.3. slow and robust
+    ZIEGLER_NICHOLS_PI ///< Kp=0.45Ku, Ti=Tu/1.2, no D. for systems where D is too noisy (flywheels)
+  };
+
+  /**
+   * relay_config_t holds the configuration for a relay test
+   */
+  struct relay_config_t
+  {
+    double setpoint; ///< the sensor value to oscillate around
+    double amplitude; ///< how far above and below the bias the output is switched
+    double bias; ///< the output at the center of the relay (e.g. the feedforward needed to hold the setpoint)
+    double hysteresis; ///< how far past the setpoint the sensor must go before switching. keeps noise from chattering the relay
+    int cycles; ///< how many full oscillations to average over. the first one is always thrown away
+    double timeout; ///< give up after this many seconds. 0 for no timeout
+  };
+
+  /**
+   * Create a relay autotuner
+   * @param config the configuration of the relay test
+   */
+  RelayAutotuner(relay_config_t &config);
+
+  /**
+   * Start (or restart) the test
+   */
+  void init();
+
+  /**
+   * Update the relay with new sensor data
+   * @param sensor_val the distance, angle, RPM or whatever it is we are measuring
+   * @return the output to command the system with. 0 once the test is over
+   */
+  double update(double sensor_val);
+
+  /**
+   * @return the last output of the relay
+   */
+  double get();
+
+  /**
+   * @return true if the test has finished, either because it measured enough cycles or it timed out
+   */
+  bool is_done();
+
+  /**
+   * @return true if the test finished, and measured enough cycles to find Ku and Tu
+   */
+  bool has_result();
+
+  /**
+   * @return the ultimate gain, Ku. 0 if there is no result
+   */
+  double get_ultimate_gain();
+
+  /**
+   * @return the ultimate period, Tu, in seconds. 0 if there is no result
+   */
+  double get_ultimate_period();
+
+  /**
+   * Calculate PID gains from the test results. All other fields of the config are copied from `base`
+   * @param rule the tuning rule to use
+   * @param base the config to take deadband, on_target_time, etc. from
+   * @return the new PID configuration
+   */
+  PID::pid_config_t get_gains(TuningRule rule, const PID::pid_config_t &base);
+
+  /**
+   * Save the test results and the gains from a tuning rule, so they persist across restarts.
+   * Saved as <name>_ku, <name>_tu, <name>_p, <name>_i and <name>_d
+   * @param serializer where to save the results
+   * @param name the name of the system that was tuned
+   * @param rule the tuning rule to use
+   */
+  void save(Serializer &serializer, const std::string &name, TuningRule rule);
+
+  /**
+   * Load gains that were saved by save(). If they were never saved, cfg is left as it was.
+   * @param serializer where the results were saved
+   * @param name the name of the system that was tuned
+   * @param cfg the PID configuration to load into
+   * @return true if saved gains were found
+   */
+  static bool load(Serializer &serializer, const std::string &name, PID::pid_config_t &cfg);
+
+private:
+  relay_config_t &config;
+
+  bool first_update = true; ///< true if update() hasn't been called since init()
+  bool relay_high = true; ///< true if the output is currently bias + amplitude
+  bool done = false; ///< true once the test is over
+  bool result = false; ///< true if we found Ku and Tu
+
+  int switches = 0; ///< how many times the relay has switched from low to high
+  double last_rise_time = 0; ///< the time of the last low -> high switch
+  double period_sum = 0; ///< sum of the measured periods, for averaging
+  double amplitude_sum = 0; ///< sum of the measured peak to peak amplitudes, for averaging
+  int measured_cycles = 0; ///< the number of cycles that went into the sums
+
+  double cycle_max = 0; ///< highest sensor value in the current cycle
+  double cycle_min = 0; ///< lowest sensor value in the current cycle
+
+  double ku = 0; ///< ultimate gain
+  double tu = 0; ///< ultimate period
+  double out = 0; ///< the last output
+
+  vex::timer tmr;
+};
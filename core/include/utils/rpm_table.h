@@ -0,0 +1,132 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "../core/include/utils/serializer.h"
+
+/**
+ * RPMTable
+ *
+ * A calibrated table of flywheel RPM by distance to the goal. Between entries, the RPM is interpolated with a
+ * monotone cubic (Fritsch-Carlson), so it is smooth but never overshoots the entries on either side.
+ * Past either end of the table, the RPM of the closest entry is used.
+ *
+ * For mechanisms with a hood or flap, keep one table for each state.
+ *
+ * The table can be calibrated on the field: record shots with the distance, RPM and whether they hit, went short
+ * or went long, then fit() builds a new table from them. Tables are saved and loaded with a Serializer, so a
+ * calibration persists across restarts.
+ */
+class RPMTable
+{
+public:
+  /**
+   * One calibrated point of the table
+   */
+  struct entry_t
+  {
+    double distance; ///< distance to the goal (inches)
+    double rpm;      ///< the RPM to shoot at from this distance
+  };
+
+  /**
+   * How a calibration shot went
+   */
+  enum ShotResult
+  {
+    HIT,
+    SHORT,
+    LONG
+  };
+
+  /**
+   * Create a table
+   * @param entries the starting table, in any order
+   */
+  RPMTable(std::vector<entry_t> entries = {});
+
+  /**
+   * Replace the table
+   * @param entries the new table, in any order
+   */
+  void set_entries(std::vector<entry_t> entries);
+
+  /**
+   * @return the entries of the table, sorted by distance
+   */
+  std::vector<entry_t> get_entries();
+
+  /**
+   * @return true if the table has no entries, e.g. it hasn't been calibrated yet
+   */
+  bool empty();
+
+  /**
+   * Look up the RPM for a distance
+   * @param distance distance to the goal (inches)
+   * @return the interpolated RPM. 0 if the table is empty
+   */
+  double get_rpm(double distance);
+
+  /**
+   * Save the table. Saved as <name>_count, <name>_dist_<i> and <name>_rpm_<i>
+   * @param serializer where to save the table
+   * @param name the name of the table
+   */
+  void save(Serializer &serializer, const std::string &name);
+
+  /**
+   * Load a table that was saved by save(). If it was never saved, the table is left as it was
+   * @param serializer where the table was saved
+   * @param name the name of the table
+   * @return true if a saved table was found
+   */
+  bool load(Serializer &serializer, const std::string &name);
+
+  /**
+   * Record a calibration shot
+   * @param distance distance to the goal when the shot was taken (inches)
+   * @param rpm the RPM the flywheel was at
+   * @param result whether it hit, or which way it missed
+   */
+  void record_shot(double distance, double rpm, ShotResult result);
+
+  /**
+   * Throw away all recorded calibration shots
+   */
+  void clear_shots();
+
+  /**
+   * @return how many calibration shots have been recorded
+   */
+  int get_num_shots();
+
+  /**
+   * Build a new table from the calibration shots. The shots are grouped by distance, and each group becomes one
+   * entry: the average of its hits, or if it has none, halfway between its fastest short and slowest long shot.
+   * Groups with neither are skipped. The table is only replaced if at least 2 entries come out of it.
+   * @param bin_width how close together (inches) shots are grouped
+   * @return true if the table was replaced
+   */
+  bool fit(double bin_width = 12);
+
+private:
+  /**
+   * A recorded calibration shot
+   */
+  struct shot_t
+  {
+    double distance;
+    double rpm;
+    ShotResult result;
+  };
+
+  /**
+   * Sort the entries and calculate the slope at each one
+   */
+  void calculate_slopes();
+
+  std::vector<entry_t> entries; ///< sorted by distance
+  std::vector<double> slopes;   ///< d(rpm)/d(distance) at each entry
+  std::vector<shot_t> shots;    ///< calibration shots
+};
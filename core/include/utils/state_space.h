@@ -0,0 +1,97 @@
+#pragma once
+
+#include "../core/include/utils/feedforward.h"
+
+/**
+ * VelocityStateSpace
+ *
+ * A state-space velocity controller for mechanisms that can be modeled as a single first order system, like a flywheel.
+ * From the feedforward constants, the mechanism is modeled as
+ *
+ * kA * dv/dt = u - kS*sgn(v) - kV*v
+ *
+ * The model is used twice:
+ * - A Kalman filter estimates the velocity from the motor's position. Velocity is "predicted" from the voltage we
+ *   sent and then corrected with each position measurement, so it has very little lag compared to a moving average
+ *   over a noisy velocity reading.
+ * - An LQR (or pole placement) gain is applied to the velocity error, on top of the feedforward voltage that would
+ *   hold the target velocity exactly.
+ *
+ * All gains are steady-state gains, calculated once in the constructor. The loop itself is only a few multiplies.
+ * update() must be called every period_ms, since the gains are calculated for that loop time.
+ */
+class VelocityStateSpace
+{
+public:
+  /**
+   * ss_config_t holds the tuning parameters of the controller and the estimator
+   *
+   * Controller (Bryson's rule): the error and effort we are willing to accept. A smaller max_error makes the
+   * controller more aggressive, a smaller max_effort makes it gentler.
+   * If closed_loop_pole is not 0, the gain is found by pole placement instead: the velocity error is multiplied
+   * by closed_loop_pole every loop (0 -> 1, smaller is faster).
+   *
+   * Estimator: how much we trust the model vs. the encoder. Raising model_stdev trusts the encoder more.
+   */
+  struct ss_config_t
+  {
+    double max_error; ///< velocity error that should be corrected with max_effort (units of velocity)
+    double max_effort; ///< output (percent, 0 -> 1) to correct max_error with
+    double closed_loop_pole; ///< if not 0, use pole placement with this discrete pole instead of LQR
+    double model_stdev; ///< standard deviation of the model's velocity prediction each loop (units of velocity)
+    double encoder_stdev; ///< standard deviation of the position measurement (units of position)
+    int period_ms; ///< the loop time update() is called at
+  };
+
+  /**
+   * Create the controller and calculate all of its gains.
+   * Velocity is in units of position per minute (RPM, if position is in revolutions)
+   * @param ff_cfg feedforward constants of the mechanism. kV and kA must be identified (see SysId)
+   * @param cfg    tuning parameters of the controller and estimator
+   */
+  VelocityStateSpace(FeedForward::ff_config_t &ff_cfg, ss_config_t &cfg);
+
+  /**
+   * Reset the estimator to a known position and velocity
+   * @param position the current position
+   * @param velocity the current velocity
+   */
+  void reset(double position, double velocity=0);
+
+  /**
+   * Run one loop of the estimator and controller
+   * @param position the measured position
+   * @param target   the velocity we want
+   * @return the output to send to the motors (percent, -1 -> 1)
+   */
+  double update(double position, double target);
+
+  /**
+   * @return the estimated velocity
+   */
+  double get_velocity();
+
+  /**
+   * @return the last output
+   */
+  double get();
+
+  /**
+   * @return the controller's gain (percent per unit of velocity error)
+   */
+  double get_control_gain();
+
+private:
+  FeedForward::ff_config_t &ff_cfg;
+  ss_config_t &cfg;
+
+  // Discrete model: v[k+1] = a*v[k] + b*(u[k] - kS*sgn(v[k]))
+  double a = 0, b = 0;
+  double dt = 0; ///< loop time, in minutes (to match velocity units)
+
+  double k = 0; ///< controller gain
+  double l_pos = 0, l_vel = 0; ///< steady-state Kalman gains for position and velocity
+
+  double x_pos = 0, x_vel = 0; ///< estimated position and velocity
+  double out = 0; ///< the last output
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "vex.h"
+#include "../core/include/utils/feedforward.h"
+
+/**
+ * SysId
+ *
+ * Characterizes a mechanism (drivetrain, flywheel, lift) to find its feedforward constants, kS, kV, kA (and kG).
+ *
+ * It runs four tests, forward and in reverse:
+ * - quasistatic: the output ramps up slowly, so acceleration is ~0 and the data shows kS and kV
+ * - dynamic: the output steps straight to a fixed value, so the data shows kA
+ *
+ * Output and velocity are recorded at a fixed rate into a buffer that is allocated up front, so the test doesn't
+ * allocate while the mechanism is moving. Afterwards, acceleration is found from a local line fit of the velocity,
+ * and all the constants are solved for together with ordinary least squares on the model
+ *
+ * output = kS*sgn(v) + kV*v + kA*a (+ kG)
+ *
+ * The fit is reported with R^2 (how much of the output the model explains; closer to 1 is better) and the
+ * residuals, so a bad test is obvious instead of silently giving bad constants.
+ *
+ * The mechanism is connected with two functions, so the same tests work for any mechanism:
+ * SysId sysid([](double pct){ flywheel_sys.spin_raw(pct); }, [](){ return flywheel_sys.measureRPM(); }, cfg);
+ */
+class SysId
+{
+public:
+  /**
+   * sysid_cfg_t holds the parameters of the tests
+   */
+  struct sysid_cfg_t
+  {
+    double ramp_rate; ///< how fast the quasistatic tests ramp up the output (percent per second)
+    double step_pct; ///< the output (percent) of the dynamic tests
+    double quasistatic_time; ///< how long each quasistatic test lasts (seconds)
+    double dynamic_time; ///< how long each dynamic test lasts (seconds)
+    int period_ms; ///< the time between samples (milliseconds)
+    bool fit_kg; ///< true to also fit a constant kG term, for mechanisms that fight gravity (lifts)
+  };
+
+  /**
+   * The results of a characterization
+   */
+  struct sysid_result_t
+  {
+    FeedForward::ff_config_t ff; ///< the fitted constants
+    double r_squared; ///< coefficient of determination of the fit (0 -> 1)
+    double rms_residual; ///< root mean squared error between the model and the real output (percent)
+    double max_residual; ///< the worst error between the model and the real output (percent)
+    int num_samples; ///< how many samples went into the fit
+    bool valid; ///< false if there wasn't enough data to fit
+  };
+
+  /**
+   * The kinds of test that can be run
+   */
+  enum TestType
+  {
+    QUASISTATIC,
+    DYNAMIC
+  };
+
+  /**
+   * Create a system identification routine
+   * @param set_output    sets the output of the mechanism, in percent (-1.0 -> 1.0)
+   * @param get_velocity  gets the velocity of the mechanism, positive in the direction of positive output
+   * @param cfg           the parameters of the tests
+   * @param max_samples   the size of the sample buffer. allocated once, here
+   */
+  SysId(std::function<void(double)> set_output, std::function<double(void)> get_velocity, sysid_cfg_t &cfg, int max_samples=2000);
+
+  /**
+   * Run all four tests (quasistatic and dynamic, forward and reverse), then fit the results.
+   * Blocks until the tests are done. The mechanism will move, so give it room!
+   * @param pause_sec how long to wait between tests, for the mechanism to come to a stop
+   * @return the fitted constants, and how well they fit
+   */
+  sysid_result_t run(double pause_sec=2.0);
+
+  /**
+   * Run a single test, adding to the recorded data. Blocks until the test is done.
+   * @param type    quasistatic or dynamic
+   * @param reverse true to run the test with negative output
+   */
+  void run_test(TestType type, bool reverse);
+
+  /**
+   * Fit the feedforward constants to all data recorded so far
+   * @return the fitted constants, and how well they fit
+   */
+  sysid_result_t solve();
+
+  /**
+   * Throw away all recorded data
+   */
+  void clear();
+
+  /**
+   * Print the results of a fit
+   * @param result the results from run() or solve()
+   */
+  static void print_result(const sysid_result_t &result);
+
+private:
+  /**
+   * A single recorded sample
+   */
+  struct sample_t
+  {
+    double time; ///< seconds since the start of the test
+    double output; ///< the commanded output, percent
+    double velocity; ///< the measured velocity
+    int test; ///< which test this sample came from. samples are only compared within the same test
+  };
+
+  std::function<void(double)> set_output;
+  std::function<double(void)> get_velocity;
+  sysid_cfg_t &cfg;
+
+  std::vector<sample_t> samples; ///< recorded samples. capacity is reserved once, in the constructor
+  int max_samples; ///< the most samples we can record
+  int num_tests = 0; ///< how many tests have been run since clear()
+};
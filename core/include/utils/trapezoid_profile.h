@@ -20,6 +20,10 @@ typedef struct
  * 
  * If the maximum velocity is set high enough, this will become a S-curve profile, with only acceleration and deceleration.
  * 
+ * The profile does not have to start or end at rest. With set_vel_endpts(), a movement can begin at the velocity
+ * the robot is already travelling at and end at a velocity the next movement will pick up from, so chained
+ * movements do not stop between each other.
+ * 
  * This class is designed for use in properly modelling the motion of the robots to create a feedfoward
  * and target for PID. Acceleration and Maximum velocity should be measured on the robot and tuned down
  * slightly to account for battery drop.
@@ -58,6 +62,15 @@ class TrapezoidProfile
      */
     void set_endpts(double start, double end);
 
+    /**
+     * set_vel_endpts defines the velocity the profile starts and ends at. Both default to 0 (rest to rest).
+     * Velocities are in the direction of travel, and are limited to [0, max_v]. If the end velocity can't be
+     * reached within the distance of the profile, the closest reachable velocity is used instead.
+     * @param start_vel the velocity at the start of the path
+     * @param end_vel the velocity at the end of the path
+     */
+    void set_vel_endpts(double start_vel, double end_vel);
+
     /**
      * set_accel sets the acceleration this profile will use (the left and right legs of the trapezoid)
      * @param accel the acceleration amount to use
@@ -78,10 +91,23 @@ class TrapezoidProfile
     double get_movement_time();
 
     private:
+
+    /**
+     * Recalculate the length and peak velocity of each section of the profile.
+     * Called whenever one of the profile parameters changes.
+     */
+    void precalculate();
+
     double start, end; ///< the start and ending position of the profile
+    double start_vel, end_vel; ///< the requested start and ending velocity of the profile
     double max_v; ///< the maximum velocity to travel at for this profile
     double accel; ///< the rate of acceleration to use for this profile.
-    double time; ///< the current point in time along the path
-    
+    double time; ///< the total time the profile will take
+
+    double accel_time; ///< time spent accelerating from the start velocity to the peak velocity
+    double max_vel_time; ///< time spent at the peak velocity
+    double decel_time; ///< time spent decelerating from the peak velocity to the end velocity
+    double peak_v; ///< the highest velocity reached during the profile (magnitude)
+    double v_start, v_end; ///< start and end velocities that will actually be used (magnitude)
 
 };
\ No newline at end of file
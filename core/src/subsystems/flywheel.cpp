@@ -18,11 +18,16 @@
 #include "../core/include/utils/feedforward.h"
 #include "../core/include/utils/pid.h"
 #include "../core/include/utils/math_util.h"
+#include "../core/include/utils/battery_compensation.h"
 #include "vex.h"
 
 using namespace vex;
 
-const int FlywheelWindowSize = 20;
+// The RPM filter averages over this much time. The motors only update their velocity every 10ms,
+// so sampling faster than that doesn't give the filter any more information
+const int FlywheelWindowMs = 20;
+const int FlywheelDefaultPeriodMs = 10;
+const int FlywheelWindowSize = FlywheelWindowMs / FlywheelDefaultPeriodMs;
 
 /*********************************************************
 *         CONSTRUCTOR, GETTERS, SETTERS
@@ -56,14 +61,24 @@ Flywheel::Flywheel(motor_group &motors, const double TBH_gain, const double rati
 Flywheel::Flywheel(motor_group &motors, const double ratio)
     :motors(motors), pid(empty_pid), ff(empty_ff), ratio(ratio), control_style(Bang_Bang), smoothedRPM(0), RPM_avger(MovingAverage(FlywheelWindowSize)) {}
 
+/**
+* Create the Flywheel object using a state space controller
+*/
+Flywheel::Flywheel(motor_group &motors, FeedForward::ff_config_t &ff_config, VelocityStateSpace::ss_config_t &ss_config, const double ratio)
+    :motors(motors), pid(empty_pid), ff(ff_config), ratio(ratio), control_style(State_Space), smoothedRPM(0), RPM_avger(MovingAverage(FlywheelWindowSize)),
+    state_space(new VelocityStateSpace(ff_config, ss_config)) {
+      // The state space gains are only valid at the period they were calculated for
+      setControlPeriod(ss_config.period_ms);
+    }
+
 /**
 * Return the current value that the RPM should be set to
 */
 double Flywheel::getDesiredRPM() { return RPM; }
 
 /**
-* Checks if the background RPM controlling task is running
-* @return taskRunning - If the task is running
+* Checks if the background control loop is controlling the RPM
+* @return taskRunning - If the RPM is being controlled
 */
 bool Flywheel::isTaskRunning() { return taskRunning; }
 
@@ -129,99 +144,431 @@ void Flywheel::setPIDTarget(double value) { pid.set_target(value); }
 void Flywheel::updatePID(double value) { pid.update(value); }
 
 /*********************************************************
-*         RPM SETTING THREADS
-* ALL OF THE FOLLOWING PROGRAMS HAVE THE SAME PARAMETERS AND RESULTS:
-* spin this flywheel at a given RPM, async; runs until stop(), stopThread(), or a new spinRPM() is called. 
-* @param wheelPointer - points to the current wheel object
+*         SHOT DETECTION
 *********************************************************/
 
 /**
-* Runs a Feedforward variant to control rpm
+* Start detecting shots, and boosting the output to recover from them
+* @param shot_config the shot detection parameters
 */
-int spinRPMTask_BangBang(void* wheelPointer) {
-  Flywheel* wheel = (Flywheel*) wheelPointer; 
-  while(true) {
-    // if it below the RPM, go, otherwise don't
-    wheel->measureRPM();
-
-    if(wheel->getRPM() < wheel->getDesiredRPM()) { 
-      wheel->spin_raw(1, fwd);
-    }   
-    else { wheel->stopMotors(); }
-    vexDelay(10);
+void Flywheel::setShotDetection(shot_config_t &shot_config) { shot_cfg = &shot_config; }
+
+/**
+* Check the RPM and current for a shot, and track the recovery from the last one.
+* Only one shot is tracked at a time: discs fired while the flywheel is still recovering extend that recovery.
+*/
+void Flywheel::updateShotDetection() {
+  if (shot_cfg == NULL) return;
+
+  double target = getDesiredRPM();
+  double rpm = getRPM();
+  double error = target - rpm;
+  double now = shot_tmr.time(seconds);
+
+  if (!recovering) {
+    shot_boost = 0;
+    if (target <= 0) {
+      shot_armed = false;
+      return;
+    }
+
+    // Only count a shot once the flywheel has been up to speed, so spinning up isn't mistaken for one
+    if (fabs(error) < shot_cfg->recovered_rpm) shot_armed = true;
+
+    bool dropped = error > shot_cfg->drop_rpm;
+    bool spiked = shot_cfg->current_spike > 0 && sampled_current > shot_cfg->current_spike;
+    if (shot_armed && (dropped || spiked)) {
+      recovering = true;
+      shot_armed = false;
+      shot_dropped = false;
+      shot_count++;
+      last_shot = {.time = now, .min_rpm = rpm, .recovery_time = 0};
+    }
   }
-  return 0;
+
+  if (recovering) {
+    last_shot.min_rpm = fmin(last_shot.min_rpm, rpm);
+    if (error > shot_cfg->recovered_rpm) shot_dropped = true;
+
+    double time_since_shot = now - last_shot.time;
+    if (shot_dropped && error < shot_cfg->recovered_rpm) {
+      recovering = false;
+      last_shot.recovery_time = time_since_shot;
+      printf("Shot %d: dropped to %.0f RPM, recovered in %.3f s\n", shot_count, last_shot.min_rpm, last_shot.recovery_time);
+    } else if (!shot_dropped && time_since_shot > shot_cfg->max_boost_time) {
+      // A current spike that never slowed the wheel down wasn't a shot
+      recovering = false;
+      shot_count--;
+    }
+  }
+
+  bool boosting = recovering && error > 0 && (now - last_shot.time) < shot_cfg->max_boost_time;
+  shot_boost = boosting ? shot_cfg->boost : 0;
 }
 
 /**
-* Runs a Feedforward variant to control rpm
+* @return true if a shot was detected and the flywheel hasn't gotten back up to speed yet
 */
-int spinRPMTask_Feedforward(void* wheelPointer) { 
-  Flywheel* wheel = (Flywheel*) wheelPointer;
-  // get the pid from the wheel and set its target to the RPM stored in the wheel.
-  while(true) {
-    wheel->measureRPM();
-    wheel->updatePID(wheel->getRPM());   // check the current velocity and update the PID with it.
-    double output = wheel->getFeedforwardValue();
-    wheel->spin_raw(output, fwd);   // set the motors to whatever feedforward tells them to do
-    vexDelay(1);
+bool Flywheel::isRecovering() { return recovering; }
+
+/**
+* @return how many shots have been detected
+*/
+int Flywheel::getShotCount() { return shot_count; }
+
+/**
+* @return the last shot that was detected. All zeros if there haven't been any
+*/
+Flywheel::shot_event_t Flywheel::getLastShot() { return last_shot; }
+
+/**
+* @return seconds since the last shot was detected, or -1 if there haven't been any
+*/
+double Flywheel::getTimeSinceShot() { return (shot_count > 0) ? shot_tmr.time(seconds) - last_shot.time : -1; }
+
+/*********************************************************
+*         TELEMETRY
+*********************************************************/
+
+// After the RPM reaches 90% of a setpoint change, wait this long (seconds) before measuring steady state error
+const double FlywheelSettleTime = 0.5;
+// Setpoint changes smaller than this (RPM) don't start a new step, so a tracked setpoint that drifts doesn't
+// keep resetting the metrics
+const double FlywheelStepThreshold = 100;
+
+/**
+* Start recording telemetry every tick into a ring buffer. Calling again clears it
+* @param size how many samples to keep
+*/
+void Flywheel::startTelemetry(int size) {
+  telemetry.assign(size > 0 ? size : 1, telemetry_sample_t{});
+  telemetry_next = 0;
+  telemetry_count = 0;
+  telemetry_tmr.reset();
+  resetMetrics();
+}
+
+/**
+* @return how many samples are in the telemetry buffer
+*/
+int Flywheel::getTelemetrySize() { return telemetry_count; }
+
+/**
+* Get a sample from the telemetry buffer
+* @param i which sample. 0 is the oldest, getTelemetrySize() - 1 the newest
+*/
+Flywheel::telemetry_sample_t Flywheel::getTelemetrySample(int i) {
+  if (i < 0 || i >= telemetry_count) return telemetry_sample_t{};
+  int oldest = (telemetry_next - telemetry_count + telemetry.size()) % telemetry.size();
+  return telemetry[(oldest + i) % telemetry.size()];
+}
+
+/**
+* @return performance metrics for the control loop
+*/
+Flywheel::metrics_t Flywheel::getMetrics() { return metrics; }
+
+/**
+* Reset the metrics, without clearing the telemetry buffer
+*/
+void Flywheel::resetMetrics() {
+  metrics = {};
+  step_setpoint = 0;
+  step_rise_start = -1;
+  step_rise_end = -1;
+  sse_sum = 0;
+  sse_count = 0;
+  counted_shot_time = last_shot.time;
+}
+
+/**
+* Record this tick's telemetry, and update the metrics from it
+*/
+void Flywheel::recordTelemetry() {
+  if (telemetry.empty()) return;
+
+  double now = telemetry_tmr.time(seconds);
+  double setpoint = getDesiredRPM();
+  double rpm = getRPM();
+
+  telemetry[telemetry_next] = {.time = (float)now, .setpoint = (float)setpoint, .rpm = (float)rpm, .volts = (float)last_volts, .current = (float)sampled_current};
+  telemetry_next = (telemetry_next + 1) % telemetry.size();
+  if (telemetry_count < (int)telemetry.size()) telemetry_count++;
+
+  // A new setpoint starts a new step response
+  if (fabs(setpoint - step_setpoint) > FlywheelStepThreshold || (setpoint == 0) != (step_setpoint == 0)) {
+    step_setpoint = setpoint;
+    step_start_rpm = rpm;
+    step_rise_start = -1;
+    step_rise_end = -1;
+    sse_sum = 0;
+    sse_count = 0;
+    metrics.rise_time = 0;
+    metrics.overshoot = 0;
+    metrics.steady_state_error = 0;
+  }
+
+  double step = setpoint - step_start_rpm;
+  if (step != 0) {
+    double progress = (rpm - step_start_rpm) / step;
+    if (step_rise_start < 0 && progress >= 0.1) step_rise_start = now;
+    if (step_rise_end < 0 && progress >= 0.9) {
+      step_rise_end = now;
+      metrics.rise_time = now - step_rise_start;
+    }
+
+    if (step_rise_end >= 0) {
+      metrics.overshoot = fmax(metrics.overshoot, (rpm - setpoint) * sign(step));
+
+      if (!recovering && now - step_rise_end > FlywheelSettleTime) {
+        sse_sum += setpoint - rpm;
+        sse_count++;
+        metrics.steady_state_error = sse_sum / sse_count;
+      }
+    }
+  }
+
+  // Count each shot once it has recovered
+  if (last_shot.recovery_time > 0 && last_shot.time != counted_shot_time) {
+    counted_shot_time = last_shot.time;
+    metrics.last_recovery_time = last_shot.recovery_time;
+    metrics.avg_recovery_time += (last_shot.recovery_time - metrics.avg_recovery_time) / (metrics.shots + 1);
+    metrics.shots++;
+  }
+}
+
+/**
+* Save the telemetry buffer and the metrics to the SD card as CSV
+* @param filename the file to write
+* @return false if there was no SD card or no telemetry
+*/
+bool Flywheel::saveTelemetry(const char *filename) {
+  brain::sdcard sd;
+  if (!sd.isInserted()) {
+    printf("(flywheel.cpp): Warning - no SD card to save telemetry to\n");
+    return false;
+  }
+  if (telemetry_count == 0) return false;
+
+  char line[128];
+  std::string csv;
+  csv.reserve(telemetry_count * 40 + 512);
+
+  snprintf(line, sizeof(line), "# rise_time,%f\n# overshoot,%f\n# steady_state_error,%f\n", metrics.rise_time, metrics.overshoot, metrics.steady_state_error);
+  csv += line;
+  snprintf(line, sizeof(line), "# last_recovery_time,%f\n# avg_recovery_time,%f\n# shots,%d\n", metrics.last_recovery_time, metrics.avg_recovery_time, metrics.shots);
+  csv += line;
+  csv += "time,setpoint,rpm,volts,current\n";
+
+  for (int i = 0; i < telemetry_count; i++) {
+    telemetry_sample_t sample = getTelemetrySample(i);
+    snprintf(line, sizeof(line), "%.3f,%.0f,%.1f,%.2f,%.2f\n", sample.time, sample.setpoint, sample.rpm, sample.volts, sample.current);
+    csv += line;
+  }
+
+  sd.savefile(filename, (uint8_t *)csv.c_str(), csv.size());
+  return true;
+}
+
+/*********************************************************
+*         CONTROL SERVICE
+* One task runs the control loop at a fixed rate for the life of the program. It is started by the first
+* spinRPM(), and idles while the flywheel is stopped. Changing the control scheme only changes which
+* tick function runs, so no task is ever killed or restarted.
+*********************************************************/
+
+/**
+* Change the control scheme. Takes effect on the next tick, without restarting the control task.
+* @param style the control scheme to use
+*/
+void Flywheel::setControlStyle(FlywheelControlStyle style) {
+  if (style == State_Space && state_space == NULL) {
+    printf("(flywheel.cpp): Warning - State_Space control needs the state space constructor\n");
+    return;
+  }
+  control_style = style;
+  resetControl();
+}
+
+/**
+* @return the control scheme currently in use
+*/
+Flywheel::FlywheelControlStyle Flywheel::getControlStyle() { return control_style; }
+
+/**
+* Change how often the control loop runs. The RPM filter is resized to keep the same window in time.
+* @param period_ms the time between ticks, in milliseconds
+*/
+void Flywheel::setControlPeriod(int period_ms) {
+  if (period_ms <= 0) return;
+  if (state_space != NULL && control_period_ms != period_ms && taskRunning)
+    printf("(flywheel.cpp): Warning - the state space gains were calculated for %dms\n", control_period_ms);
+
+  control_period_ms = period_ms;
+  RPM_avger = MovingAverage(fmax(1, FlywheelWindowMs / period_ms));
+}
+
+/**
+* @return the time between ticks of the control loop, in milliseconds
+*/
+int Flywheel::getControlPeriod() { return control_period_ms; }
+
+/**
+* Read each sensor once, for this tick. Only the sensors the current control scheme needs are read
+*/
+void Flywheel::sampleSensors() {
+  if (control_style == State_Space) {
+    sampled_position = ratio * motors.position(rotationUnits::rev);
+  } else {
+    sampled_rpm = ratio * motors.velocity(velocityUnits::rpm);
+    RPM_avger.add_entry(sampled_rpm);
+    smoothedRPM = RPM_avger.get_average();
   }
-  return 0; 
+
+  if ((shot_cfg != NULL && shot_cfg->current_spike > 0) || !telemetry.empty())
+    sampled_current = motors.current(currentUnits::amp);
 }
+
+/**
+* Reset the state of the control schemes, so they start fresh
+*/
+void Flywheel::resetControl() {
+  tbh = 0;
+  tbh_output = 0;
+  tbh_previous_error = 0;
+  pid.reset();
+  setPIDTarget(RPM);
+
+  // Start the estimate where the flywheel actually is
+  if (state_space != NULL)
+    state_space->reset(ratio * motors.position(rotationUnits::rev), ratio * motors.velocity(velocityUnits::rpm));
+}
+
+/**
+* Run one tick of the control loop: sample the sensors once, then run the current control scheme.
+*/
+void Flywheel::controlTick() {
+  if (!taskRunning) return;
+
+  uint64_t start_us = ControlLoop::start_tick();
+
+  if (rpm_source) {
+    RPM = rpm_source();
+    setPIDTarget(RPM);
+  }
+
+  sampleSensors();
+  updateShotDetection();
+
+  switch(control_style){
+    case Bang_Bang:
+      tickBangBang();
+      break;
+    case Take_Back_Half:
+      tickTBH();
+      break;
+    case Feedforward:
+      tickFeedforward();
+      break;
+    case PID_Feedforward:
+      tickPIDFeedforward();
+      break;
+    case State_Space:
+      tickStateSpace();
+      break;
+  }
+
+  recordTelemetry();
+
+  ControlLoop::end_tick(tick_stats, start_us, control_period_ms);
+}
+
+/**
+* @return how much CPU time the control loop is using
+*/
+Flywheel::tick_stats_t Flywheel::getTickStats() { return tick_stats; }
+
+/**
+* Reset the tick time statistics
+*/
+void Flywheel::resetTickStats() { tick_stats = {}; }
+
 /**
-* Runs a PID + Feedforward variant to control rpm
+* Runs the control loop at a fixed rate, forever
+* @param wheelPointer - points to the current wheel object
 */
-int spinRPMTask_PID_Feedforward(void* wheelPointer) {
+int flywheelControlService(void* wheelPointer) {
   Flywheel* wheel = (Flywheel*) wheelPointer;
-  // get the pid from the wheel and set its target to the RPM stored in the wheel.
+  uint32_t next_tick = timer::system();
   while(true) {
-    wheel->measureRPM();
-    wheel->updatePID(wheel->getRPM());   // check the current velocity and update the PID with it.
-    double output = wheel->getPIDValue() + wheel->getFeedforwardValue();
-    wheel->spin_raw(output, fwd);   // set the motors to whatever PID tells them to do
-    vexDelay(1);
+    wheel->controlTick();
+    ControlLoop::wait_for_next_tick(next_tick, wheel->getControlPeriod());
   }
-  return 0; 
+  return 0;
 }
 
+/*********************************************************
+*         CONTROL SCHEMES
+* Each runs one tick, using the sensors sampled for that tick
+*********************************************************/
+
 /**
-* Runs a Take Back Half variant to control RPM
-* https://www.vexwiki.org/programming/controls_algorithms/tbh
+* Bang bang: full power below the target, coast above it
 */
-int spinRPMTask_TBH(void* wheelPointer) {
-  Flywheel* wheel = (Flywheel*) wheelPointer;
+void Flywheel::tickBangBang() {
+  if(getRPM() < getDesiredRPM()) { 
+    spin_raw(1, fwd);
+  }   
+  else { stopMotors(); }
+}
 
-  double tbh = 0.0;
-  double output = 0.0;
-  double previous_error = 0.0;
+/**
+* Feedforward only
+*/
+void Flywheel::tickFeedforward() {
+  updatePID(getRPM());   // keep the PID updated, so getPIDValue() is meaningful
+  spin_raw(getFeedforwardValue(), fwd);   // set the motors to whatever feedforward tells them to do
+}
 
-  while (true){
-    wheel->measureRPM();
+/**
+* PID + Feedforward
+*/
+void Flywheel::tickPIDFeedforward() {
+  updatePID(getRPM());   // check the current velocity and update the PID with it.
+  spin_raw(getPIDValue() + getFeedforwardValue(), fwd);   // set the motors to whatever PID tells them to do
+}
 
-    //reset if set to 0, this keeps the tbh val from screwing us up when we start up again
-    if (wheel->getDesiredRPM()==0){
-      output = 0;
-      tbh = 0;
-    }
-   
-    double error = wheel->getDesiredRPM() - wheel->getRPM();
-    output += wheel->getTBHGain() * error;
-    wheel->spin_raw(clamp(output, 0, 1), fwd);
-
-    if (sign(error)!=sign(previous_error)){
-      output = .5 * (output + tbh);
-      tbh = output;
-      previous_error = error;
-    }
+/**
+* Take Back Half
+* https://www.vexwiki.org/programming/controls_algorithms/tbh
+*/
+void Flywheel::tickTBH() {
+  //reset if set to 0, this keeps the tbh val from screwing us up when we start up again
+  if (getDesiredRPM()==0){
+    tbh_output = 0;
+    tbh = 0;
+  }
 
-    vexDelay(1);
+  // The gain is per millisecond, so it behaves the same at any control period
+  double error = getDesiredRPM() - getRPM();
+  tbh_output += getTBHGain() * error * control_period_ms;
+  spin_raw(clamp(tbh_output, 0, 1), fwd);
+
+  if (sign(error)!=sign(tbh_previous_error)){
+    tbh_output = .5 * (tbh_output + tbh);
+    tbh = tbh_output;
+    tbh_previous_error = error;
   }
-  
-   return 0; 
 }
 
-// Runs a 'Moving average filter with above closed loop systems' variant, whatever that means; FUNCTION STUB
-int spinRPMTask_ClosedLoop(void* wheelPointer) { return 0; }
+/**
+* State space (Kalman filter + LQR): estimate the RPM from the motor position, and set the motors
+*/
+void Flywheel::tickStateSpace() {
+  double output = state_space->update(sampled_position, getDesiredRPM());
+  smoothedRPM = state_space->get_velocity();
+  spin_raw(output, fwd);
+}
 
 /*********************************************************
 *         SPINNERS AND STOPPERS
@@ -230,11 +577,13 @@ int spinRPMTask_ClosedLoop(void* wheelPointer) { return 0; }
 /** 
 * Spin motors using voltage; defaults forward at 12 volts
 * FOR USE BY TASKS ONLY
+* Adds the recovery boost while the flywheel is recovering from a shot
 * @param speed - speed (between -1 and 1) to set the motor
 * @param dir - direction that the motor moves in; defaults to forward
 */
 void Flywheel::spin_raw(double speed, directionType dir){
-  motors.spin(dir, speed * 12, voltageUnits::volt);
+  last_volts = BatteryCompensation::percent_to_volts(speed + shot_boost);
+  motors.spin(dir, last_volts, voltageUnits::volt);
 }
 
 /**
@@ -244,62 +593,71 @@ void Flywheel::spin_raw(double speed, directionType dir){
 * @param dir - direction that the motor moves in; defaults to forward
 */
 void Flywheel::spin_manual(double speed, directionType dir){
-  if(!taskRunning) motors.spin(dir, speed * 12, voltageUnits::volt);
+  if(!taskRunning) motors.spin(dir, BatteryCompensation::percent_to_volts(speed), voltageUnits::volt);
 }
 
 /**
-* starts or sets the RPM thread at new value
+* sets the RPM the control loop should hold, starting the control task the first time it's called
 * what control scheme is dependent on control_style
 * @param inputRPM - set the current RPM
 */
 void Flywheel::spinRPM(int inputRPM) {
+  rpm_source = nullptr;
+
   // setting to 0 is equivelent to stopping
   if (inputRPM==0){
     stop();
+    return;
   }
-  // only run if the RPM is different or it isn't already running
-  if(!taskRunning) {
-
-    int (*rpm_control_task)(void *);  // this just means a function that returns int and takes a void pointer as an argument aka a spinRPMTask function
-    // choose which version to use based on how  the flywheel was constructed
-    switch(control_style){
-      case Bang_Bang:
-        rpm_control_task = spinRPMTask_BangBang;
-        break;
-      case Take_Back_Half:
-        rpm_control_task = spinRPMTask_TBH;
-        break;
-      case Feedforward:
-        rpm_control_task = spinRPMTask_Feedforward;
-        break;
-      case PID_Feedforward:
-        rpm_control_task = spinRPMTask_PID_Feedforward;
-        break;
-    }
 
+  RPM = inputRPM;
 
-    rpmTask = task(rpm_control_task, this);
+  // start the control scheme fresh if we were stopped
+  if(!taskRunning) {
+    resetControl();
     taskRunning = true;
   }
-  RPM = inputRPM;
   setPIDTarget(RPM);
+
+  // the control task is only ever started once
+  if(!serviceStarted) {
+    rpmTask = task(flywheelControlService, this);
+    serviceStarted = true;
+  }
 }
 
 /**
-* stop the RPM thread and the wheel
+* Spin at an RPM that is recalculated every tick. Cancelled by spinRPM() or stop()
+* @param source called every tick to get the RPM to spin at
+*/
+void Flywheel::spinRPMTracking(std::function<double(void)> source) {
+  // spinRPM(0) would stop the flywheel, but the source may just not want any speed yet
+  int start_rpm = (int)source();
+  spinRPM(start_rpm != 0 ? start_rpm : 1);
+  rpm_source = source;
+}
+
+/**
+* stop controlling the RPM and stop the wheel. The control task keeps running, idle
 */
 void Flywheel::stop() {
-  rpmTask.stop();
+  rpm_source = nullptr;
   taskRunning = false;
   RPM = 0.0;
   smoothedRPM = 0.0;
+  recovering = false;
+  shot_armed = false;
+  shot_boost = 0;
   motors.stop();
 }
 
 /**
 * stop only the motors; exclusively for BANG BANG use
 */
-void Flywheel::stopMotors() { motors.stop(); }
+void Flywheel::stopMotors() {
+  last_volts = 0;
+  motors.stop();
+}
 
 /**
 * Stop the motors if the task isn't running - stop manual control
@@ -1,20 +1,23 @@
 #include "../core/include/utils/geometry.h"
 #include "../core/include/subsystems/tank_drive.h"
 #include "../core/include/utils/math_util.h"
+#include "../core/include/utils/motion_controller.h"
+#include "../core/include/utils/battery_compensation.h"
 
 TankDrive::TankDrive(motor_group &left_motors, motor_group &right_motors, robot_specs_t &config, OdometryBase *odom)
-    : left_motors(left_motors), right_motors(right_motors), correction_pid(config.correction_pid), odometry(odom), config(config)
+    : left_motors(left_motors), right_motors(right_motors), odometry(odom), config(config)
 {
   drive_default_feedback = config.drive_feedback;
   turn_default_feedback = config.turn_feedback;
 }
 
 /**
- * Reset the initialization for autonomous drive functions
+ * Reset the initialization for the autonomous drive functions that don't take a drive_motion_t, and forget any speed
+ * handed off by a blended movement
  */
 void TankDrive::reset_auto()
 {
-  func_initialized = false;
+  default_motion.reset();
 }
 
 /**
@@ -24,6 +27,76 @@ void TankDrive::stop()
 {
   left_motors.stop();
   right_motors.stop();
+  default_motion.handoff_speed = 0;
+}
+
+/**
+ * Calculate how fast the robot can pass through a point on the way to the next one, for blending
+ * consecutive drive_to_point movements.
+ * 
+ * @param pt the point the robot is driving to now
+ * @param next_pt the point the robot will drive to after that
+ * @param speed the speed (inches/second) to use for a straight line
+ * @return the speed (inches/second) to hand off to the next movement at `pt`
+ */
+double TankDrive::corner_speed(point_t pt, point_t next_pt, double speed)
+{
+  if(odometry == NULL)
+    return 0;
+
+  pose_t cur_pos = odometry->get_position();
+  double heading_in = rad2deg(atan2(pt.y - cur_pos.y, pt.x - cur_pos.x));
+  double heading_out = rad2deg(atan2(next_pt.y - pt.y, next_pt.x - pt.x));
+  double corner = OdometryBase::smallest_angle(heading_in, heading_out);
+
+  return fmax(speed * cos(deg2rad(corner)), 0);
+}
+
+/**
+ * @param inches how far to drive
+ * @param dir the direction to drive
+ * @return the point drive_forward would drive to, starting from where the robot is now
+ */
+point_t TankDrive::forward_target(double inches, directionType dir)
+{
+  if(odometry == NULL)
+    return {0, 0};
+
+  pose_t cur_pos = odometry->get_position();
+
+  // forwards is positive Y axis, backwards is negative
+  if (dir == directionType::rev)
+    inches = -fabs(inches);
+  else
+    inches = fabs(inches);
+
+  // Use vector math to get an X and Y
+  Vector2D cur_pos_vec({.x=cur_pos.x , .y=cur_pos.y});
+  Vector2D delta_pos_vec(deg2rad(cur_pos.rot), inches);
+  Vector2D setpt_vec = cur_pos_vec + delta_pos_vec;
+
+  return {.x=setpt_vec.get_x(), .y=setpt_vec.get_y()};
+}
+
+/**
+ * Where the robot will be when it reaches a point, driving straight to it from where it is now
+ * @param pt the point the robot is driving to
+ * @param dir the direction it is driving
+ * @return the point, with the heading the robot faces when it drives straight there
+ */
+pose_t TankDrive::arrival_pose(point_t pt, directionType dir)
+{
+  if(odometry == NULL)
+    return {.x=pt.x, .y=pt.y, .rot=0};
+
+  pose_t cur_pos = odometry->get_position();
+  double heading = rad2deg(atan2(pt.y - cur_pos.y, pt.x - cur_pos.x));
+
+  // Going backwards, the robot faces away from the way it's driving
+  if (dir == directionType::rev)
+    heading += 180;
+
+  return {.x=pt.x, .y=pt.y, .rot=wrap_angle_deg(heading)};
 }
 
 /**
@@ -39,8 +112,8 @@ void TankDrive::drive_tank(double left, double right, int power, bool isdriver)
 
   if(isdriver == false)
   {
-    left_motors.spin(directionType::fwd, left * 12, voltageUnits::volt);
-    right_motors.spin(directionType::fwd, right * 12, voltageUnits::volt);
+    left_motors.spin(directionType::fwd, BatteryCompensation::percent_to_volts(left), voltageUnits::volt);
+    right_motors.spin(directionType::fwd, BatteryCompensation::percent_to_volts(right), voltageUnits::volt);
   }else
   {
     left_motors.spin(directionType::fwd, left * 100.0, percentUnits::pct);
@@ -62,8 +135,8 @@ void TankDrive::drive_arcade(double forward_back, double left_right, int power)
   double left = forward_back + left_right;
   double right = forward_back - left_right;
 
-  left_motors.spin(directionType::fwd, left * 12, voltageUnits::volt);
-  right_motors.spin(directionType::fwd, right * 12, voltageUnits::volt);
+  left_motors.spin(directionType::fwd, BatteryCompensation::percent_to_volts(left), voltageUnits::volt);
+  right_motors.spin(directionType::fwd, BatteryCompensation::percent_to_volts(right), voltageUnits::volt);
 }
 
 /**
@@ -74,11 +147,26 @@ void TankDrive::drive_arcade(double forward_back, double left_right, int power)
  * @param dir        the direction we want to travel forward and backward
  * @param feedback   the custom feedback controller we will use to travel. controls the rate at which we accelerate and drive.
  * @param max_speed  the maximum percentage of robot speed at which the robot will travel. 1 = full power
+ * @param end_speed  the speed (inches/second) the robot should still be moving at when it reaches the target
  */
-bool TankDrive::drive_forward(double inches, directionType dir, Feedback &feedback, double max_speed)
+bool TankDrive::drive_forward(double inches, directionType dir, Feedback &feedback, double max_speed, double end_speed)
 {
-  static pose_t pos_setpt;
+  return drive_forward(default_motion, inches, dir, feedback, max_speed, end_speed);
+}
 
+/**
+ * Use odometry to drive forward a certain distance using a custom feedback controller,
+ * keeping the movement's state in `motion`
+ * @param motion     the state of this movement
+ * @param inches     the distance to drive forward
+ * @param dir        the direction we want to travel forward and backward
+ * @param feedback   the custom feedback controller we will use to travel. controls the rate at which we accelerate and drive.
+ * @param max_speed  the maximum percentage of robot speed at which the robot will travel. 1 = full power
+ * @param end_speed  the speed (inches/second) the robot should still be moving at when it reaches the target
+ * @return true when we have reached our target distance
+ */
+bool TankDrive::drive_forward(drive_motion_t &motion, double inches, directionType dir, Feedback &feedback, double max_speed, double end_speed)
+{
   // We can't run the auto drive function without odometry
   if(odometry == NULL)
   {
@@ -88,28 +176,11 @@ bool TankDrive::drive_forward(double inches, directionType dir, Feedback &feedba
   }
 
   // Generate a point X inches forward of the current position, on first startup
-  if (!func_initialized)
-  {
-    pose_t cur_pos = odometry->get_position();
-
-    // forwards is positive Y axis, backwards is negative
-    if (dir == directionType::rev)
-      inches = -fabs(inches);
-    else
-      inches = fabs(inches);
-
-    // Use vector math to get an X and Y
-    Vector2D cur_pos_vec({.x=cur_pos.x , .y=cur_pos.y});
-    Vector2D delta_pos_vec(deg2rad(cur_pos.rot), inches);
-    Vector2D setpt_vec = cur_pos_vec + delta_pos_vec;
-
-    // Save the new X and Y values
-    pos_setpt = {.x=setpt_vec.get_x(), .y=setpt_vec.get_y()};
-
-  }
+  if (!motion.initialized)
+    motion.target = forward_target(inches, dir);
 
   // Call the drive_to_point with updated point values
-  return drive_to_point(pos_setpt.x, pos_setpt.y, dir, feedback, max_speed);
+  return drive_to_point(motion, motion.target.x, motion.target.y, dir, feedback, max_speed, end_speed);
 }
 /**
  * Autonomously drive the robot forward a certain distance
@@ -118,12 +189,13 @@ bool TankDrive::drive_forward(double inches, directionType dir, Feedback &feedba
  * @param inches      degrees by which we will turn relative to the robot (+) turns ccw, (-) turns cw
  * @param dir        the direction we want to travel forward and backward
  * @param max_speed   the maximum percentage of robot speed at which the robot will travel. 1 = full power
+ * @param end_speed   the speed (inches/second) the robot should still be moving at when it reaches the target
  * @return true if we have finished driving to our point
  */
-bool TankDrive::drive_forward(double inches, directionType dir, double max_speed)
+bool TankDrive::drive_forward(double inches, directionType dir, double max_speed, double end_speed)
 {
   if(drive_default_feedback != NULL)
-    return drive_forward(inches, dir, *drive_default_feedback, max_speed);
+    return drive_forward(inches, dir, *drive_default_feedback, max_speed, end_speed);
 
   printf("tank_drive.cpp: Cannot run drive_forward without a feedback controller!\n");
   fflush(stdout);
@@ -142,6 +214,20 @@ bool TankDrive::drive_forward(double inches, directionType dir, double max_speed
  * @return true if we have turned our target number of degrees
  */
 bool TankDrive::turn_degrees(double degrees, Feedback &feedback, double max_speed)
+{
+  return turn_degrees(default_motion, degrees, feedback, max_speed);
+}
+
+/**
+ * Autonomously turn the robot X degrees to counterclockwise (negative for clockwise), keeping the movement's
+ * state in `motion`
+ * @param motion      the state of this movement
+ * @param degrees     degrees by which we will turn relative to the robot (+) turns ccw, (-) turns cw
+ * @param feedback    the feedback controller we will use to travel. controls the rate at which we accelerate and drive.
+ * @param max_speed   the maximum percentage of robot speed at which the robot will travel. 1 = full power
+ * @return true if we have turned our target number of degrees
+ */
+bool TankDrive::turn_degrees(drive_motion_t &motion, double degrees, Feedback &feedback, double max_speed)
 {
   // We can't run the auto drive function without odometry
   if(odometry == NULL)
@@ -151,17 +237,15 @@ bool TankDrive::turn_degrees(double degrees, Feedback &feedback, double max_spee
     return true;
   }
 
-  static double target_heading = 0;
-
   // On the first run of the funciton, reset the gyro position and PID
-  if (!func_initialized)
+  if (!motion.initialized)
   {
     double start_heading = odometry->get_position().rot;
-    target_heading = start_heading + degrees;
+    motion.target_heading = start_heading + degrees;
 
   }
 
-  return turn_to_heading(target_heading);
+  return turn_to_heading(motion, motion.target_heading, feedback, max_speed);
 }
 
 /**
@@ -194,9 +278,26 @@ bool TankDrive::turn_degrees(double degrees, double max_speed)
   * @param dir        the direction we want to travel forward and backward
   * @param feedback   the feedback controller we will use to travel. controls the rate at which we accelerate and drive.
   * @param max_speed  the maximum percentage of robot speed at which the robot will travel. 1 = full power
+  * @param end_speed  the speed (inches/second) the robot should still be moving at when it reaches the point
   * @return true if we have reached our target point
   */
-bool TankDrive::drive_to_point(double x, double y, vex::directionType dir, Feedback &feedback, double max_speed)
+bool TankDrive::drive_to_point(double x, double y, vex::directionType dir, Feedback &feedback, double max_speed, double end_speed)
+{
+  return drive_to_point(default_motion, x, y, dir, feedback, max_speed, end_speed);
+}
+
+/**
+  * Use odometry to automatically drive the robot to a point on the field, keeping the movement's state in `motion`
+  * @param motion     the state of this movement
+  * @param x          the x position of the target
+  * @param y          the y position of the target
+  * @param dir        the direction we want to travel forward and backward
+  * @param feedback   the feedback controller we will use to travel. controls the rate at which we accelerate and drive.
+  * @param max_speed  the maximum percentage of robot speed at which the robot will travel. 1 = full power
+  * @param end_speed  the speed (inches/second) the robot should still be moving at when it reaches the point
+  * @return true if we have reached our target point
+  */
+bool TankDrive::drive_to_point(drive_motion_t &motion, double x, double y, vex::directionType dir, Feedback &feedback, double max_speed, double end_speed)
 {
   // We can't run the auto drive function without odometry
   if(odometry == NULL)
@@ -206,19 +307,28 @@ bool TankDrive::drive_to_point(double x, double y, vex::directionType dir, Feedb
     return true;
   }
   
-  if(!func_initialized)
+  if(!motion.initialized)
   {
     
-    double initial_dist = OdometryBase::pos_diff(odometry->get_position(), {.x=x, .y=y});
+    pose_t start_pos = odometry->get_position();
+    double initial_dist = OdometryBase::pos_diff(start_pos, {.x=x, .y=y});
+
+    // If the last movement was blended into this one, start the profile at the speed we're already moving,
+    // minus whatever isn't pointed towards the new point.
+    double heading_to_point = rad2deg(atan2(y - start_pos.y, x - start_pos.x));
+    double travel_heading = (dir == directionType::fwd) ? start_pos.rot : start_pos.rot - 180;
+    double start_vel = motion.handoff_speed * fmax(cos(deg2rad(OdometryBase::smallest_angle(travel_heading, heading_to_point))), 0);
+    motion.handoff_speed = 0;
 
     // Reset the control loops
-    correction_pid.init(0, 0);
-    feedback.init(-initial_dist, 0);
+    motion.correction_cfg = config.correction_pid;
+    motion.correction_pid.init(0, 0);
+    feedback.init(-initial_dist, 0, start_vel, fabs(end_speed));
 
-    correction_pid.set_limits(-1, 1);
+    motion.correction_pid.set_limits(-1, 1);
     feedback.set_limits(-1, 1);
 
-    func_initialized = true;
+    motion.initialized = true;
   }
 
   // Store the initial position of the robot
@@ -274,13 +384,13 @@ bool TankDrive::drive_to_point(double x, double y, vex::directionType dir, Feedb
     delta_heading = OdometryBase::smallest_angle(current_pos.rot - 180, heading);
 
   // Update the PID controllers with new information
-  correction_pid.update(delta_heading);
+  motion.correction_pid.update(delta_heading);
   feedback.update(sign * -1 * dist_left);
 
   // Disable correction when we're close enough to the point
   double correction = 0;
-  if(is_pure_pursuit || fabs(dist_left) > config.drive_correction_cutoff)
-    correction = correction_pid.get();
+  if(motion.is_pure_pursuit || fabs(dist_left) > config.drive_correction_cutoff)
+    correction = motion.correction_pid.get();
 
   // Reverse the drive_pid output if we're going backwards
   double drive_pid_rval;
@@ -302,9 +412,15 @@ bool TankDrive::drive_to_point(double x, double y, vex::directionType dir, Feedb
   // Check if the robot has reached it's destination
   if(feedback.is_on_target())
   {
-    stop();
-    func_initialized = false;
-    stop();
+    motion.initialized = false;
+
+    // Blended movements keep driving, and hand their speed off to the next movement. The movement keeps it until
+    // it runs again, or its owner passes it on to the next movement's drive_motion_t
+    if(end_speed == 0)
+      stop();
+    else
+      motion.handoff_speed = fabs(end_speed);
+
     return true;
   }
 
@@ -321,18 +437,183 @@ bool TankDrive::drive_to_point(double x, double y, vex::directionType dir, Feedb
   * @param y          the y position of the target
   * @param dir        the direction we want to travel forward and backward
   * @param max_speed  the maximum percentage of robot speed at which the robot will travel. 1 = full power
+  * @param end_speed  the speed (inches/second) the robot should still be moving at when it reaches the point
   * @return true if we have reached our target point
   */
-bool TankDrive::drive_to_point(double x, double y, vex::directionType dir, double max_speed)
+bool TankDrive::drive_to_point(double x, double y, vex::directionType dir, double max_speed, double end_speed)
 {
   if(drive_default_feedback != NULL)
-    return this->drive_to_point(x, y, dir, *drive_default_feedback, max_speed);
+    return this->drive_to_point(x, y, dir, *drive_default_feedback, max_speed, end_speed);
 
   printf("tank_drive.cpp: Cannot run drive_to_point without a feedback controller!\n");
   fflush(stdout);
   return true;
 }
 
+/**
+ * Length of the circular arc, tangent to `tangent_deg`, between the start and end of a chord.
+ * (The arc turns through twice the angle between the tangent and the chord)
+ */
+static double arc_length_to(double chord, double tangent_deg, double chord_deg)
+{
+  double half_angle = deg2rad(OdometryBase::smallest_angle(tangent_deg, chord_deg));
+  if (fabs(half_angle) < 1e-6)
+    return chord;
+
+  return chord * half_angle / sin(half_angle);
+}
+
+/**
+ * How much drive_arc_to_point slows its motion profile down, so the outside wheels never need more than full power
+ * @param feedback the motion profile the arc is driven with
+ * @param arc_angle the total change in heading along the arc (degrees)
+ * @param arc_length the length of the arc (inches)
+ * @return the fraction (0 -> 1.0) of the profile's max_v and accel the arc uses
+ */
+double TankDrive::arc_speed_scale(MotionController &feedback, double arc_angle, double arc_length)
+{
+  // The outside wheels get (1 + curvature * width / 2) times the profile's output. Only slow down if that
+  // would go over full power at the profile's peak, since a profile's max_v usually leaves headroom already
+  double curvature = (arc_length > 0) ? deg2rad(arc_angle) / arc_length : 0;
+  double outside_peak = feedback.peak_ff_output() * (1.0 + fabs(curvature) * config.dist_between_wheels / 2.0);
+  return (outside_peak > 1.0) ? 1.0 / outside_peak : 1.0;
+}
+
+/**
+ * Use odometry to drive the robot to a point on the field along a circular arc, starting tangent to the robot's
+ * current heading. Turning and driving are planned together, from the same motion profile.
+ * The arc is longer than a straight line, so to just reach the point drive_to_point() is faster. Use the arc when
+ * the robot should also end up facing along it: that's faster than drive_to_point() then turn_to_heading().
+ *
+ * @param x          the x position of the target
+ * @param y          the y position of the target
+ * @param dir        the direction we want to travel forward and backward
+ * @param feedback   the motion profile we will use to travel along the arc
+ * @param max_speed  the maximum percentage of robot speed at which the robot will travel. 1 = full power
+ * @return true if we have reached our target point
+ */
+bool TankDrive::drive_arc_to_point(double x, double y, vex::directionType dir, MotionController &feedback, double max_speed)
+{
+  return drive_arc_to_point(default_motion, x, y, dir, feedback, max_speed);
+}
+
+/**
+ * Drive the robot to a point on the field along a circular arc, keeping the movement's state in `motion`
+ *
+ * @param motion     the state of this movement
+ * @param x          the x position of the target
+ * @param y          the y position of the target
+ * @param dir        the direction we want to travel forward and backward
+ * @param feedback   the motion profile we will use to travel along the arc
+ * @param max_speed  the maximum percentage of robot speed at which the robot will travel. 1 = full power
+ * @return true if we have reached our target point
+ */
+bool TankDrive::drive_arc_to_point(drive_motion_t &motion, double x, double y, vex::directionType dir, MotionController &feedback, double max_speed)
+{
+  // We can't run the auto drive function without odometry
+  if(odometry == NULL)
+  {
+    fprintf(stderr, "Odometry is NULL. Unable to run drive_arc_to_point()\n");
+    fflush(stderr);
+    return true;
+  }
+
+  if(!motion.initialized && !motion.arc_fallback)
+  {
+    pose_t start_pos = odometry->get_position();
+    double chord = OdometryBase::pos_diff(start_pos, {.x=x, .y=y});
+    double chord_heading = rad2deg(atan2(y - start_pos.y, x - start_pos.x));
+
+    // Going backwards "flips" the robot's heading of travel
+    motion.arc_start_heading = (dir == directionType::fwd) ? start_pos.rot : start_pos.rot - 180;
+    double half_angle = OdometryBase::smallest_angle(motion.arc_start_heading, chord_heading);
+
+    // A point behind the robot would need more than a half circle to reach. Just drive to it normally.
+    if (fabs(half_angle) >= 90)
+    {
+      motion.arc_fallback = true;
+      return drive_to_point(motion, x, y, dir, feedback, max_speed);
+    }
+
+    motion.arc_angle = 2 * half_angle;
+    motion.arc_length = arc_length_to(chord, motion.arc_start_heading, chord_heading);
+
+    // Leave room in the profile for the outside wheels, which travel faster than the center of the robot
+    feedback.scale_next_movement(arc_speed_scale(feedback, motion.arc_angle, motion.arc_length));
+
+    motion.correction_cfg = config.correction_pid;
+    motion.correction_pid.init(0, 0);
+    feedback.init(-motion.arc_length, 0);
+
+    motion.correction_pid.set_limits(-1, 1);
+    feedback.set_limits(-1, 1);
+
+    motion.initialized = true;
+  }
+
+  if (motion.arc_fallback)
+  {
+    if (drive_to_point(motion, x, y, dir, feedback, max_speed))
+    {
+      motion.arc_fallback = false;
+      return true;
+    }
+    return false;
+  }
+
+  pose_t current_pos = odometry->get_position();
+  double travel_heading = (dir == directionType::fwd) ? current_pos.rot : current_pos.rot - 180;
+  double dist_left = OdometryBase::pos_diff(current_pos, {.x=x, .y=y});
+  double chord_heading = rad2deg(atan2(y - current_pos.y, x - current_pos.x));
+
+  // Distance left along the arc, or along the robot's forward axis when we're too close for the heading to matter.
+  // Once the point is beside or behind the robot there is no arc to it, and the distance along the forward axis
+  // goes negative, to back up to it
+  double half_angle = OdometryBase::smallest_angle(travel_heading, chord_heading);
+  double arc_left;
+  bool close_to_point = dist_left < config.drive_correction_cutoff;
+  if (close_to_point || fabs(half_angle) >= 90)
+    arc_left = dist_left * cos(deg2rad(half_angle));
+  else
+    arc_left = arc_length_to(dist_left, travel_heading, chord_heading);
+
+  feedback.update(-arc_left);
+
+  // The heading setpoint comes from how far along the arc the profile says we should be, so both axes share
+  // the profile's time base. Curvature is constant, so heading is linear with distance.
+  double progress = (motion.arc_length > 0) ? clamp((motion.arc_length + feedback.get_motion().pos) / motion.arc_length, 0, 1) : 1;
+  double heading_setpt = motion.arc_start_heading + (motion.arc_angle * progress);
+
+  motion.correction_pid.update(OdometryBase::smallest_angle(travel_heading, heading_setpt));
+
+  double drive_out = (dir == directionType::rev) ? -feedback.get() : feedback.get();
+
+  // Feed forward the turn: the wheel speeds of a constant curvature arc are v * (1 +/- curvature * width / 2).
+  // The curvature is of the arc from where the robot is now, so if it drifts off the planned arc it steers back
+  // to the point instead of following the plan past it
+  double turn_ff = 0, correction = 0;
+  if (!close_to_point && fabs(half_angle) < 90)
+  {
+    double curvature = 2.0 * sin(deg2rad(half_angle)) / dist_left;
+    turn_ff = fabs(drive_out) * curvature * config.dist_between_wheels / 2.0;
+    correction = motion.correction_pid.get();
+  }
+
+  double lside = clamp(drive_out - turn_ff + correction, -1, 1);
+  double rside = clamp(drive_out + turn_ff - correction, -1, 1);
+
+  drive_tank(lside, rside);
+
+  if(feedback.is_on_target())
+  {
+    motion.initialized = false;
+    stop();
+    return true;
+  }
+
+  return false;
+}
+
 /**
  * Turn the robot in place to an exact heading relative to the field.
  * 0 is forward.
@@ -343,6 +624,20 @@ bool TankDrive::drive_to_point(double x, double y, vex::directionType dir, doubl
  * @return true if we have reached our target heading
  */
 bool TankDrive::turn_to_heading(double heading_deg, Feedback &feedback, double max_speed)
+{
+  return turn_to_heading(default_motion, heading_deg, feedback, max_speed);
+}
+
+/**
+ * Turn the robot in place to an exact heading relative to the field, keeping the movement's state in `motion`
+ * 
+ * @param motion      the state of this movement
+ * @param heading_deg the heading to which we will turn 
+ * @param feedback    the feedback controller we will use to travel. controls the rate at which we accelerate and drive.
+ * @param max_speed  the maximum percentage of robot speed at which the robot will travel. 1 = full power
+ * @return true if we have reached our target heading
+ */
+bool TankDrive::turn_to_heading(drive_motion_t &motion, double heading_deg, Feedback &feedback, double max_speed)
 {
   // We can't run the auto drive function without odometry
   if(odometry == NULL)
@@ -352,13 +647,13 @@ bool TankDrive::turn_to_heading(double heading_deg, Feedback &feedback, double m
     return true;
   }
 
-  if(!func_initialized)
+  if(!motion.initialized)
   {
     double initial_delta = OdometryBase::smallest_angle(odometry->get_position().rot, heading_deg);
     feedback.init(-initial_delta, 0);
     feedback.set_limits(-fabs(max_speed), fabs(max_speed));
 
-    func_initialized = true;
+    motion.initialized = true;
   }
 
   // Get the difference between the new heading and the current, and decide whether to turn left or right.
@@ -372,7 +667,7 @@ bool TankDrive::turn_to_heading(double heading_deg, Feedback &feedback, double m
   // When the robot has reached it's angle, return true.
   if(feedback.is_on_target())
   {
-    func_initialized = false;
+    motion.initialized = false;
     stop();
     return true;
   }
@@ -411,7 +706,24 @@ double TankDrive::modify_inputs(double input, int power)
 
 bool TankDrive::pure_pursuit(std::vector<PurePursuit::hermite_point> path, directionType dir, double radius, double res, Feedback &feedback, double max_speed) 
 {
-  is_pure_pursuit = true;
+  return pure_pursuit(default_motion, path, dir, radius, res, feedback, max_speed);
+}
+
+/**
+ * Follow a hermite curve using the pure pursuit algorithm, keeping the movement's state in `motion`
+ * 
+ * @param motion the state of this movement
+ * @param path The hermite curve for the robot to take. Must have 2 or more points.
+ * @param dir Whether the robot should move forward or backwards
+ * @param radius How the pure pursuit radius, in inches, for finding the lookahead point
+ * @param res The number of points to use along the path; the hermite curve is split up into "res" individual points.
+ * @param feedback The feedback controller to use
+ * @param max_speed Robot's maximum speed throughout the path, between 0 and 1.0
+ * @return true when we reach the end of the path
+ */
+bool TankDrive::pure_pursuit(drive_motion_t &motion, std::vector<PurePursuit::hermite_point> path, directionType dir, double radius, double res, Feedback &feedback, double max_speed) 
+{
+  motion.is_pure_pursuit = true;
   std::vector<point_t> smoothed_path = PurePursuit::smooth_path_hermite(path, res);
 
   point_t lookahead = PurePursuit::get_lookahead(smoothed_path, {odometry->get_position().x, odometry->get_position().y}, radius);
@@ -420,9 +732,9 @@ bool TankDrive::pure_pursuit(std::vector<PurePursuit::hermite_point> path, direc
   bool is_last_point = (path.back().x == lookahead.x) && (path.back().y == lookahead.y);
 
   if(is_last_point)
-    is_pure_pursuit = false;
+    motion.is_pure_pursuit = false;
 
-  bool retval = drive_to_point(lookahead.x, lookahead.y, dir, feedback, max_speed);
+  bool retval = drive_to_point(motion, lookahead.x, lookahead.y, dir, feedback, max_speed);
 
   if(is_last_point)
     return retval;
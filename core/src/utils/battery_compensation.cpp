@@ -0,0 +1,136 @@
+#include "../core/include/utils/battery_compensation.h"
+#include "../core/include/utils/math_util.h"
+
+// The most a motor will accept, in volts
+#define MAX_MOTOR_VOLTS 12.0
+
+// Don't trust readings that would make the compensation this far off from 1.
+// A brownout or a bad reading shouldn't send full power to the motors.
+#define MIN_SCALE 0.8
+#define MAX_SCALE 1.25
+
+vex::brain::battery *BatteryCompensation::battery = NULL;
+Logger *BatteryCompensation::logger = NULL;
+vex::task *BatteryCompensation::task = NULL;
+
+double BatteryCompensation::nominal_volts = 12.0;
+double BatteryCompensation::filter_time = 0.5;
+int BatteryCompensation::period_ms = 20;
+
+double BatteryCompensation::filtered_volts = 12.0;
+double BatteryCompensation::scale = 1.0;
+
+/**
+ * Start sampling the battery in the background.
+ *
+ * @param battery       the brain's battery (Brain.Battery)
+ * @param nominal_volts the battery voltage that feedforward / tuning constants were found at
+ * @param filter_time   time constant (seconds) of the low-pass filter on the battery voltage
+ * @param period_ms     time between battery samples, in milliseconds
+ * @param logger        if not NULL, the filtered voltage and scale are logged here about once a second
+ */
+void BatteryCompensation::start(vex::brain::battery &battery, double nominal_volts, double filter_time, int period_ms, Logger *logger)
+{
+  stop();
+
+  BatteryCompensation::battery = &battery;
+  BatteryCompensation::nominal_volts = nominal_volts;
+  BatteryCompensation::filter_time = filter_time;
+  BatteryCompensation::period_ms = (period_ms > 0) ? period_ms : 20;
+  BatteryCompensation::logger = logger;
+
+  // Start the filter at the current reading instead of waiting for it to settle
+  filtered_volts = battery.voltage(vex::voltageUnits::volt);
+  if (filtered_volts <= 0)
+    filtered_volts = nominal_volts;
+  scale = clamp(nominal_volts / filtered_volts, MIN_SCALE, MAX_SCALE);
+
+  task = new vex::task(sample_task, NULL);
+}
+
+/**
+ * Stop sampling the battery, and stop compensating outputs
+ */
+void BatteryCompensation::stop()
+{
+  if (task != NULL)
+  {
+    task->stop();
+    delete task;
+    task = NULL;
+  }
+
+  battery = NULL;
+  filtered_volts = nominal_volts;
+  scale = 1.0;
+}
+
+/**
+ * @return the filtered battery voltage. the nominal voltage if we aren't sampling
+ */
+double BatteryCompensation::get_voltage()
+{
+  return filtered_volts;
+}
+
+/**
+ * @return what voltage commands are multiplied by: nominal voltage / battery voltage
+ */
+double BatteryCompensation::get_scale()
+{
+  return scale;
+}
+
+/**
+ * Compensate a voltage command for the current battery voltage
+ *
+ * @param volts the voltage we want the motor to act like it's getting, as if the battery were at nominal
+ * @return the voltage to command the motor with, limited to what the motors will accept (+/- 12V)
+ */
+double BatteryCompensation::volts(double volts)
+{
+  return clamp(volts * scale, -MAX_MOTOR_VOLTS, MAX_MOTOR_VOLTS);
+}
+
+/**
+ * Convert a "percent" output (-1.0 -> 1.0) to a compensated voltage command
+ *
+ * @param pct the percentage of full power
+ * @return the voltage to command the motor with
+ */
+double BatteryCompensation::percent_to_volts(double pct)
+{
+  return volts(pct * MAX_MOTOR_VOLTS);
+}
+
+/**
+ * Background task that samples and filters the battery voltage
+ */
+int BatteryCompensation::sample_task(void *)
+{
+  double dt = period_ms / 1000.0;
+  double alpha = (filter_time > 0) ? dt / (filter_time + dt) : 1.0;
+  int log_counter = 0;
+
+  while (battery != NULL)
+  {
+    double reading = battery->voltage(vex::voltageUnits::volt);
+
+    // The battery can read 0 for a moment while the brain is starting up
+    if (reading > 0)
+    {
+      filtered_volts += alpha * (reading - filtered_volts);
+      scale = clamp(nominal_volts / filtered_volts, MIN_SCALE, MAX_SCALE);
+    }
+
+    if (logger != NULL && ++log_counter * period_ms >= 1000)
+    {
+      logger->Logf(TIME, "battery: %.2fV filtered: %.2fV scale: %.3f\n", reading, filtered_volts, scale);
+      log_counter = 0;
+    }
+
+    vexDelay(period_ms);
+  }
+
+  return 0;
+}
@@ -0,0 +1,512 @@
+/**
+ * File: auto_script.cpp
+ * Desc:
+ *    An AutoScript builds a CommandController from a text file on the SD card.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include "../core/include/utils/command_structure/auto_script.h"
+#include "../core/include/utils/command_structure/command_groups.h"
+
+#define CACHE_MAGIC 0x41534331 // "ASC1"
+#define CACHE_VERSION 1
+
+/**
+ * FNV-1a, to tell if the script or verbs changed since the cache was made
+ */
+static uint32_t fnv1a(uint32_t hash, const char *data, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    hash ^= (uint8_t)data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static const uint32_t FNV_START = 2166136261u;
+
+/**
+ * Read a whole file off the SD card
+ * @return true if the file exists and was read
+ */
+static bool read_file(vex::brain::sdcard &sd, const std::string &filename, std::string &out)
+{
+  int32_t size = sd.size(filename.c_str());
+  if (size <= 0)
+    return false;
+
+  out.resize(size);
+  return sd.loadfile(filename.c_str(), (uint8_t *)&out[0], size) == size;
+}
+
+/**
+ * Create a script loader
+ * @param verbs the commands the script can use
+ * @param keywords the words that can be used in place of numbers
+ * @param factory makes the command for each line
+ */
+AutoScript::AutoScript(std::vector<verb_t> verbs, std::vector<keyword_t> keywords, factory_t factory)
+    : verbs(verbs), keywords(keywords), factory(factory) {}
+
+/**
+ * Load a script from the SD card, from its cache if it's up to date. Otherwise the script is parsed, and the
+ * cache is written for next time
+ * @param filename the script's file name
+ * @param allow_cache_only if true and the script is missing, run from its cache anyway. The cache can't be
+ *                         checked against anything, so it may be an old version of the route
+ * @return true if the script was loaded without errors
+ */
+bool AutoScript::load(const std::string &filename, bool allow_cache_only)
+{
+  errors.clear();
+  from_cache = false;
+
+  vex::brain::sdcard sd;
+  if (!sd.isInserted())
+  {
+    error(0, "no SD card");
+    return false;
+  }
+
+  std::string cache_name = filename + ".bin";
+  std::string text, cache;
+  bool have_text = read_file(sd, filename, text);
+  bool have_cache = read_file(sd, cache_name, cache);
+
+  if (!have_text)
+  {
+    // A leftover cache could be any old version of the route, so only run it if that was asked for
+    if (allow_cache_only && have_cache && load_cache(cache, false, 0))
+    {
+      printf("(auto_script.cpp): Warning - %s not found, running from %s\n", filename.c_str(), cache_name.c_str());
+      from_cache = true;
+      return true;
+    }
+
+    error(0, "%s not found", filename.c_str());
+    return false;
+  }
+
+  uint32_t source_hash = fnv1a(FNV_START, text.c_str(), text.size());
+
+  if (have_cache && load_cache(cache, true, source_hash))
+  {
+    from_cache = true;
+    return true;
+  }
+
+  if (!parse(text))
+    return false;
+
+  std::string new_cache = make_cache(source_hash);
+  sd.savefile(cache_name.c_str(), (uint8_t *)new_cache.c_str(), new_cache.size());
+  return true;
+}
+
+/**
+ * Parse a script
+ * @param text the whole script
+ * @return true if it parsed without errors
+ */
+bool AutoScript::parse(const std::string &text)
+{
+  instructions.clear();
+  args.clear();
+  errors.clear();
+
+  // Open groups: the instruction that started them, and how many commands are in them so far
+  struct open_group_t
+  {
+    size_t start;
+    int children;
+  };
+  std::vector<open_group_t> groups;
+
+  int line_num = 0;
+  size_t pos = 0;
+  while (pos < text.size())
+  {
+    size_t eol = text.find('\n', pos);
+    if (eol == std::string::npos)
+      eol = text.size();
+    std::string line = text.substr(pos, eol - pos);
+    pos = eol + 1;
+    line_num++;
+
+    size_t comment = line.find('#');
+    if (comment != std::string::npos)
+      line.erase(comment);
+
+    // Split into words
+    std::vector<std::string> tokens;
+    char *save = NULL;
+    for (char *tok = strtok_r(&line[0], " \t\r,", &save); tok != NULL; tok = strtok_r(NULL, " \t\r,", &save))
+      tokens.push_back(tok);
+    if (tokens.empty())
+      continue;
+
+    std::string name = tokens[0];
+    for (size_t i = 0; i < name.size(); i++)
+      name[i] = tolower(name[i]);
+
+    instruction_t ins = {.verb = 0, .line = (uint16_t)line_num, .argc = 0, .first_arg = (uint16_t)args.size(), .timeout = -1};
+
+    if (name == "end")
+    {
+      if (groups.empty())
+      {
+        error(line_num, "end without a group");
+        continue;
+      }
+      if (groups.back().children == 0)
+        error(line_num, "empty group");
+      groups.pop_back();
+
+      ins.verb = END;
+      instructions.push_back(ins);
+      continue;
+    }
+
+    bool is_group = true;
+    if (name == "parallel")
+      ins.verb = PARALLEL;
+    else if (name == "race")
+      ins.verb = RACE;
+    else if (name == "deadline")
+      ins.verb = DEADLINE;
+    else
+    {
+      is_group = false;
+      int found = -1;
+      for (size_t i = 0; i < verbs.size(); i++)
+        if (name == verbs[i].name)
+          found = i;
+
+      if (found < 0)
+      {
+        error(line_num, "unknown command '%s'", tokens[0].c_str());
+        continue;
+      }
+      ins.verb = found;
+    }
+
+    // Arguments, and the timeout
+    bool ok = true;
+    for (size_t i = 1; i < tokens.size(); i++)
+    {
+      const char *tok = tokens[i].c_str();
+      char *end = NULL;
+
+      if (tok[0] == '@')
+      {
+        ins.timeout = strtof(tok + 1, &end);
+        if (end == tok + 1 || *end != '\0' || ins.timeout < 0)
+        {
+          error(line_num, "bad timeout '%s'", tok);
+          ok = false;
+        }
+        continue;
+      }
+
+      float val = strtof(tok, &end);
+      if (end == tok || *end != '\0')
+      {
+        bool found = false;
+        for (size_t k = 0; k < keywords.size() && !found; k++)
+        {
+          if (strcmp(tok, keywords[k].name) == 0)
+          {
+            val = keywords[k].value;
+            found = true;
+          }
+        }
+        if (!found)
+        {
+          error(line_num, "'%s' isn't a number or keyword", tok);
+          ok = false;
+          continue;
+        }
+      }
+
+      args.push_back(val);
+      ins.argc++;
+    }
+
+    if (is_group && ins.argc > 0)
+    {
+      error(line_num, "%s only takes a timeout", name.c_str());
+      ok = false;
+    }
+    else if (!is_group)
+    {
+      const verb_t &v = verbs[ins.verb];
+      if (ins.argc < v.min_args || (v.max_args >= 0 && ins.argc > v.max_args))
+      {
+        if (v.min_args == v.max_args)
+          error(line_num, "%s takes %d arguments, got %d", v.name, v.min_args, ins.argc);
+        else
+          error(line_num, "%s takes %d to %d arguments, got %d", v.name, v.min_args, v.max_args, ins.argc);
+        ok = false;
+      }
+    }
+
+    // A bad group still opens, so its end doesn't cause more errors
+    if (!ok)
+    {
+      args.resize(ins.first_arg);
+      ins.argc = 0;
+      if (!is_group)
+        continue;
+    }
+
+    if (!groups.empty())
+      groups.back().children++;
+    if (is_group)
+      groups.push_back({.start = instructions.size(), .children = 0});
+
+    instructions.push_back(ins);
+  }
+
+  for (open_group_t &g : groups)
+    error(instructions[g.start].line, "group is missing its end");
+
+  return errors.empty();
+}
+
+/**
+ * Make the script's commands and add them to a controller, in the controller's arena
+ * @param controller the controller to add to
+ * @return true if every command was made
+ */
+bool AutoScript::build(CommandController &controller)
+{
+  CommandArena::Scope arena_scope(controller.get_arena());
+
+  size_t i = 0;
+  while (i < instructions.size())
+  {
+    float timeout = instructions[i].timeout;
+    AutoCommand *cmd = build_one(i);
+    if (cmd != NULL)
+      controller.add(cmd, (timeout >= 0) ? timeout : AutoCommand::default_timeout);
+  }
+
+  return errors.empty();
+}
+
+/**
+ * Make the command for the instruction at i, and move i past it (and past the whole group, for groups)
+ */
+AutoCommand *AutoScript::build_one(size_t &i)
+{
+  instruction_t ins = instructions[i++];
+
+  if (ins.verb >= 0)
+  {
+    AutoCommand *cmd = factory(ins.verb, args.data() + ins.first_arg, ins.argc);
+    if (cmd == NULL)
+      error(ins.line, "can't make %s with those arguments", verbs[ins.verb].name);
+    return cmd;
+  }
+
+  std::vector<AutoCommand *> children;
+  while (i < instructions.size() && instructions[i].verb != END)
+  {
+    float timeout = instructions[i].timeout;
+    AutoCommand *child = build_one(i);
+    if (child == NULL)
+      continue;
+    if (timeout >= 0)
+      child->timeout_seconds = timeout;
+    children.push_back(child);
+  }
+  i++; // past the END
+
+  if (children.empty())
+    return NULL;
+
+  CommandGroup *group;
+  if (ins.verb == PARALLEL)
+    group = new ParallelGroup(children);
+  else if (ins.verb == RACE)
+    group = new RaceGroup(children);
+  else
+  {
+    AutoCommand *deadline = children[0];
+    children.erase(children.begin());
+    group = new DeadlineGroup(deadline, children);
+  }
+
+  if (!group->is_valid())
+    error(ins.line, "two commands in this group need the same subsystem");
+  return group;
+}
+
+/**
+ * @return every error from the last load, parse or build, as "line N: what's wrong"
+ */
+std::vector<std::string> AutoScript::get_errors()
+{
+  return errors;
+}
+
+/**
+ * @return true if the last load came from the cache instead of parsing the script
+ */
+bool AutoScript::is_from_cache()
+{
+  return from_cache;
+}
+
+/**
+ * @return the number of lines the script compiled to (including group starts and ends)
+ */
+int AutoScript::get_num_instructions()
+{
+  return instructions.size();
+}
+
+/**
+ * Check that the instructions make sense: verbs and arguments in range, groups closed and not empty
+ */
+bool AutoScript::validate()
+{
+  std::vector<int> children;
+  for (const instruction_t &ins : instructions)
+  {
+    if (ins.verb == END)
+    {
+      if (children.empty() || children.back() == 0)
+        return false;
+      children.pop_back();
+      continue;
+    }
+
+    if (ins.verb < DEADLINE || ins.verb >= (int)verbs.size())
+      return false;
+    if ((size_t)ins.first_arg + ins.argc > args.size())
+      return false;
+
+    if (!children.empty())
+      children.back()++;
+
+    if (ins.verb < 0)
+    {
+      if (ins.argc != 0)
+        return false;
+      children.push_back(0);
+    }
+    else
+    {
+      const verb_t &v = verbs[ins.verb];
+      if (ins.argc < v.min_args || (v.max_args >= 0 && ins.argc > v.max_args))
+        return false;
+    }
+  }
+
+  return children.empty();
+}
+
+/**
+ * Load the instructions from a cache file, if it's valid
+ * @param data the cache file
+ * @param check_source if true, the cache must have been made from the script with source_hash
+ * @param source_hash hash of the script
+ * @return true if the cache was loaded
+ */
+bool AutoScript::load_cache(const std::string &data, bool check_source, uint32_t source_hash)
+{
+  cache_header_t header;
+  if (data.size() < sizeof(header))
+    return false;
+  memcpy(&header, data.data(), sizeof(header));
+
+  if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.verb_hash != hash_verbs())
+    return false;
+  if (check_source && header.source_hash != source_hash)
+    return false;
+
+  size_t expected = sizeof(header) + (header.num_instructions * sizeof(instruction_t)) + (header.num_args * sizeof(float));
+  if (data.size() != expected)
+    return false;
+
+  const char *p = data.data() + sizeof(header);
+  instructions.resize(header.num_instructions);
+  args.resize(header.num_args);
+  if (header.num_instructions > 0)
+    memcpy(instructions.data(), p, header.num_instructions * sizeof(instruction_t));
+  p += header.num_instructions * sizeof(instruction_t);
+  if (header.num_args > 0)
+    memcpy(args.data(), p, header.num_args * sizeof(float));
+
+  if (!validate())
+  {
+    instructions.clear();
+    args.clear();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @return the cache file for the current instructions
+ */
+std::string AutoScript::make_cache(uint32_t source_hash)
+{
+  cache_header_t header = {.magic = CACHE_MAGIC,
+                           .version = CACHE_VERSION,
+                           .verb_hash = hash_verbs(),
+                           .source_hash = source_hash,
+                           .num_instructions = (uint32_t)instructions.size(),
+                           .num_args = (uint32_t)args.size()};
+
+  std::string data((const char *)&header, sizeof(header));
+  data.append((const char *)instructions.data(), instructions.size() * sizeof(instruction_t));
+  data.append((const char *)args.data(), args.size() * sizeof(float));
+  return data;
+}
+
+/**
+ * @return a hash of the verb names and argument counts, which a cache has to match
+ */
+uint32_t AutoScript::hash_verbs()
+{
+  uint32_t hash = FNV_START;
+  for (const verb_t &v : verbs)
+  {
+    hash = fnv1a(hash, v.name, strlen(v.name) + 1);
+    hash = fnv1a(hash, (const char *)&v.min_args, sizeof(v.min_args));
+    hash = fnv1a(hash, (const char *)&v.max_args, sizeof(v.max_args));
+  }
+  for (const keyword_t &k : keywords)
+  {
+    hash = fnv1a(hash, k.name, strlen(k.name) + 1);
+    hash = fnv1a(hash, (const char *)&k.value, sizeof(k.value));
+  }
+  return hash;
+}
+
+/**
+ * Record an error, and print it
+ */
+void AutoScript::error(int line, const char *fmt, ...)
+{
+  char msg[96];
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(msg, sizeof(msg), fmt, ap);
+  va_end(ap);
+
+  char full[112];
+  if (line > 0)
+    snprintf(full, sizeof(full), "line %d: %s", line, msg);
+  else
+    snprintf(full, sizeof(full), "%s", msg);
+
+  printf("(auto_script.cpp): Warning - %s\n", full);
+  errors.push_back(full);
+}
@@ -0,0 +1,144 @@
+/**
+ * File: command_arena.cpp
+ * Desc:
+ *    A CommandArena holds the AutoCommands of one autonomous route, and frees them all at once.
+ */
+#include <stdlib.h>
+#include <new>
+#include "../core/include/utils/command_structure/command_arena.h"
+#include "../core/include/utils/command_structure/auto_command.h"
+
+CommandArena *CommandArena::active = NULL;
+
+CommandArena::Scope::Scope(CommandArena &arena) : prev(active)
+{
+  active = &arena;
+}
+
+CommandArena::Scope::~Scope()
+{
+  active = prev;
+}
+
+/**
+ * Create an empty arena. No memory is reserved until the first command is allocated
+ * @param block_size how many bytes to reserve at a time
+ */
+CommandArena::CommandArena(size_t block_size) : block_size(block_size) {}
+
+/**
+ * Destroy every command in the arena and free its memory
+ */
+CommandArena::~CommandArena()
+{
+  release();
+}
+
+/**
+ * Allocate memory for a command. Used by AutoCommand::operator new
+ * @param size the size of the command
+ * @return memory for the command, aligned for any type
+ */
+void *CommandArena::allocate(size_t size)
+{
+  size_t needed = HEADER_SIZE + ((size + ALIGN - 1) & ~(ALIGN - 1));
+
+  // Start a new block when this one is full. Commands too big for a block get one of their own
+  if (blocks.empty() || block_used + needed > block_size)
+  {
+    size_t new_size = (needed > block_size) ? needed : block_size;
+    blocks.push_back((char *)malloc(new_size));
+    block_used = 0;
+    reserved += new_size;
+  }
+
+  header_t *header = (header_t *)(blocks.back() + block_used);
+  header->arena = this;
+  header->next = last;
+  last = header;
+
+  block_used += needed;
+  used += needed;
+  count++;
+
+  return (char *)header + HEADER_SIZE;
+}
+
+/**
+ * Destroy every command in the arena and free its memory. The arena can be used again afterwards
+ */
+void CommandArena::release()
+{
+  // Newest first, so commands that hold on to older ones are destroyed before them
+  for (header_t *h = last; h != NULL; h = h->next)
+    ((AutoCommand *)((char *)h + HEADER_SIZE))->~AutoCommand();
+
+  for (char *block : blocks)
+    free(block);
+
+  blocks.clear();
+  block_used = 0;
+  used = 0;
+  reserved = 0;
+  count = 0;
+  last = NULL;
+}
+
+/**
+ * @return the number of bytes taken by commands (including each command's bookkeeping)
+ */
+size_t CommandArena::bytes_used()
+{
+  return used;
+}
+
+/**
+ * @return the number of bytes reserved from the heap
+ */
+size_t CommandArena::bytes_reserved()
+{
+  return reserved;
+}
+
+/**
+ * @return the number of commands in the arena
+ */
+int CommandArena::num_commands()
+{
+  return count;
+}
+
+/**
+ * @return the arena new AutoCommands are allocated from right now, or NULL if they go on the heap
+ */
+CommandArena *CommandArena::get_active()
+{
+  return active;
+}
+
+/**
+ * Allocate a command in the active arena, or on the heap if there isn't one
+ */
+void *AutoCommand::operator new(size_t size)
+{
+  if (CommandArena::active != NULL)
+    return CommandArena::active->allocate(size);
+
+  CommandArena::header_t *header = (CommandArena::header_t *)malloc(CommandArena::HEADER_SIZE + size);
+  header->arena = NULL;
+  header->next = NULL;
+  return (char *)header + CommandArena::HEADER_SIZE;
+}
+
+/**
+ * Free a heap allocated command. Commands in an arena are freed with the arena instead
+ */
+void AutoCommand::operator delete(void *ptr)
+{
+  if (ptr == NULL)
+    return;
+
+  CommandArena::header_t *header = (CommandArena::header_t *)((char *)ptr - CommandArena::HEADER_SIZE);
+  if (header->arena == NULL)
+    free(header);
+}
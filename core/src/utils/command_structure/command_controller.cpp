@@ -7,13 +7,17 @@
  *    in FIFO order.
  */
 #include <stdio.h>
+#include <string>
 #include "../core/include/utils/command_structure/command_controller.h"
 #include "../core/include/utils/command_structure/delay_command.h"
 
+// Longest the controller sleeps between checks for cancel() and preempt(), so a long wait doesn't hold them up
+#define INTERRUPT_POLL_MS 10
+
 /**
  * Adds a command to the queue
  * @param cmd the AutoCommand we want to add to our list
- * @param timeout_seconds the number of seconds we will let the command run for. If it exceeds this, we cancel it and run on_timeout
+ * @param timeout_seconds the number of seconds we will let the command run for. If it exceeds this, we cancel it and run end(true)
  */
 void CommandController::add(AutoCommand *cmd, double timeout_seconds)
 {
@@ -58,6 +62,7 @@ void CommandController::add(std::vector<AutoCommand *> cmds, double timeout_sec)
  */
 void CommandController::add_delay(int ms)
 {
+  CommandArena::Scope arena_scope(*arena);
   AutoCommand *delay = new DelayCommand(ms);
   command_queue.push(delay);
 }
@@ -70,29 +75,89 @@ void CommandController::run()
 {
   AutoCommand *next_cmd;
   printf("Running Auto. Commands 1 to %d\n", command_queue.size());
+  if (arena->num_commands() > 0)
+    printf("%d commands in %d bytes (%d reserved)\n", arena->num_commands(), (int)arena->bytes_used(), (int)arena->bytes_reserved());
   fflush(stdout);
   int command_count = 1;
   vex::timer tmr;
   tmr.reset();
 
-  while (!command_queue.empty())
+  profile_size = 0;
+  profile_dropped = 0;
+  uint32_t run_start_ms = vex::timer::system();
+
+  signals->cancel = false;
+  signals->preempt = nullptr;
+  signals->running = true;
+  AutoCommand *preempted_by = NULL;
+
+  while ((preempted_by != NULL || !command_queue.empty()) && !signals->cancel)
   {
-    // retrieve and remove command at the front of the queue
-    next_cmd = command_queue.front();
-    command_queue.pop();
+    // A command that preempted the last one goes first. Otherwise, retrieve and remove command at the front of the queue
+    if (preempted_by != NULL)
+    {
+      next_cmd = preempted_by;
+      preempted_by = NULL;
+    }
+    else
+    {
+      next_cmd = command_queue.front();
+      command_queue.pop();
+    }
     command_timed_out = false;
 
+    // Let the command plan to hand its motion off to the next one
+    if (blend_speed > 0 && !command_queue.empty())
+      next_cmd->blend_into(*command_queue.front(), blend_speed);
+
     printf("Beginning Command %d : timeout = %.2f : at time = %.1f seconds\n", command_count, next_cmd->timeout_seconds, tmr.time(vex::seconds));
     fflush(stdout);
 
-    vex::timer timeout_timer;
-    timeout_timer.reset();
     bool doTimeout = next_cmd->timeout_seconds > 0.0;
+    uint32_t start_ms = vex::timer::system();
+    uint32_t deadline_ms = start_ms + (uint32_t)(next_cmd->timeout_seconds * 1000.0);
+    uint32_t wake_ms = start_ms;
+
+    command_record_t record = {};
+    record.start_ms = start_ms - run_start_ms;
 
     // run the current command until it returns true or we timeout
-    while (!next_cmd->run())
+    while (true)
     {
-      vexDelay(20);
+      uint64_t run_start_us = vex::timer::systemHighResolution();
+      bool finished = next_cmd->run();
+      record.run_us += (uint32_t)(vex::timer::systemHighResolution() - run_start_us);
+      record.ticks++;
+
+      if (finished)
+      {
+        next_cmd->end(false);
+        break;
+      }
+
+      if (next_cmd->should_interrupt())
+      {
+        next_cmd->end(true);
+        record.interrupted = true;
+        break;
+      }
+
+      // Sleep until the command wants to run again, or until it would time out
+      uint32_t now_ms = vex::timer::system();
+      wake_ms = next_cmd->next_wake_ms(wake_ms);
+      if ((int32_t)(wake_ms - now_ms) < 0)
+        wake_ms = now_ms; // fell behind, run right away instead of trying to catch up
+      if (doTimeout && (int32_t)(wake_ms - deadline_ms) > 0)
+        wake_ms = deadline_ms;
+
+      sleep_until(wake_ms);
+
+      if (interrupt_requested())
+      {
+        next_cmd->end(true);
+        record.interrupted = true;
+        break;
+      }
 
       if (!doTimeout)
       {
@@ -100,23 +165,247 @@ void CommandController::run()
       }
 
       // If we do want to check for timeout, check and end the command if we should
-      double cmd_elapsed_sec = ((double)timeout_timer.time()) / 1000.0;
-      if (cmd_elapsed_sec > next_cmd->timeout_seconds)
+      if ((int32_t)(vex::timer::system() - deadline_ms) >= 0)
       {
-        next_cmd->on_timeout();
+        next_cmd->end(true);
         command_timed_out = true;
         break;
       }
     }
 
-    printf("Finished Command %d. Timed out: %s\n", command_count, command_timed_out ? "true" : "false");
+    record.duration_ms = vex::timer::system() - start_ms;
+    record.timed_out = command_timed_out;
+    record.slack = doTimeout ? (float)(next_cmd->timeout_seconds - (record.duration_ms / 1000.0)) : 0;
+    if (profile_size < PROFILE_MAX_RECORDS)
+      profile[profile_size++] = record;
+    else
+      profile_dropped++;
+
+    printf("Finished Command %d. Timed out: %s. Interrupted: %s\n", command_count, command_timed_out ? "true" : "false", record.interrupted ? "true" : "false");
     fflush(stdout);
     command_count++;
+
+    preempted_by = signals->preempt.exchange(nullptr);
+  }
+
+  if (signals->cancel)
+  {
+    printf("Auto cancelled, skipping %d commands\n", (int)command_queue.size());
+    command_queue = std::queue<AutoCommand *>();
   }
+  signals->running = false;
   printf("Finished commands in %f seconds\n", tmr.time(vex::sec));
+  if (profile_dropped > 0)
+    printf("(command_controller.cpp): Warning - profile is full, the last %d commands weren't recorded\n", profile_dropped);
+}
+
+/**
+ * Stop the route from another task, e.g. when the driver takes over. The running command is ended with
+ * end(true), and the rest of the queue is thrown away. Does nothing if the route isn't running
+ */
+void CommandController::cancel()
+{
+  if (signals->running)
+    signals->cancel = true;
+}
+
+/**
+ * Interrupt the running command from another task, and run a different one in its place. The running command
+ * is ended with end(true), then cmd runs, then the rest of the queue carries on.
+ * Does nothing if the route isn't running, or if another preempt() hasn't been picked up yet
+ * @param cmd the command to run in place of the current one
+ * @return true if cmd will run, false if it was refused
+ */
+bool CommandController::preempt(AutoCommand *cmd)
+{
+  if (!signals->running)
+    return false;
+
+  // Only one preempt can wait at a time. Replacing it would drop a command the caller was told would run
+  AutoCommand *none = nullptr;
+  if (!signals->preempt.compare_exchange_strong(none, cmd))
+  {
+    printf("(command_controller.cpp): Warning - preempt() refused, another preempt is still waiting to run\n");
+    fflush(stdout);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @return true while run() is running the queue
+ */
+bool CommandController::is_running()
+{
+  return signals->running;
+}
+
+/**
+ * @return true if cancel() or preempt() has been called since the current command started
+ */
+bool CommandController::interrupt_requested()
+{
+  return signals->cancel || signals->preempt.load() != nullptr;
+}
+
+/**
+ * Sleep until a time, in short steps so that cancel() or preempt() from another task wakes us up early
+ * @param wake_ms the time (vex::timer::system()) to sleep until
+ */
+void CommandController::sleep_until(uint32_t wake_ms)
+{
+  while (!interrupt_requested())
+  {
+    int32_t left = (int32_t)(wake_ms - vex::timer::system());
+    if (left <= 0)
+      return;
+    vexDelay(left < INTERRUPT_POLL_MS ? left : INTERRUPT_POLL_MS);
+  }
+}
+
+/**
+ * Estimate how long the route takes without running it, by following the robot's predicted pose through each
+ * command. Prints the estimate for each command, and a warning if the route is over budget.
+ * Commands that can't be estimated are left out of the estimate and listed. The worst case, where every command
+ * with a timeout runs until it times out, is reported separately.
+ * @param start where the robot starts (an OdomSetPosition in the route replaces it)
+ * @param budget_seconds the time the route has, e.g. 15 for a match or 60 for skills. 0 to skip the check
+ * @param end filled in with where the robot is predicted to end up, if not NULL
+ * @param worst_case filled in with the worst case time in seconds, if not NULL
+ * @return the estimated time in seconds
+ */
+double CommandController::estimate(pose_t start, double budget_seconds, pose_t *end, double *worst_case)
+{
+  std::queue<AutoCommand *> cmds = command_queue;
+  pose_t pose = start;
+  double total = 0, worst = 0;
+  std::string unknown = "";
+
+  for (int i = 1; !cmds.empty(); i++)
+  {
+    AutoCommand *cmd = cmds.front();
+    cmds.pop();
+
+    double t = cmd->estimate_seconds(pose);
+    bool has_timeout = cmd->timeout_seconds > 0;
+
+    // The worst case is the command running until it times out, or as long as it's expected to without one
+    if (has_timeout)
+      worst += cmd->timeout_seconds;
+    else if (t > 0)
+      worst += t;
+
+    if (t < 0)
+    {
+      // Left out of the estimate, so one slow command with no estimate doesn't hide the rest of the route
+      unknown += " " + std::to_string(i);
+      if (has_timeout)
+        printf("Command %d: unknown (times out at %.2fs)\n", i, cmd->timeout_seconds);
+      else
+        printf("Command %d: unknown (no timeout)\n", i);
+      continue;
+    }
+
+    const char *note = "";
+    if (has_timeout && t > cmd->timeout_seconds)
+    {
+      t = cmd->timeout_seconds;
+      note = " (will time out)";
+    }
+
+    total += t;
+    printf("Command %d: %.2fs%s, ends at (%.1f, %.1f) %.0f deg\n", i, t, note, pose.x, pose.y, pose.rot);
+  }
+
+  printf("Estimated %.2f seconds, worst case %.2f seconds\n", total, worst);
+  if (unknown != "")
+    printf("Not estimated, left out: commands%s\n", unknown.c_str());
+  if (budget_seconds > 0 && total > budget_seconds)
+    printf("(command_controller.cpp): Warning - estimated %.2f seconds, over the %.0f second budget\n", total, budget_seconds);
+  fflush(stdout);
+
+  if (end != NULL)
+    *end = pose;
+  if (worst_case != NULL)
+    *worst_case = worst;
+  return total;
 }
 
 bool CommandController::last_command_timed_out()
 {
   return command_timed_out;
-}
\ No newline at end of file
+}
+
+/**
+ * Blend consecutive drive commands together, so the robot carries its speed through the points
+ * between them instead of stopping at each one.
+ * @param speed the speed (inches/second) to carry through a straight line between two commands. 0 disables blending
+ */
+void CommandController::set_blend_speed(double speed)
+{
+  blend_speed = speed;
+}
+/**
+ * The arena this route's commands can be allocated in. It is freed when the last copy of this controller is
+ * destroyed, so the commands in it must not be used after that.
+ * @return the arena for this route's commands
+ */
+CommandArena &CommandController::get_arena()
+{
+  return *arena;
+}
+
+/**
+ * @return how each command went the last time run() was called, in order
+ */
+std::vector<CommandController::command_record_t> CommandController::get_profile()
+{
+  return std::vector<command_record_t>(profile, profile + profile_size);
+}
+
+/**
+ * Copy the profile from the last run() without allocating, e.g. to hand it to another task
+ * @param out where to copy the records to
+ * @param max_records how many records fit in `out`
+ * @return how many records were copied
+ */
+int CommandController::copy_profile(command_record_t *out, int max_records)
+{
+  int n = (profile_size < max_records) ? profile_size : max_records;
+  for (int i = 0; i < n; i++)
+    out[i] = profile[i];
+  return n;
+}
+
+/**
+ * Save the profile from the last run() to the SD card as a CSV, one row per command
+ * @param filename the name of the file to save to
+ * @return true if the file was saved, false if there's no SD card or nothing has been run
+ */
+bool CommandController::save_profile(const char *filename)
+{
+  vex::brain::sdcard sd;
+  if (!sd.isInserted())
+  {
+    printf("(command_controller.cpp): Warning - no SD card to save the profile to\n");
+    return false;
+  }
+  if (profile_size == 0)
+    return false;
+
+  char line[128];
+  std::string csv;
+  csv.reserve(profile_size * 48 + 64);
+  csv += "command,start,duration,ticks,run_time,timed_out,interrupted,slack\n";
+
+  for (int i = 0; i < profile_size; i++)
+  {
+    command_record_t &r = profile[i];
+    snprintf(line, sizeof(line), "%d,%.3f,%.3f,%d,%.6f,%d,%d,%.3f\n", i + 1, r.start_ms / 1000.0, r.duration_ms / 1000.0,
+             r.ticks, r.run_us / 1000000.0, r.timed_out ? 1 : 0, r.interrupted ? 1 : 0, r.slack);
+    csv += line;
+  }
+
+  sd.savefile(filename, (uint8_t *)csv.c_str(), csv.size());
+  return true;
+}
@@ -0,0 +1,269 @@
+/**
+ * File: command_groups.cpp
+ * Desc:
+ *    Command groups run several AutoCommands at once, as a single command in a CommandController.
+ */
+#include <algorithm>
+#include "../core/include/utils/command_structure/command_groups.h"
+
+/**
+ * @return the deadline, followed by the others. The deadline goes first, so it is never the one left out
+ */
+static std::vector<AutoCommand *> deadline_first(AutoCommand *deadline, std::vector<AutoCommand *> &others)
+{
+  std::vector<AutoCommand *> cmds = {deadline};
+  cmds.insert(cmds.end(), others.begin(), others.end());
+  return cmds;
+}
+
+/**
+ * Create a group of commands that run at the same time
+ * @param cmds the commands in the group. Their timeouts are kept, and apply from the start of the group.
+ *             If two of them require the same subsystem, the group is invalid and won't run. See is_valid()
+ */
+CommandGroup::CommandGroup(std::vector<AutoCommand *> cmds)
+{
+  for (size_t i = 0; i < cmds.size(); i++)
+  {
+    AutoCommand *cmd = cmds[i];
+    for (size_t j = 0; j < children.size(); j++)
+    {
+      if (valid && cmd->conflicts_with(*children[j].cmd))
+      {
+        printf("(command_groups.cpp): Error - commands %d and %d in a group need the same subsystem, the group won't run\n", (int)j + 1, (int)i + 1);
+        valid = false;
+      }
+    }
+
+    children.push_back({.cmd = cmd, .running = false, .start_ms = 0, .wake_ms = 0});
+    requirements.insert(requirements.end(), cmd->requirements.begin(), cmd->requirements.end());
+  }
+}
+
+/**
+ * @return false if two of the group's commands require the same subsystem. An invalid group ends as soon as it
+ *         is run, without running any of its commands
+ */
+bool CommandGroup::is_valid()
+{
+  return valid;
+}
+
+/**
+ * Run every child that is due, and check if the group is finished
+ * @returns true when the group is finished, false otherwise
+ */
+bool CommandGroup::run()
+{
+  if (!valid)
+  {
+    printf("(command_groups.cpp): Error - skipping a group whose commands need the same subsystem\n");
+    return true;
+  }
+
+  uint32_t now = vex::timer::system();
+
+  if (!started)
+  {
+    started = true;
+    for (child_t &child : children)
+    {
+      child.running = true;
+      child.start_ms = now;
+      child.wake_ms = now;
+    }
+  }
+
+  for (child_t &child : children)
+  {
+    if (!child.running || (int32_t)(now - child.wake_ms) < 0)
+      continue;
+
+    if (child.cmd->run())
+    {
+      child.cmd->end(false);
+      child.running = false;
+      continue;
+    }
+
+    // Same scheduling as the CommandController: the child's own wake time, but never in the past or past its timeout
+    uint32_t t = vex::timer::system();
+    bool do_timeout = child.cmd->timeout_seconds > 0.0;
+    uint32_t deadline = child.start_ms + (uint32_t)(child.cmd->timeout_seconds * 1000.0);
+
+    if (child.cmd->should_interrupt() || (do_timeout && (int32_t)(t - deadline) >= 0))
+    {
+      child.cmd->end(true);
+      child.running = false;
+      continue;
+    }
+
+    child.wake_ms = child.cmd->next_wake_ms(child.wake_ms);
+    if ((int32_t)(child.wake_ms - t) < 0)
+      child.wake_ms = t;
+    if (do_timeout && (int32_t)(child.wake_ms - deadline) > 0)
+      child.wake_ms = deadline;
+  }
+
+  if (!is_finished())
+    return false;
+
+  cancel_running();
+  started = false;
+  return true;
+}
+
+/**
+ * Cancel every child that is still running
+ * @param interrupted true if the group was cut off. Either way, nothing is left running
+ */
+void CommandGroup::end(bool /*interrupted*/)
+{
+  cancel_running();
+  started = false;
+}
+
+/**
+ * Wake up when the next child is due
+ * @param last_wake_ms the time run() was scheduled for last
+ * @return the earliest wake time of the children still running
+ */
+uint32_t CommandGroup::next_wake_ms(uint32_t last_wake_ms)
+{
+  bool found = false;
+  uint32_t wake = last_wake_ms + period_ms;
+  for (child_t &child : children)
+  {
+    if (child.running && (!found || (int32_t)(child.wake_ms - wake) < 0))
+    {
+      wake = child.wake_ms;
+      found = true;
+    }
+  }
+  return wake;
+}
+
+/**
+ * Estimate each child (cut off at its timeout), and combine them the way the group finishes.
+ * The children are estimated in order, each starting from where the one before it left the robot.
+ * Children that can't be estimated are -1, and left out when combining
+ * @param pose the predicted pose when the group starts, changed to where it ends
+ * @return the estimated time, or -1 if the group can't be estimated from its children
+ */
+double CommandGroup::estimate_seconds(pose_t &pose)
+{
+  // An invalid group ends right away
+  if (!valid)
+    return 0;
+
+  std::vector<double> times;
+  for (child_t &child : children)
+  {
+    double t = child.cmd->estimate_seconds(pose);
+    double timeout = child.cmd->timeout_seconds;
+
+    if (t >= 0 && timeout > 0 && t > timeout)
+      t = timeout;
+    times.push_back(t);
+  }
+
+  if (times.empty())
+    return 0;
+  return combine_estimates(times);
+}
+
+/**
+ * @return the times that could be estimated, without the -1s
+ */
+static std::vector<double> known_times(std::vector<double> &times)
+{
+  std::vector<double> known;
+  for (double t : times)
+    if (t >= 0)
+      known.push_back(t);
+  return known;
+}
+
+/**
+ * Cancel every child that is still running
+ */
+void CommandGroup::cancel_running()
+{
+  for (child_t &child : children)
+  {
+    if (child.running)
+    {
+      child.cmd->end(true);
+      child.running = false;
+    }
+  }
+}
+
+/**
+ * @return true once every command has finished
+ */
+bool ParallelGroup::is_finished()
+{
+  for (child_t &child : children)
+    if (child.running)
+      return false;
+  return true;
+}
+
+/**
+ * @return the longest child's time, or -1 if none could be estimated
+ */
+double ParallelGroup::combine_estimates(std::vector<double> &times)
+{
+  std::vector<double> known = known_times(times);
+  if (known.empty())
+    return -1;
+  return *std::max_element(known.begin(), known.end());
+}
+
+/**
+ * @return true once any command has finished
+ */
+bool RaceGroup::is_finished()
+{
+  for (child_t &child : children)
+    if (!child.running)
+      return true;
+  return false;
+}
+
+/**
+ * @return the shortest child's time, or -1 if none could be estimated
+ */
+double RaceGroup::combine_estimates(std::vector<double> &times)
+{
+  std::vector<double> known = known_times(times);
+  if (known.empty())
+    return -1;
+  return *std::min_element(known.begin(), known.end());
+}
+
+/**
+ * Create a DeadlineGroup
+ * @param deadline the command that decides when the group is done
+ * @param others commands that run alongside the deadline
+ */
+DeadlineGroup::DeadlineGroup(AutoCommand *deadline, std::vector<AutoCommand *> others) : CommandGroup(deadline_first(deadline, others))
+{
+}
+
+/**
+ * @return true once the deadline command has finished
+ */
+bool DeadlineGroup::is_finished()
+{
+  return !children[0].running;
+}
+
+/**
+ * @return the deadline command's time, or -1 if it can't be estimated
+ */
+double DeadlineGroup::combine_estimates(std::vector<double> &times)
+{
+  return times[0];
+}
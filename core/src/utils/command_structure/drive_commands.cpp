@@ -7,6 +7,7 @@
  *      - drive_forward
  *      - turn_degrees
  *      - drive_to_point
+ *      - drive_arc_to_point
  *      - turn_to_heading
  *      - stop
  *
@@ -17,6 +18,11 @@
  */
 
 #include "../core/include/utils/command_structure/drive_commands.h"
+#include "../core/include/utils/math_util.h"
+#include <math.h>
+
+// Drive commands run a control loop, so they run faster than the default period
+#define DRIVE_PERIOD_MS 10
 
 
 // ==== DRIVING ====
@@ -30,7 +36,7 @@
  * @param max_speed 0 -> 1 percentage of the drive systems speed to drive at
 */
 DriveForwardCommand::DriveForwardCommand(TankDrive &drive_sys, Feedback &feedback, double inches, directionType dir, double max_speed):
-  drive_sys(drive_sys), feedback(feedback), inches(inches), dir(dir), max_speed(max_speed) {}
+  drive_sys(drive_sys), feedback(feedback), inches(inches), dir(dir), max_speed(max_speed) { period_ms = DRIVE_PERIOD_MS; requirements.push_back(&drive_sys); }
 
 /**
  * Run drive_forward
@@ -38,17 +44,86 @@ DriveForwardCommand::DriveForwardCommand(TankDrive &drive_sys, Feedback &feedbac
  * @returns true when execution is complete, false otherwise
  */
 bool DriveForwardCommand::run() {
-  return drive_sys.drive_forward(inches, dir, feedback, max_speed);
+  // Once we know where we're starting from, work out how fast we can pass through our point into the next one
+  if (!motion.initialized)
+  {
+    end_speed = 0;
+
+    point_t pt = drive_sys.forward_target(inches, dir);
+    point_t next_pt;
+    directionType next_dir;
+    if (next != NULL && next->get_drive_target(drive_sys.arrival_pose(pt, dir), next_pt, next_dir) && next_dir == dir)
+      end_speed = drive_sys.corner_speed(pt, next_pt, blend_speed);
+  }
+
+  if (!drive_sys.drive_forward(motion, inches, dir, feedback, max_speed, end_speed))
+    return false;
+
+  // Our movement kept the speed it ended at. Pass it on to the next command's movement
+  if (next != NULL && motion.handoff_speed > 0)
+    next->start_blended(motion.handoff_speed);
+  motion.handoff_speed = 0;
+  return true;
+}
+
+/**
+ * Estimate how long drive_forward takes, and move the predicted pose straight ahead (or back)
+ */
+double DriveForwardCommand::estimate_seconds(pose_t &pose) {
+  double d = (dir == directionType::fwd) ? inches : -inches;
+  pose.x += d * cos(deg2rad(pose.rot));
+  pose.y += d * sin(deg2rad(pose.rot));
+  return feedback.estimate_time(0, fabs(inches));
 }
 
 /**
  * reset the drive system if we timeout
 */
 void DriveForwardCommand::on_timeout(){
-  drive_sys.reset_auto();
+  motion.reset();
   drive_sys.stop();
 }
 
+/**
+ * Plan to carry our speed into the next command, if it drives to a point in the same direction
+ * @param next the command that will run after this one
+ * @param speed the speed (inches/second) to carry through a straight line
+ */
+void DriveForwardCommand::blend_into(AutoCommand &next, double speed){
+  this->next = &next;
+  this->blend_speed = speed;
+}
+
+/**
+ * Start our movement at the speed the command before us finished at
+ * @param speed the speed (inches/second) the robot is still moving at
+ */
+void DriveForwardCommand::start_blended(double speed){
+  motion.handoff_speed = speed;
+}
+
+/**
+ * Report the point we'll drive to, so the command before us can blend into us. Once we've started, that's the
+ * point we're driving to. Before that, it's straight ahead (or back) of where the command before us leaves the robot
+ * @param start where the command before us will leave the robot
+ * @param pt filled in with the point we drive to
+ * @param dir filled in with the direction we drive in
+ * @returns true
+ */
+bool DriveForwardCommand::get_drive_target(const pose_t &start, point_t &pt, directionType &dir){
+  if (motion.initialized)
+  {
+    pt = motion.target;
+  }
+  else
+  {
+    double d = (this->dir == directionType::fwd) ? fabs(inches) : -fabs(inches);
+    pt = {.x = start.x + (d * cos(deg2rad(start.rot))), .y = start.y + (d * sin(deg2rad(start.rot)))};
+  }
+  dir = this->dir;
+  return true;
+}
+
 
 /**
  * Construct a TurnDegreesCommand Command
@@ -58,7 +133,7 @@ void DriveForwardCommand::on_timeout(){
  * @param max_speed 0 -> 1 percentage of the drive systems speed to drive at
  */
 TurnDegreesCommand::TurnDegreesCommand(TankDrive &drive_sys, Feedback &feedback, double degrees, double max_speed):
-  drive_sys(drive_sys), feedback(feedback), degrees(degrees), max_speed(max_speed){}
+  drive_sys(drive_sys), feedback(feedback), degrees(degrees), max_speed(max_speed) { period_ms = DRIVE_PERIOD_MS; requirements.push_back(&drive_sys); }
 
 /**
  * Run turn_degrees
@@ -66,13 +141,21 @@ TurnDegreesCommand::TurnDegreesCommand(TankDrive &drive_sys, Feedback &feedback,
  * @returns true when execution is complete, false otherwise
  */
 bool TurnDegreesCommand::run() {
-  return drive_sys.turn_degrees(degrees, max_speed);
+  return drive_sys.turn_degrees(motion, degrees, feedback, max_speed);
+}
+
+/**
+ * Estimate how long turn_degrees takes, and turn the predicted pose
+ */
+double TurnDegreesCommand::estimate_seconds(pose_t &pose) {
+  pose.rot = wrap_angle_deg(pose.rot + degrees);
+  return feedback.estimate_time(0, fabs(degrees));
 }
 /**
  * reset the drive system if we timeout
 */
 void TurnDegreesCommand::on_timeout(){
-  drive_sys.reset_auto();
+  motion.reset();
   drive_sys.stop();
 }
 
@@ -87,7 +170,7 @@ void TurnDegreesCommand::on_timeout(){
  * @param max_speed 0 -> 1 percentage of the drive systems speed to drive at
  */
 DriveToPointCommand::DriveToPointCommand(TankDrive &drive_sys, Feedback &feedback, double x, double y, directionType dir, double max_speed):
-  drive_sys(drive_sys), feedback(feedback), x(x), y(y), dir(dir), max_speed(max_speed) {}
+  drive_sys(drive_sys), feedback(feedback), x(x), y(y), dir(dir), max_speed(max_speed) { period_ms = DRIVE_PERIOD_MS; requirements.push_back(&drive_sys); }
 
 /**
  * Construct a DriveForward Command
@@ -98,7 +181,7 @@ DriveToPointCommand::DriveToPointCommand(TankDrive &drive_sys, Feedback &feedbac
  * @param max_speed 0 -> 1 percentage of the drive systems speed to drive at
  */
 DriveToPointCommand::DriveToPointCommand(TankDrive &drive_sys, Feedback &feedback, point_t point, directionType dir, double max_speed):
-  drive_sys(drive_sys), feedback(feedback), x(point.x), y(point.y), dir(dir), max_speed(max_speed) {}
+  drive_sys(drive_sys), feedback(feedback), x(point.x), y(point.y), dir(dir), max_speed(max_speed) { period_ms = DRIVE_PERIOD_MS; requirements.push_back(&drive_sys); }
 
 /**
  * Run drive_to_point
@@ -106,16 +189,126 @@ DriveToPointCommand::DriveToPointCommand(TankDrive &drive_sys, Feedback &feedbac
  * @returns true when execution is complete, false otherwise
  */
 bool DriveToPointCommand::run() {
-  return drive_sys.drive_to_point(x, y, dir, feedback, max_speed);
+  // Once we know where we're starting from, work out how fast we can pass through our point into the next one
+  if (!motion.initialized)
+  {
+    end_speed = 0;
+
+    point_t next_pt;
+    directionType next_dir;
+    if (next != NULL && next->get_drive_target(drive_sys.arrival_pose({.x=x, .y=y}, dir), next_pt, next_dir) && next_dir == dir)
+      end_speed = drive_sys.corner_speed({.x=x, .y=y}, next_pt, blend_speed);
+  }
+
+  if (!drive_sys.drive_to_point(motion, x, y, dir, feedback, max_speed, end_speed))
+    return false;
+
+  // Our movement kept the speed it ended at. Pass it on to the next command's movement
+  if (next != NULL && motion.handoff_speed > 0)
+    next->start_blended(motion.handoff_speed);
+  motion.handoff_speed = 0;
+  return true;
+}
+
+/**
+ * Estimate how long drive_to_point takes, and move the predicted pose to the point, facing along the way it drove
+ */
+double DriveToPointCommand::estimate_seconds(pose_t &pose) {
+  double dx = x - pose.x, dy = y - pose.y;
+  double dist = sqrt((dx * dx) + (dy * dy));
+  double heading = rad2deg(atan2(dy, dx)) + ((dir == directionType::fwd) ? 0 : 180);
+
+  pose = {.x = x, .y = y, .rot = (dist > 0) ? wrap_angle_deg(heading) : pose.rot};
+  return feedback.estimate_time(0, dist);
 }
 /**
  * reset the drive system if we don't hit our target
 */
 void DriveToPointCommand::on_timeout(){
-  drive_sys.reset_auto();
+  motion.reset();
   drive_sys.stop();
 }
 
+/**
+ * Plan to carry our speed into the next command, if it drives to a point in the same direction
+ * @param next the command that will run after this one
+ * @param speed the speed (inches/second) to carry through a straight line
+ */
+void DriveToPointCommand::blend_into(AutoCommand &next, double speed){
+  this->next = &next;
+  this->blend_speed = speed;
+}
+
+/**
+ * Start our movement at the speed the command before us finished at
+ * @param speed the speed (inches/second) the robot is still moving at
+ */
+void DriveToPointCommand::start_blended(double speed){
+  motion.handoff_speed = speed;
+}
+
+/**
+ * Report the point we're driving to, so the command before us can blend into us
+ * @param start where the command before us will leave the robot. Not needed, our point is fixed
+ * @param pt filled in with the point we're driving to
+ * @param dir filled in with the direction we're driving in
+ * @returns true
+ */
+bool DriveToPointCommand::get_drive_target(const pose_t &/*start*/, point_t &pt, directionType &dir){
+  pt = {.x=x, .y=y};
+  dir = this->dir;
+  return true;
+}
+
+
+/**
+ * Construct a DriveArcToPoint Command
+ * @param drive_sys the drive system we are commanding
+ * @param feedback the motion profile we are using to execute the drive
+ * @param point the point to drive to
+ * @param dir the direction to drive
+ * @param max_speed 0 -> 1 percentage of the drive systems speed to drive at
+ */
+DriveArcToPointCommand::DriveArcToPointCommand(TankDrive &drive_sys, MotionController &feedback, point_t point, directionType dir, double max_speed):
+  drive_sys(drive_sys), feedback(feedback), point(point), dir(dir), max_speed(max_speed) { period_ms = DRIVE_PERIOD_MS; requirements.push_back(&drive_sys); }
+
+/**
+ * Run drive_arc_to_point
+ * Overrides run from AutoCommand
+ * @returns true when execution is complete, false otherwise
+ */
+bool DriveArcToPointCommand::run() {
+  return drive_sys.drive_arc_to_point(motion, point.x, point.y, dir, feedback, max_speed);
+}
+
+/**
+ * Estimate how long drive_arc_to_point takes, and move the predicted pose to the end of the arc
+ */
+double DriveArcToPointCommand::estimate_seconds(pose_t &pose) {
+  double dx = point.x - pose.x, dy = point.y - pose.y;
+  double chord = sqrt((dx * dx) + (dy * dy));
+
+  // The arc is tangent to the robot's heading, so it turns twice the angle between the heading and the chord
+  double facing = pose.rot + ((dir == directionType::fwd) ? 0 : 180);
+  double half_turn = wrap_angle_deg(rad2deg(atan2(dy, dx)) - facing + 180) - 180;
+  double theta = deg2rad(half_turn);
+  double arc = (fabs(theta) > 1e-6) ? chord * theta / sin(theta) : chord;
+
+  pose = {.x = point.x, .y = point.y, .rot = wrap_angle_deg(pose.rot + (2 * half_turn))};
+
+  // The arc's profile is slowed down by `scale`. Scaling max_v and accel both takes as long as the full profile
+  // over arc / scale
+  double scale = drive_sys.arc_speed_scale(feedback, 2 * half_turn, arc);
+  return feedback.estimate_time(0, arc / scale);
+}
+
+/**
+ * reset the drive system if we timeout
+*/
+void DriveArcToPointCommand::on_timeout(){
+  motion.reset();
+  drive_sys.stop();
+}
 
 /**
  * Construct a TurnToHeadingCommand Command
@@ -125,7 +318,7 @@ void DriveToPointCommand::on_timeout(){
  * @param max_speed 0 -> 1 percentage of the drive systems speed to drive at
  */
 TurnToHeadingCommand::TurnToHeadingCommand(TankDrive &drive_sys, Feedback &feedback, double heading_deg, double max_speed):
-  drive_sys(drive_sys), feedback(feedback), heading_deg(heading_deg), max_speed(max_speed) {}
+  drive_sys(drive_sys), feedback(feedback), heading_deg(heading_deg), max_speed(max_speed) { period_ms = DRIVE_PERIOD_MS; requirements.push_back(&drive_sys); }
 
 /**
  * Run turn_to_heading
@@ -133,13 +326,22 @@ TurnToHeadingCommand::TurnToHeadingCommand(TankDrive &drive_sys, Feedback &feedb
  * @returns true when execution is complete, false otherwise
  */
 bool TurnToHeadingCommand::run() {
-  return drive_sys.turn_to_heading(heading_deg, feedback, max_speed);
+  return drive_sys.turn_to_heading(motion, heading_deg, feedback, max_speed);
+}
+
+/**
+ * Estimate how long turn_to_heading takes (turning the short way), and turn the predicted pose
+ */
+double TurnToHeadingCommand::estimate_seconds(pose_t &pose) {
+  double delta = wrap_angle_deg(heading_deg - pose.rot + 180) - 180;
+  pose.rot = wrap_angle_deg(heading_deg);
+  return feedback.estimate_time(0, fabs(delta));
 }
 /**
  * reset the drive system if we don't hit our target
 */
 void TurnToHeadingCommand::on_timeout(){
-  drive_sys.reset_auto();
+  motion.reset();
   drive_sys.stop();
 }
 
@@ -149,7 +351,7 @@ void TurnToHeadingCommand::on_timeout(){
  * @param drive_sys the drive system we are commanding
  */
 DriveStopCommand::DriveStopCommand(TankDrive &drive_sys):
-  drive_sys(drive_sys) {}
+  drive_sys(drive_sys) { requirements.push_back(&drive_sys); }
 
 void DriveStopCommand::on_timeout()
 {
@@ -166,6 +368,13 @@ bool DriveStopCommand::run() {
   return true;
 }
 
+/**
+ * Stopping is instant
+ */
+double DriveStopCommand::estimate_seconds(pose_t &/*pose*/) {
+  return 0;
+}
+
 
 // ==== ODOMETRY ====
 /**
@@ -179,3 +388,11 @@ bool OdomSetPosition::run() {
   odom.set_position(newpos);
   return true;
 }
+
+/**
+ * Setting the position is instant, and the predicted pose is wherever it's set to
+ */
+double OdomSetPosition::estimate_seconds(pose_t &pose) {
+  pose = newpos;
+  return 0;
+}
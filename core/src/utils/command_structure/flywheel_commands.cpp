@@ -8,13 +8,44 @@
 
 
 SpinRPMCommand::SpinRPMCommand(Flywheel &flywheel, int rpm):
-  flywheel(flywheel), rpm(rpm) {}
+  flywheel(flywheel), rpm(rpm) { requirements.push_back(&flywheel); }
 
 bool SpinRPMCommand::run() {
   flywheel.spinRPM(rpm);
   return true;
 }
 
+/**
+ * Setting the RPM is instant (waiting for it is a WaitUntilUpToSpeedCommand)
+ */
+double SpinRPMCommand::estimate_seconds(pose_t &/*pose*/) {
+  return 0;
+}
+
+TrackGoalRPMCommand::TrackGoalRPMCommand(Flywheel &flywheel, OdometryBase &odom, RPMTable &table, point_t goal):
+  flywheel(flywheel), odom(odom) {
+  RPMTable *table_ptr = &table;
+  this->table = [table_ptr]() -> RPMTable & { return *table_ptr; };
+  this->goal = [goal]() { return goal; };
+  requirements.push_back(&flywheel);
+}
+
+TrackGoalRPMCommand::TrackGoalRPMCommand(Flywheel &flywheel, OdometryBase &odom, std::function<RPMTable &(void)> table, std::function<point_t(void)> goal):
+  flywheel(flywheel), odom(odom), table(table), goal(goal) { requirements.push_back(&flywheel); }
+
+bool TrackGoalRPMCommand::run() {
+  // The table and goal are looked up on every update, so a flap or target change while tracking is picked up
+  OdometryBase *odom_ptr = &odom;
+  std::function<RPMTable &(void)> table_fn = table;
+  std::function<point_t(void)> goal_fn = goal;
+  flywheel.spinRPMTracking([odom_ptr, table_fn, goal_fn]() {
+    pose_t pos = odom_ptr->get_position();
+    point_t here = {.x = pos.x, .y = pos.y};
+    return table_fn().get_rpm(here.dist(goal_fn()));
+  });
+  return true;
+}
+
 WaitUntilUpToSpeedCommand::WaitUntilUpToSpeedCommand(Flywheel &flywheel, int threshold_rpm):
   flywheel(flywheel), threshold_rpm(threshold_rpm) {}
 
@@ -27,10 +58,48 @@ bool WaitUntilUpToSpeedCommand::run() {
   return false;
 }
 
+WaitUntilRecoveredCommand::WaitUntilRecoveredCommand(Flywheel &flywheel, int min_wait_ms, int shot_window_ms):
+  flywheel(flywheel), min_wait_ms(min_wait_ms), shot_window_ms(shot_window_ms) {}
+
+bool WaitUntilRecoveredCommand::run() {
+  uint32_t now = vex::timer::system();
+  if (!started) {
+    started = true;
+    start_ms = now;
+    start_shot_count = flywheel.getShotCount();
+
+    // The shoot command before us may have already fired the disc, and the flywheel seen it
+    double since_shot = flywheel.getTimeSinceShot();
+    if (since_shot >= 0 && since_shot * 1000 <= shot_window_ms)
+      start_shot_count--;
+  }
+
+  // The shot we're waiting on has to be detected before "not recovering" means anything
+  bool shot_detected = flywheel.getShotCount() > start_shot_count;
+  bool min_wait_over = (int32_t)(now - start_ms) >= min_wait_ms;
+  if (shot_detected && min_wait_over && !flywheel.isRecovering()) {
+    started = false;
+    return true;
+  }
+  return false;
+}
+
+void WaitUntilRecoveredCommand::end(bool /*interrupted*/) {
+  started = false;
+}
+
+double WaitUntilRecoveredCommand::estimate_seconds(pose_t &/*pose*/) {
+  Flywheel::metrics_t metrics = flywheel.getMetrics();
+  double t = min_wait_ms / 1000.0;
+  if (metrics.shots > 0 && metrics.avg_recovery_time > t)
+    t = metrics.avg_recovery_time;
+  return t;
+}
+
 
 
 FlywheelStopCommand::FlywheelStopCommand(Flywheel &flywheel):
-  flywheel(flywheel) {}
+  flywheel(flywheel) { requirements.push_back(&flywheel); }
 
 bool FlywheelStopCommand::run() {
   flywheel.stop();
@@ -39,7 +108,7 @@ bool FlywheelStopCommand::run() {
 
 
 FlywheelStopMotorsCommand::FlywheelStopMotorsCommand(Flywheel &flywheel):
-  flywheel(flywheel) {}
+  flywheel(flywheel) { requirements.push_back(&flywheel); }
 
 bool FlywheelStopMotorsCommand::run() {
   flywheel.stopMotors();
@@ -48,7 +117,7 @@ bool FlywheelStopMotorsCommand::run() {
 
 
 FlywheelStopNonTasksCommand::FlywheelStopNonTasksCommand(Flywheel &flywheel):
-  flywheel(flywheel) {}
+  flywheel(flywheel) { requirements.push_back(&flywheel); }
 
 bool FlywheelStopNonTasksCommand::run() {
   flywheel.stopNonTasks();
@@ -0,0 +1,46 @@
+#include "../core/include/utils/control_loop.h"
+
+/**
+ * Start timing a tick
+ * @return the time the tick started, for end_tick()
+ */
+uint64_t ControlLoop::start_tick()
+{
+  return vex::timer::systemHighResolution();
+}
+
+/**
+ * Finish timing a tick, and add it to the stats
+ * @param stats the stats to add the tick to
+ * @param start_us what start_tick() returned
+ * @param period_ms how often the loop runs. A tick that takes longer counts as an overrun
+ */
+void ControlLoop::end_tick(tick_stats_t &stats, uint64_t start_us, int period_ms)
+{
+  uint32_t elapsed_us = (uint32_t)(vex::timer::systemHighResolution() - start_us);
+  stats.ticks++;
+  stats.last_us = elapsed_us;
+  stats.avg_us += (elapsed_us - stats.avg_us) / stats.ticks;
+  if (elapsed_us > stats.max_us)
+    stats.max_us = elapsed_us;
+  if (elapsed_us > (uint32_t)period_ms * 1000)
+    stats.overruns++;
+}
+
+/**
+ * Wait until the next tick is due, instead of a fixed delay after this one, so the rate doesn't drift.
+ * If the loop fell behind, it waits 1ms and starts the schedule over, instead of catching up with a burst of ticks
+ * @param next_tick when this tick was due (timer::system()). Changed to when the next one is due
+ * @param period_ms how often the loop runs
+ */
+void ControlLoop::wait_for_next_tick(uint32_t &next_tick, int period_ms)
+{
+  next_tick += period_ms;
+  int32_t wait_ms = (int32_t)(next_tick - vex::timer::system());
+  if (wait_ms <= 0)
+  {
+    next_tick = vex::timer::system();
+    wait_ms = 1;
+  }
+  vexDelay(wait_ms);
+}
@@ -1,5 +1,48 @@
 #include "../core/include/utils/generic_auto.h"
 
+// Worker tasks shared by every GenericAuto. Each runs one async state at a time
+#define NUM_WORKERS 4
+// How often async states are run, and how often idle workers look for one
+#define ASYNC_PERIOD_MS 20
+// Async states waiting for a worker. Past this, the path holds on the next async state until there's room
+#define MAX_WAITING 16
+
+static vex::mutex pool_mutex;
+static vex::task *workers[NUM_WORKERS] = {};
+static void *waiting[MAX_WAITING]; ///< async_slot_t pointers, in the order they were submitted
+static int num_waiting = 0;
+
+/**
+ * Stop any async states that are still running. Waits for the call they're in to return, so nothing is
+ * left running a state that no longer exists.
+ */
+GenericAuto::~GenericAuto()
+{
+  for (int i = 0; i < num_async; i++)
+    async_slots[i].cancelled = true;
+
+  // Take ours out of the line, so no worker picks them up
+  pool_mutex.lock();
+  int kept = 0;
+  for (int i = 0; i < num_waiting; i++)
+  {
+    bool ours = false;
+    for (int j = 0; j < num_async; j++)
+      ours = ours || (waiting[i] == &async_slots[j]);
+
+    if (ours)
+      ((async_slot_t *)waiting[i])->status = ASYNC_DONE;
+    else
+      waiting[kept++] = waiting[i];
+  }
+  num_waiting = kept;
+  pool_mutex.unlock();
+
+  for (int i = 0; i < num_async; i++)
+    while (async_slots[i].status == ASYNC_RUNNING)
+      vexDelay(5);
+}
+
 /**
 * The method that runs the autonomous. If 'blocking' is true, then
 * this method will run through every state until it finished.
@@ -38,19 +81,55 @@ void GenericAuto::add(state_ptr new_state)
   state_list.push(new_state);
 }
 
-void GenericAuto::add_async(state_ptr async_state)
+/**
+ * Add a new state that will run asynchronously, on one of the worker tasks
+ * @param async_state the function to run. It is copied, so it can safely capture locals by value
+ * @return an id for add_join(), or -1 if there were already MAX_ASYNC async states. The state is not added
+ */
+int GenericAuto::add_async(state_ptr async_state)
+{
+  // Running it in order instead could hold the path on a state that was written to loop forever
+  if (num_async >= MAX_ASYNC)
+  {
+    printf("(generic_auto.cpp): Error - more than %d async states, this one was not added\n", MAX_ASYNC);
+    return -1;
+  }
+
+  int id = num_async++;
+  async_slots[id].fn = async_state;
+
+  // Hand it off when the path gets here. If the line is full, hold the path until there's room
+  add([this, id]()
+      { return submit(&async_slots[id]); });
+
+  return id;
+}
+
+/**
+ * Add a point where the path waits for every async state added before it to finish
+ */
+void GenericAuto::add_join()
 {
-  state_ptr fn = [&async_state](){
-    vex::task t([](void* fn_ptr){
-      while(! (*(state_ptr*)fn_ptr)() )
-       vexDelay(20);
+  int count = num_async;
+  add([this, count]()
+      {
+    for (int i = 0; i < count; i++)
+      if (async_busy(i))
+        return false;
+    return true; });
+}
 
-      return 0;
-    }, &async_state);
-    return true;
-  };
+/**
+ * Add a point where the path waits for one async state to finish
+ * @param async_id the id add_async() returned
+ */
+void GenericAuto::add_join(int async_id)
+{
+  if (async_id < 0 || async_id >= num_async)
+    return;
 
-  state_list.push(fn);
+  add([this, async_id]()
+      { return !async_busy(async_id); });
 }
 
 void GenericAuto::add_delay(int ms)
@@ -59,4 +138,75 @@ void GenericAuto::add_delay(int ms)
     vexDelay(ms);
     return true;
   });
-}
\ No newline at end of file
+}
+
+/**
+ * @return true if the async state is waiting for a worker or being run by one
+ */
+bool GenericAuto::async_busy(int async_id)
+{
+  int status = async_slots[async_id].status;
+  return status == ASYNC_QUEUED || status == ASYNC_RUNNING;
+}
+
+/**
+ * Hand an async state to the workers, starting them if they haven't been yet
+ * @return false if the line for the workers is full. Try again later
+ */
+bool GenericAuto::submit(async_slot_t *slot)
+{
+  pool_mutex.lock();
+
+  if (num_waiting >= MAX_WAITING)
+  {
+    pool_mutex.unlock();
+    return false;
+  }
+
+  if (workers[0] == NULL)
+    for (int i = 0; i < NUM_WORKERS; i++)
+      workers[i] = new vex::task(worker_main, NULL);
+
+  slot->status = ASYNC_QUEUED;
+  waiting[num_waiting++] = slot;
+
+  pool_mutex.unlock();
+  return true;
+}
+
+/**
+ * The worker tasks: take the next async state in line, and run it until it finishes or is cancelled
+ */
+int GenericAuto::worker_main(void *)
+{
+  while (true)
+  {
+    async_slot_t *slot = NULL;
+
+    pool_mutex.lock();
+    if (num_waiting > 0)
+    {
+      slot = (async_slot_t *)waiting[0];
+      for (int i = 1; i < num_waiting; i++)
+        waiting[i - 1] = waiting[i];
+      num_waiting--;
+
+      // Claimed while the pool is locked, so the GenericAuto's destructor knows to wait for it
+      slot->status = ASYNC_RUNNING;
+    }
+    pool_mutex.unlock();
+
+    if (slot == NULL)
+    {
+      vexDelay(ASYNC_PERIOD_MS);
+      continue;
+    }
+
+    while (!slot->cancelled && !slot->fn())
+      vexDelay(ASYNC_PERIOD_MS);
+
+    slot->status = ASYNC_DONE;
+  }
+
+  return 0;
+}
@@ -1,4 +1,5 @@
 #include "../core/include/utils/motion_controller.h"
+#include "../core/include/utils/sysid.h"
 #include "../core/include/utils/math_util.h"
 #include <vector>
 
@@ -23,7 +24,25 @@ MotionController::MotionController(m_profile_cfg_t &config)
  */
 void MotionController::init(double start_pt, double end_pt)
 {
+    init(start_pt, end_pt, 0, 0);
+}
+
+/**
+ * @brief Initialize the motion profile for a new movement that doesn't start or end at rest.
+ * This will also reset the PID and profile timers.
+ * @param start_pt Movement starting position
+ * @param end_pt Movement ending posiiton 
+ * @param start_vel Velocity the system is already moving at
+ * @param end_vel Velocity the system should be moving at when it reaches end_pt
+ */
+void MotionController::init(double start_pt, double end_pt, double start_vel, double end_vel)
+{
+    profile.set_max_v(config.max_v * limit_scale);
+    profile.set_accel(config.accel * limit_scale);
     profile.set_endpts(start_pt, end_pt);
+    profile.set_vel_endpts(start_vel, end_vel);
+    is_blended = (end_vel != 0);
+    limit_scale = 1;
     pid.reset();
     tmr.reset();
 }
@@ -70,10 +89,14 @@ void MotionController::set_limits(double lower, double upper)
 
 /** 
  * @return Whether or not the movement has finished, and the PID
- * confirms it is on target
+ * confirms it is on target. Movements that end at a non-zero velocity
+ * are finished as soon as the profile is.
  */
 bool MotionController::is_on_target()
 {
+    if(is_blended)
+        return tmr.time(timeUnits::sec) > profile.get_movement_time();
+
     return (tmr.time(timeUnits::sec) > profile.get_movement_time()) && pid.is_on_target();
 }
 
@@ -86,99 +109,112 @@ motion_t MotionController::get_motion()
 }
 
 /**
- * This method attempts to characterize the robot's drivetrain and automatically tune the feedforward.
- * It does this by first calculating the kS (voltage to overcome static friction) by slowly increasing
- * the voltage until it moves.
+ * @return how long a movement takes, in seconds: the motion profile, then on_target_time for the PID to settle
+ */
+double MotionController::estimate_time(double start_pt, double set_pt)
+{
+    TrapezoidProfile estimate(config.max_v, config.accel);
+    estimate.set_endpts(start_pt, set_pt);
+
+    // is_on_target() waits for the PID to hold the target for on_target_time after the profile ends
+    return estimate.get_movement_time() + config.pid_cfg.on_target_time;
+}
+
+/**
+ * @return the most output the feedforward asks for in a movement: at max_v, while still accelerating
+ */
+double MotionController::peak_ff_output()
+{
+    return ff.calculate(config.max_v, config.accel);
+}
+
+/**
+ * Scale down the maximum velocity and acceleration of the next movement (the next call to init()).
+ * Only applies to one movement, after which the limits go back to the configured values.
  * 
- * Next is kV (voltage to sustain a certain velocity), where the robot will record it's steady-state velocity
- * at 'pct' speed.
+ * @param scale the fraction (0 -> 1.0) of max_v and accel to use
+ */
+void MotionController::scale_next_movement(double scale)
+{
+    limit_scale = clamp(scale, 0, 1);
+}
+
+/**
+ * This method attempts to characterize the robot's drivetrain and automatically tune the feedforward.
+ * It does this by running quasistatic tests (slowly ramping up the voltage, so acceleration is ~0) and
+ * dynamic tests (stepping straight to 'pct', so the robot accelerates hard), both forwards and backwards.
  * 
- * Finally, kA (voltage needed to accelerate by a certain rate), where the robot will record the entire movement's
- * velocity and acceleration, record a plot of [X=(pct-kV*V-kS), Y=(Acceleration)] along the movement,
- * and since kA*Accel = pct-kV*V-kS, the reciprocal of the linear regression is the kA value.
+ * kS, kV and kA are then found together with a least squares fit of
+ * pct = kS*sgn(v) + kV*v + kA*a
+ * across all the data. The quality of the fit (R^2 and residuals) is printed, see SysId.
  * 
  * @param drive The tankdrive to operate on
  * @param odometry The robot's odometry subsystem
  * @param pct Maximum velocity in percent (0->1.0)
- * @param duration Amount of time the robot should be moving for the test
+ * @param duration Amount of time the robot should be moving for each test
  * @return A tuned feedforward object
  */
 FeedForward::ff_config_t MotionController::tune_feedforward(TankDrive &drive, OdometryTank &odometry, double pct, double duration)
 {
-    FeedForward::ff_config_t out = {};
-    
-    pose_t start_pos = odometry.get_position();
-
-    // ========== kS Tuning =========
-    // Start at 0 and slowly increase the power until the robot starts moving
-    double power = 0;
-    while(odometry.pos_diff(start_pos, odometry.get_position()) < 0.05)
-    {
-        drive.drive_tank(power, power, 1);
-        power += 0.001;
-        vexDelay(100);
-    }
-    out.kS = power;
+    SysId::sysid_cfg_t cfg = {
+        .ramp_rate = pct / duration,
+        .step_pct = pct,
+        .quasistatic_time = duration,
+        .dynamic_time = duration,
+        .period_ms = 10,
+        .fit_kg = false};
+
+    // Velocity along the robot's heading, positive forwards. (odometry's get_speed() has no direction)
+    pose_t last_pos = odometry.get_position();
+    timer vel_tmr;
+
+    SysId sysid(
+        [&](double output){ drive.drive_tank(output, output, 1); },
+        [&](){
+            pose_t pos = odometry.get_position();
+            double dt = vel_tmr.time(sec);
+            vel_tmr.reset();
+
+            double dist = ((pos.x - last_pos.x) * cos(deg2rad(pos.rot))) + ((pos.y - last_pos.y) * sin(deg2rad(pos.rot)));
+            last_pos = pos;
+            return (dt > 0) ? dist / dt : 0.0;
+        },
+        cfg);
+
+    SysId::sysid_result_t result = sysid.run();
     drive.stop();
 
+    return result.ff;
+}
 
-    // ========== kV / kA Tuning =========
-
-    std::vector<std::pair<double, double>> vel_data_points; // time, velocity
-    std::vector<std::pair<double, double>> accel_data_points; // time, accel
-
-    double max_speed = 0;
-    timer tmr;
-    double time;
-
-    MovingAverage vel_ma(3);
-    MovingAverage accel_ma(3);
-
-    // Move the robot forward at a fixed percentage for X seconds while taking velocity and accel measurements
-    do
-    {
-        time = tmr.time(sec);
-
-        vel_ma.add_entry(odometry.get_speed());
-        accel_ma.add_entry(odometry.get_accel());
-
-        double speed = vel_ma.get_average();
-        double accel = accel_ma.get_average();
-
-        // For kV:
-        if(speed > max_speed)
-            max_speed = speed;
-
-        // For kA:
-        // Filter out the acceleration dampening due to motor inductance
-        if(time > 0.25)
-        {
-            vel_data_points.push_back(std::pair<double, double>(time, speed));
-            accel_data_points.push_back(std::pair<double, double>(time, accel));
-        }
-
-        // Theoretical polling rate = 100hz (it won't be that much, cause, y'know, vex.)
-        vexDelay(10); 
-    } while(time < duration);
-
+/**
+ * Characterize the robot's drivetrain while turning in place, the same way as tune_feedforward().
+ * Angular velocity comes straight from the IMU's gyro rate, instead of being differentiated from odometry.
+ * 
+ * @param drive The tankdrive to operate on
+ * @param imu The robot's inertial sensor
+ * @param pct Maximum turning speed in percent (0->1.0)
+ * @param duration Amount of time the robot should be turning for each test
+ * @return A tuned feedforward object
+ */
+FeedForward::ff_config_t MotionController::tune_feedforward_angular(TankDrive &drive, vex::inertial &imu, double pct, double duration)
+{
+    SysId::sysid_cfg_t cfg = {
+        .ramp_rate = pct / duration,
+        .step_pct = pct,
+        .quasistatic_time = duration,
+        .dynamic_time = duration,
+        .period_ms = 10,
+        .fit_kg = false};
+
+    // Positive output turns counter-clockwise, same as turn_to_heading. The IMU is positive clockwise.
+    SysId sysid(
+        [&](double output){ drive.drive_tank(-output, output, 1); },
+        [&](){ return -imu.gyroRate(vex::axisType::zaxis, vex::velocityUnits::dps); },
+        cfg);
+
+    SysId::sysid_result_t result = sysid.run();
     drive.stop();
 
-    // Calculate kV (volts/12 per unit per second)
-    out.kV = (pct - out.kS) / max_speed;
-
-    // Calculate kA (volts/12 per unit per second^2)
-    std::vector<std::pair<double, double>> accel_per_pct;
-    for (int i = 0; i < vel_data_points.size(); i++)
-    {
-        accel_per_pct.push_back(std::pair<double, double>(
-            pct - out.kS - (vel_data_points[i].second * out.kV),   // Acceleration-causing percent (X variable)
-            accel_data_points[i].second                            // Measured acceleration (Y variable)
-        ));
-    }
-    
-    // kA is the reciprocal of the slope of the linear regression
-    double regres_slope = calculate_linear_regression(accel_per_pct).first;
-    out.kA = 1.0 / regres_slope; 
-
-    return out;
-}
\ No newline at end of file
+    return result.ff;
+}
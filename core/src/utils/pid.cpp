@@ -1,5 +1,6 @@
 #include "../core/include/utils/pid.h"
 #include "../core/include/subsystems/odometry/odometry_base.h"
+#include "../core/include/utils/math_util.h"
 
 /**
  * Create the PID object
@@ -26,32 +27,57 @@ double PID::update(double sensor_val)
 {
 
   this->sensor_val = sensor_val;
+  double error = get_error();
 
-  double time_delta = pid_timer.value() - last_time;
-
-  // Avoid a divide by zero error
-  double d_term = 0;
-  if(time_delta != 0)
-    d_term = config.d * (get_error() - last_error) / time_delta;
-  else if(last_time != 0)
-    printf("(pid.cpp): Warning - running PID without a delay is just a P loop!\n");
+  double now = pid_timer.value();
+  double time_delta = (config.fixed_dt > 0) ? config.fixed_dt : now - last_time;
 
+  // With no time between updates, there is nothing new to integrate or differentiate.
+  // Keep the last derivative and integral and only update the P term.
+  if(time_delta > 0 && has_last)
+  {
+    double d_raw;
+    if (config.deriv_method == DERIV_TYPE::MEASUREMENT_DERIV)
+      d_raw = (error - error_at(last_sensor_val)) / time_delta; // how much the error changed due to the sensor alone
+    else
+      d_raw = (error - last_error) / time_delta;
+
+    // First order low-pass filter to keep sensor noise from being amplified
+    if (config.d_filter_time > 0)
+      d_filtered += (d_raw - d_filtered) * (time_delta / (config.d_filter_time + time_delta));
+    else
+      d_filtered = d_raw;
+  }
 
   // P and D terms
-  out = (config.p * get_error()) + d_term;
+  double pd_out = (config.p * error) + (config.d * d_filtered);
 
   bool limits_exist = lower_limit != 0 || upper_limit != 0;
 
-  // Only add to the accumulated error if the output is not saturated
-  // aka "Integral Clamping" anti-windup technique
-  if ( !limits_exist || (limits_exist && (out < upper_limit && out > lower_limit)) )
-    accum_error += time_delta * get_error();
-  
+  if (time_delta > 0 && has_last)
+  {
+    if (config.windup_gain > 0 && config.i != 0)
+    {
+      // "Back-calculation" anti-windup: integrate the error, minus how far past the limits we would have gone
+      double unsat_out = pd_out + (config.i * accum_error);
+      double sat_out = limits_exist ? clamp(unsat_out, lower_limit, upper_limit) : unsat_out;
+      accum_error += time_delta * (error + (config.windup_gain / config.i) * (sat_out - unsat_out));
+    }
+    else if ( !limits_exist || (limits_exist && (pd_out < upper_limit && pd_out > lower_limit)) )
+    {
+      // Only add to the accumulated error if the output is not saturated
+      // aka "Integral Clamping" anti-windup technique
+      accum_error += time_delta * error;
+    }
+  }
+
   // I term
-  out += config.i * accum_error;
+  out = pd_out + (config.i * accum_error);
 
-  last_time = pid_timer.value();
-  last_error = get_error();
+  last_time = now;
+  last_error = error;
+  last_sensor_val = sensor_val;
+  has_last = true;
 
   // Enable clamping if the limit is not 0
   if (limits_exist)
@@ -68,6 +94,9 @@ void PID::reset()
   pid_timer.reset();
 
   last_error = 0;
+  last_sensor_val = 0;
+  d_filtered = 0;
+  has_last = false;
   last_time = 0;
   accum_error = 0;
 
@@ -87,6 +116,14 @@ double PID::get()
  * Get the delta between the current sensor data and the target
  */
 double PID::get_error()
+{
+  return error_at(sensor_val);
+}
+
+/**
+ * Calculate the error for a given sensor reading, against the current target
+ */
+double PID::error_at(double sensor_val)
 {
   if (config.error_method==ERROR_TYPE::ANGULAR){
     return OdometryBase::smallest_angle(target, sensor_val);
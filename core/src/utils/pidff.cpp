@@ -84,4 +84,30 @@ void PIDFF::set_limits(double lower, double upper)
 bool PIDFF::is_on_target()
 {
     return pid.is_on_target();
-}
\ No newline at end of file
+}
+
+/**
+ * Give the controller a rough idea of how fast it moves, so its movements can be estimated
+ * 
+ * @param max_v the typical top speed of a movement (units per second)
+ * @param accel the typical acceleration (units per second^2)
+ */
+void PIDFF::set_estimate_rate(double max_v, double accel)
+{
+    est_max_v = max_v;
+    est_accel = accel;
+}
+
+/**
+ * @return how long a movement takes at the rate from set_estimate_rate(), then on_target_time for the PID to
+ * settle. -1 if the rate was never set
+ */
+double PIDFF::estimate_time(double start_pt, double set_pt)
+{
+    if (est_max_v <= 0 || est_accel <= 0)
+        return -1;
+
+    TrapezoidProfile estimate(est_max_v, est_accel);
+    estimate.set_endpts(start_pt, set_pt);
+    return estimate.get_movement_time() + pid.config.on_target_time;
+}
@@ -0,0 +1,233 @@
+#include "../core/include/utils/relay_autotuner.h"
+#include <cmath>
+
+/**
+ * Create a relay autotuner
+ * @param config the configuration of the relay test
+ */
+RelayAutotuner::RelayAutotuner(relay_config_t &config)
+    : config(config)
+{
+}
+
+/**
+ * Start (or restart) the test
+ */
+void RelayAutotuner::init()
+{
+  first_update = true;
+  done = false;
+  result = false;
+  switches = 0;
+  last_rise_time = 0;
+  period_sum = 0;
+  amplitude_sum = 0;
+  measured_cycles = 0;
+  ku = 0;
+  tu = 0;
+  out = 0;
+
+  tmr.reset();
+}
+
+/**
+ * Update the relay with new sensor data
+ * @param sensor_val the distance, angle, RPM or whatever it is we are measuring
+ * @return the output to command the system with. 0 once the test is over
+ */
+double RelayAutotuner::update(double sensor_val)
+{
+  if (done)
+    return out;
+
+  double now = tmr.value();
+
+  // First update, start pushing towards the setpoint
+  if (first_update)
+  {
+    relay_high = sensor_val < config.setpoint;
+    cycle_max = cycle_min = sensor_val;
+    first_update = false;
+  }
+
+  cycle_max = fmax(cycle_max, sensor_val);
+  cycle_min = fmin(cycle_min, sensor_val);
+
+  if (relay_high && sensor_val > config.setpoint + config.hysteresis)
+  {
+    relay_high = false;
+  }
+  else if (!relay_high && sensor_val < config.setpoint - config.hysteresis)
+  {
+    relay_high = true;
+    switches++;
+
+    // The first cycle is still settling from wherever we started, so only measure from the second on
+    if (switches >= 3)
+    {
+      period_sum += now - last_rise_time;
+      amplitude_sum += cycle_max - cycle_min;
+      measured_cycles++;
+    }
+
+    last_rise_time = now;
+    cycle_max = cycle_min = sensor_val;
+  }
+
+  if (measured_cycles >= config.cycles && measured_cycles > 0)
+  {
+    // a is the amplitude of the oscillation (half of peak to peak)
+    double a = amplitude_sum / measured_cycles / 2.0;
+    tu = period_sum / measured_cycles;
+
+    // Correct for hysteresis, which makes the oscillation look bigger than it would be with an ideal relay
+    if (a > config.hysteresis)
+      ku = (4.0 * config.amplitude) / (M_PI * sqrt((a * a) - (config.hysteresis * config.hysteresis)));
+    else if (a > 0)
+      ku = (4.0 * config.amplitude) / (M_PI * a);
+
+    result = (ku > 0 && tu > 0);
+    done = true;
+    out = 0;
+
+    printf("(relay_autotuner.cpp): Ku: %f, Tu: %f\n", ku, tu);
+    return out;
+  }
+
+  if (config.timeout > 0 && now > config.timeout)
+  {
+    printf("(relay_autotuner.cpp): Warning - timed out after %d cycles. Is the amplitude large enough to reach the setpoint?\n", measured_cycles);
+    done = true;
+    out = 0;
+    return out;
+  }
+
+  out = relay_high ? config.bias + config.amplitude : config.bias - config.amplitude;
+  return out;
+}
+
+/**
+ * @return the last output of the relay
+ */
+double RelayAutotuner::get()
+{
+  return out;
+}
+
+/**
+ * @return true if the test has finished, either because it measured enough cycles or it timed out
+ */
+bool RelayAutotuner::is_done()
+{
+  return done;
+}
+
+/**
+ * @return true if the test finished, and measured enough cycles to find Ku and Tu
+ */
+bool RelayAutotuner::has_result()
+{
+  return result;
+}
+
+/**
+ * @return the ultimate gain, Ku. 0 if there is no result
+ */
+double RelayAutotuner::get_ultimate_gain()
+{
+  return ku;
+}
+
+/**
+ * @return the ultimate period, Tu, in seconds. 0 if there is no result
+ */
+double RelayAutotuner::get_ultimate_period()
+{
+  return tu;
+}
+
+/**
+ * Calculate PID gains from the test results. All other fields of the config are copied from `base`
+ * @param rule the tuning rule to use
+ * @param base the config to take deadband, on_target_time, etc. from
+ * @return the new PID configuration
+ */
+PID::pid_config_t RelayAutotuner::get_gains(TuningRule rule, const PID::pid_config_t &base)
+{
+  PID::pid_config_t gains = base;
+  if (!result)
+    return gains;
+
+  // kP as a fraction of Ku, and the integral and derivative times as a fraction of Tu
+  double kp = 0, ti = 0, td = 0;
+  switch (rule)
+  {
+  case PESSEN_INTEGRAL:
+    kp = 0.7 * ku; ti = 0.4 * tu; td = 0.15 * tu;
+    break;
+  case ZIEGLER_NICHOLS:
+    kp = 0.6 * ku; ti = 0.5 * tu; td = 0.125 * tu;
+    break;
+  case SOME_OVERSHOOT:
+    kp = 0.33 * ku; ti = 0.5 * tu; td = 0.33 * tu;
+    break;
+  case NO_OVERSHOOT:
+    kp = 0.2 * ku; ti = 0.5 * tu; td = 0.33 * tu;
+    break;
+  case TYREUS_LUYBEN:
+    kp = 0.45 * ku; ti = 2.2 * tu; td = tu / 6.3;
+    break;
+  case ZIEGLER_NICHOLS_PI:
+    kp = 0.45 * ku; ti = tu / 1.2; td = 0;
+    break;
+  }
+
+  gains.p = kp;
+  gains.i = (ti > 0) ? kp / ti : 0;
+  gains.d = kp * td;
+
+  return gains;
+}
+
+/**
+ * Save the test results and the gains from a tuning rule, so they persist across restarts.
+ * Saved as <name>_ku, <name>_tu, <name>_p, <name>_i and <name>_d
+ * @param serializer where to save the results
+ * @param name the name of the system that was tuned
+ * @param rule the tuning rule to use
+ */
+void RelayAutotuner::save(Serializer &serializer, const std::string &name, TuningRule rule)
+{
+  if (!result)
+  {
+    printf("(relay_autotuner.cpp): Warning - no result to save for %s\n", name.c_str());
+    return;
+  }
+
+  PID::pid_config_t gains = get_gains(rule, PID::pid_config_t{});
+
+  serializer.set_double(name + "_ku", ku);
+  serializer.set_double(name + "_tu", tu);
+  serializer.set_double(name + "_p", gains.p);
+  serializer.set_double(name + "_i", gains.i);
+  serializer.set_double(name + "_d", gains.d);
+}
+
+/**
+ * Load gains that were saved by save(). If they were never saved, cfg is left as it was.
+ * @param serializer where the results were saved
+ * @param name the name of the system that was tuned
+ * @param cfg the PID configuration to load into
+ * @return true if saved gains were found
+ */
+bool RelayAutotuner::load(Serializer &serializer, const std::string &name, PID::pid_config_t &cfg)
+{
+  // A tune always saves a positive Ku, so use it to tell if there are gains saved
+  if (serializer.double_or(name + "_ku", 0) <= 0)
+    return false;
+
+  cfg.p = serializer.double_or(name + "_p", cfg.p);
+  cfg.i = serializer.double_or(name + "_i", cfg.i);
+  cfg.d = serializer.double_or(name + "_d", cfg.d);
+  return true;
+}
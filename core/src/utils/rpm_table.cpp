@@ -0,0 +1,268 @@
+#include "../core/include/utils/rpm_table.h"
+#include <algorithm>
+#include <stdio.h>
+#include <math.h>
+
+/**
+ * Build the serializer key for one field of one entry: <name>_<field>_<i>
+ */
+static std::string entry_key(const std::string &name, const char *field, int i)
+{
+  char buf[16];
+  snprintf(buf, sizeof(buf), "_%s_%d", field, i);
+  return name + buf;
+}
+
+/**
+ * Create a table
+ * @param entries the starting table, in any order
+ */
+RPMTable::RPMTable(std::vector<entry_t> entries) : entries(entries)
+{
+  calculate_slopes();
+}
+
+/**
+ * Replace the table
+ * @param entries the new table, in any order
+ */
+void RPMTable::set_entries(std::vector<entry_t> entries)
+{
+  this->entries = entries;
+  calculate_slopes();
+}
+
+/**
+ * @return the entries of the table, sorted by distance
+ */
+std::vector<RPMTable::entry_t> RPMTable::get_entries()
+{
+  return entries;
+}
+
+/**
+ * @return true if the table has no entries, e.g. it hasn't been calibrated yet
+ */
+bool RPMTable::empty()
+{
+  return entries.empty();
+}
+
+/**
+ * Sort the entries and calculate the slope at each one, using the Fritsch-Carlson method so the interpolation
+ * is monotone between entries
+ */
+void RPMTable::calculate_slopes()
+{
+  std::sort(entries.begin(), entries.end(), [](const entry_t &a, const entry_t &b)
+            { return a.distance < b.distance; });
+
+  int n = entries.size();
+  slopes.assign(n, 0);
+  if (n < 2)
+    return;
+
+  // Slope of each segment
+  std::vector<double> secants(n - 1);
+  for (int i = 0; i < n - 1; i++)
+  {
+    double h = entries[i + 1].distance - entries[i].distance;
+    secants[i] = (h > 0) ? (entries[i + 1].rpm - entries[i].rpm) / h : 0;
+  }
+
+  // Start with the average of the segments on either side, and flat at local extremes
+  slopes[0] = secants[0];
+  slopes[n - 1] = secants[n - 2];
+  for (int i = 1; i < n - 1; i++)
+  {
+    if (secants[i - 1] * secants[i] <= 0)
+      slopes[i] = 0;
+    else
+      slopes[i] = (secants[i - 1] + secants[i]) / 2.0;
+  }
+
+  // Limit the slopes so the curve can't overshoot within a segment
+  for (int i = 0; i < n - 1; i++)
+  {
+    if (secants[i] == 0)
+    {
+      slopes[i] = 0;
+      slopes[i + 1] = 0;
+      continue;
+    }
+
+    double a = slopes[i] / secants[i];
+    double b = slopes[i + 1] / secants[i];
+    double mag = (a * a) + (b * b);
+    if (mag > 9)
+    {
+      double tau = 3.0 / sqrt(mag);
+      slopes[i] = tau * a * secants[i];
+      slopes[i + 1] = tau * b * secants[i];
+    }
+  }
+}
+
+/**
+ * Look up the RPM for a distance
+ * @param distance distance to the goal (inches)
+ * @return the interpolated RPM. 0 if the table is empty
+ */
+double RPMTable::get_rpm(double distance)
+{
+  int n = entries.size();
+  if (n == 0)
+    return 0;
+  if (distance <= entries[0].distance)
+    return entries[0].rpm;
+  if (distance >= entries[n - 1].distance)
+    return entries[n - 1].rpm;
+
+  // Tables are small, so a linear search is as fast as anything
+  int i = 0;
+  while (distance > entries[i + 1].distance)
+    i++;
+
+  // Cubic hermite between entry i and i+1
+  double h = entries[i + 1].distance - entries[i].distance;
+  double t = (distance - entries[i].distance) / h;
+  double t2 = t * t, t3 = t2 * t;
+
+  return ((2 * t3 - 3 * t2 + 1) * entries[i].rpm) + ((t3 - 2 * t2 + t) * h * slopes[i]) + ((-2 * t3 + 3 * t2) * entries[i + 1].rpm) + ((t3 - t2) * h * slopes[i + 1]);
+}
+
+/**
+ * Save the table. Saved as <name>_count, <name>_dist_<i> and <name>_rpm_<i>
+ * @param serializer where to save the table
+ * @param name the name of the table
+ */
+void RPMTable::save(Serializer &serializer, const std::string &name)
+{
+  for (int i = 0; i < (int)entries.size(); i++)
+  {
+    serializer.set_double(entry_key(name, "dist", i), entries[i].distance);
+    serializer.set_double(entry_key(name, "rpm", i), entries[i].rpm);
+  }
+  serializer.set_int(name + "_count", entries.size());
+}
+
+/**
+ * Load a table that was saved by save(). If it was never saved, the table is left as it was
+ * @param serializer where the table was saved
+ * @param name the name of the table
+ * @return true if a saved table was found
+ */
+bool RPMTable::load(Serializer &serializer, const std::string &name)
+{
+  int count = serializer.int_or(name + "_count", 0);
+  if (count <= 0)
+    return false;
+
+  std::vector<entry_t> loaded;
+  for (int i = 0; i < count; i++)
+  {
+    loaded.push_back({.distance = serializer.double_or(entry_key(name, "dist", i), 0),
+                      .rpm = serializer.double_or(entry_key(name, "rpm", i), 0)});
+  }
+
+  set_entries(loaded);
+  return true;
+}
+
+/**
+ * Record a calibration shot
+ * @param distance distance to the goal when the shot was taken (inches)
+ * @param rpm the RPM the flywheel was at
+ * @param result whether it hit, or which way it missed
+ */
+void RPMTable::record_shot(double distance, double rpm, ShotResult result)
+{
+  shots.push_back({.distance = distance, .rpm = rpm, .result = result});
+}
+
+/**
+ * Throw away all recorded calibration shots
+ */
+void RPMTable::clear_shots()
+{
+  shots.clear();
+}
+
+/**
+ * @return how many calibration shots have been recorded
+ */
+int RPMTable::get_num_shots()
+{
+  return shots.size();
+}
+
+/**
+ * Build a new table from the calibration shots
+ * @param bin_width how close together (inches) shots are grouped
+ * @return true if the table was replaced
+ */
+bool RPMTable::fit(double bin_width)
+{
+  if (shots.empty() || bin_width <= 0)
+    return false;
+
+  std::vector<shot_t> sorted = shots;
+  std::sort(sorted.begin(), sorted.end(), [](const shot_t &a, const shot_t &b)
+            { return a.distance < b.distance; });
+
+  std::vector<entry_t> fitted;
+  size_t start = 0;
+  while (start < sorted.size())
+  {
+    // A group is every shot within bin_width of the closest one in it
+    size_t end = start;
+    while (end < sorted.size() && sorted[end].distance - sorted[start].distance < bin_width)
+      end++;
+
+    double hit_dist = 0, hit_rpm = 0, all_dist = 0;
+    int hits = 0;
+    double max_short = -1, min_long = -1;
+    for (size_t i = start; i < end; i++)
+    {
+      all_dist += sorted[i].distance;
+      if (sorted[i].result == HIT)
+      {
+        hit_dist += sorted[i].distance;
+        hit_rpm += sorted[i].rpm;
+        hits++;
+      }
+      else if (sorted[i].result == SHORT)
+        max_short = fmax(max_short, sorted[i].rpm);
+      else if (min_long < 0 || sorted[i].rpm < min_long)
+        min_long = sorted[i].rpm;
+    }
+
+    int total = end - start;
+    if (hits > 0)
+    {
+      fitted.push_back({.distance = hit_dist / hits, .rpm = hit_rpm / hits});
+      printf("RPMTable: %.0f in: %.0f rpm (%d/%d hit)\n", hit_dist / hits, hit_rpm / hits, hits, total);
+    }
+    else if (max_short >= 0 && min_long >= 0)
+    {
+      fitted.push_back({.distance = all_dist / total, .rpm = (max_short + min_long) / 2.0});
+      printf("RPMTable: %.0f in: %.0f rpm (no hits, between short and long)\n", all_dist / total, (max_short + min_long) / 2.0);
+    }
+    else
+    {
+      printf("RPMTable: %.0f in: skipped (no hits, and misses only one way)\n", all_dist / total);
+    }
+
+    start = end;
+  }
+  fflush(stdout);
+
+  if (fitted.size() < 2)
+  {
+    printf("(rpm_table.cpp): Warning - not enough distances to fit a table (%d)\n", (int)fitted.size());
+    return false;
+  }
+
+  set_entries(fitted);
+  return true;
+}
@@ -0,0 +1,134 @@
+#include "../core/include/utils/state_space.h"
+#include "../core/include/utils/math_util.h"
+#include <math.h>
+
+// Iterations of the riccati equations when finding the steady state gains. They converge well before this.
+#define RICCATI_ITERATIONS 1000
+
+/**
+ * Create the controller and calculate all of its gains.
+ * Velocity is in units of position per minute (RPM, if position is in revolutions)
+ * @param ff_cfg feedforward constants of the mechanism. kV and kA must be identified (see SysId)
+ * @param cfg    tuning parameters of the controller and estimator
+ */
+VelocityStateSpace::VelocityStateSpace(FeedForward::ff_config_t &ff_cfg, ss_config_t &cfg)
+    : ff_cfg(ff_cfg), cfg(cfg)
+{
+  double dt_sec = cfg.period_ms / 1000.0;
+  dt = dt_sec / 60.0;
+
+  if (ff_cfg.kV <= 0 || ff_cfg.kA <= 0)
+  {
+    printf("(state_space.cpp): Warning - kV and kA must be identified to use state space control\n");
+    return;
+  }
+
+  // ========== Model =========
+  // Exact discretization of kA*dv/dt = u - kV*v over one loop
+  a = exp(-ff_cfg.kV / ff_cfg.kA * dt_sec);
+  b = (1.0 - a) / ff_cfg.kV;
+
+  // ========== Controller =========
+  if (cfg.closed_loop_pole != 0)
+  {
+    // Pole placement: choose k so that the error decays as e[k+1] = pole * e[k]
+    k = (a - cfg.closed_loop_pole) / b;
+  }
+  else
+  {
+    // LQR: minimize sum(Q*e^2 + R*u^2), with Q and R from Bryson's rule
+    double q = 1.0 / (cfg.max_error * cfg.max_error);
+    double r = 1.0 / (cfg.max_effort * cfg.max_effort);
+
+    double p = q;
+    for (int i = 0; i < RICCATI_ITERATIONS; i++)
+      p = q + (a * a * p) - ((a * b * p) * (a * b * p)) / (r + (b * b * p));
+
+    k = (a * b * p) / (r + (b * b * p));
+  }
+
+  // ========== Estimator =========
+  // State is [position, velocity], and we measure position:
+  // F = [1 dt; 0 a], H = [1 0]
+  double qv = cfg.model_stdev * cfg.model_stdev;
+  double rp = cfg.encoder_stdev * cfg.encoder_stdev;
+
+  double p00 = rp, p01 = 0, p11 = qv;
+  for (int i = 0; i < RICCATI_ITERATIONS; i++)
+  {
+    // Predict: P = F P F^T + Q
+    double m00 = p00 + (2 * dt * p01) + (dt * dt * p11);
+    double m01 = (a * p01) + (a * dt * p11);
+    double m11 = (a * a * p11) + qv;
+
+    // Correct: L = P H^T / (H P H^T + R), P = (I - L H) P
+    double s = m00 + rp;
+    l_pos = m00 / s;
+    l_vel = m01 / s;
+
+    p00 = (1 - l_pos) * m00;
+    p01 = (1 - l_pos) * m01;
+    p11 = m11 - (l_vel * m01);
+  }
+}
+
+/**
+ * Reset the estimator to a known position and velocity
+ * @param position the current position
+ * @param velocity the current velocity
+ */
+void VelocityStateSpace::reset(double position, double velocity)
+{
+  x_pos = position;
+  x_vel = velocity;
+  out = 0;
+}
+
+/**
+ * Run one loop of the estimator and controller
+ * @param position the measured position
+ * @param target   the velocity we want
+ * @return the output to send to the motors (percent, -1 -> 1)
+ */
+double VelocityStateSpace::update(double position, double target)
+{
+  // Predict where we are now from the last output
+  double ks_sign = (x_vel != 0) ? sign(x_vel) : sign(out);
+  x_pos += x_vel * dt;
+  x_vel = (a * x_vel) + (b * (out - (ff_cfg.kS * ks_sign)));
+
+  // Correct with the measurement
+  double innovation = position - x_pos;
+  x_pos += l_pos * innovation;
+  x_vel += l_vel * innovation;
+
+  // Feedforward that holds the target exactly, plus the feedback on the remaining error
+  double u_ff = (target != 0) ? (ff_cfg.kS * sign(target)) + (ff_cfg.kV * target) : 0;
+  out = clamp(u_ff + (k * (target - x_vel)), -1, 1);
+
+  return out;
+}
+
+/**
+ * @return the estimated velocity
+ */
+double VelocityStateSpace::get_velocity()
+{
+  return x_vel;
+}
+
+/**
+ * @return the last output
+ */
+double VelocityStateSpace::get()
+{
+  return out;
+}
+
+/**
+ * @return the controller's gain (percent per unit of velocity error)
+ */
+double VelocityStateSpace::get_control_gain()
+{
+  return k;
+}
@@ -0,0 +1,268 @@
+#include "../core/include/utils/sysid.h"
+#include "../core/include/utils/math_util.h"
+#include <math.h>
+
+// Samples within this many samples on either side are used to find velocity and acceleration
+#define FIT_HALF_WINDOW 5
+
+// Below this velocity the mechanism is treated as stopped, since sgn(v) isn't meaningful there.
+// As a fraction of the fastest velocity seen in the data.
+#define STOPPED_FRACTION 0.02
+
+// Most regressors in the model: sgn(v), v, a, 1
+#define MAX_TERMS 4
+
+/**
+ * Create a system identification routine
+ * @param set_output    sets the output of the mechanism, in percent (-1.0 -> 1.0)
+ * @param get_velocity  gets the velocity of the mechanism, positive in the direction of positive output
+ * @param cfg           the parameters of the tests
+ * @param max_samples   the size of the sample buffer. allocated once, here
+ */
+SysId::SysId(std::function<void(double)> set_output, std::function<double(void)> get_velocity, sysid_cfg_t &cfg, int max_samples)
+    : set_output(set_output), get_velocity(get_velocity), cfg(cfg), max_samples(max_samples)
+{
+  samples.reserve(max_samples);
+}
+
+/**
+ * Run all four tests (quasistatic and dynamic, forward and reverse), then fit the results.
+ * Blocks until the tests are done. The mechanism will move, so give it room!
+ * @param pause_sec how long to wait between tests, for the mechanism to come to a stop
+ * @return the fitted constants, and how well they fit
+ */
+SysId::sysid_result_t SysId::run(double pause_sec)
+{
+  clear();
+
+  TestType types[] = {QUASISTATIC, QUASISTATIC, DYNAMIC, DYNAMIC};
+  bool reverses[] = {false, true, false, true};
+
+  for (int i = 0; i < 4; i++)
+  {
+    run_test(types[i], reverses[i]);
+    vexDelay(pause_sec * 1000);
+  }
+
+  sysid_result_t result = solve();
+  print_result(result);
+  return result;
+}
+
+/**
+ * Run a single test, adding to the recorded data. Blocks until the test is done.
+ * @param type    quasistatic or dynamic
+ * @param reverse true to run the test with negative output
+ */
+void SysId::run_test(TestType type, bool reverse)
+{
+  double dir = reverse ? -1.0 : 1.0;
+  double duration = (type == QUASISTATIC) ? cfg.quasistatic_time : cfg.dynamic_time;
+  int period_ms = (cfg.period_ms > 0) ? cfg.period_ms : 10;
+
+  vex::timer tmr;
+  double time = 0;
+
+  while (time < duration)
+  {
+    time = tmr.time(vex::sec);
+
+    double output = (type == QUASISTATIC) ? dir * cfg.ramp_rate * time : dir * cfg.step_pct;
+    output = clamp(output, -1, 1);
+
+    set_output(output);
+
+    if ((int)samples.size() < max_samples)
+      samples.push_back({.time = time, .output = output, .velocity = get_velocity(), .test = num_tests});
+
+    vexDelay(period_ms);
+  }
+
+  set_output(0);
+
+  if ((int)samples.size() >= max_samples)
+    printf("(sysid.cpp): Warning - sample buffer full. Make max_samples bigger or the tests shorter\n");
+
+  num_tests++;
+}
+
+/**
+ * Solve the square system A*x = b in place with gaussian elimination
+ * @return false if the system is singular
+ */
+static bool solve_linear_system(double a[MAX_TERMS][MAX_TERMS], double b[MAX_TERMS], double x[MAX_TERMS], int n)
+{
+  for (int col = 0; col < n; col++)
+  {
+    // Partial pivoting, for numerical stability
+    int pivot = col;
+    for (int row = col + 1; row < n; row++)
+      if (fabs(a[row][col]) > fabs(a[pivot][col]))
+        pivot = row;
+
+    if (fabs(a[pivot][col]) < 1e-12)
+      return false;
+
+    for (int k = 0; k < n; k++)
+    {
+      double tmp = a[col][k];
+      a[col][k] = a[pivot][k];
+      a[pivot][k] = tmp;
+    }
+    double tmp = b[col];
+    b[col] = b[pivot];
+    b[pivot] = tmp;
+
+    for (int row = col + 1; row < n; row++)
+    {
+      double factor = a[row][col] / a[col][col];
+      for (int k = col; k < n; k++)
+        a[row][k] -= factor * a[col][k];
+      b[row] -= factor * b[col];
+    }
+  }
+
+  for (int row = n - 1; row >= 0; row--)
+  {
+    double sum = b[row];
+    for (int k = row + 1; k < n; k++)
+      sum -= a[row][k] * x[k];
+    x[row] = sum / a[row][row];
+  }
+
+  return true;
+}
+
+/**
+ * Fit the feedforward constants to all data recorded so far
+ * @return the fitted constants, and how well they fit
+ */
+SysId::sysid_result_t SysId::solve()
+{
+  sysid_result_t result = {};
+  int n_terms = cfg.fit_kg ? 4 : 3;
+  int n = samples.size();
+
+  double max_vel = 0;
+  for (int i = 0; i < n; i++)
+    max_vel = fmax(max_vel, fabs(samples[i].velocity));
+
+  // Velocity and acceleration at each sample come from a line fit through the samples around it.
+  // This smooths out sensor noise without the lag of a moving average.
+  std::vector<double> vels, accels, outputs;
+  vels.reserve(n);
+  accels.reserve(n);
+  outputs.reserve(n);
+
+  for (int i = FIT_HALF_WINDOW; i < n - FIT_HALF_WINDOW; i++)
+  {
+    if (samples[i - FIT_HALF_WINDOW].test != samples[i].test || samples[i + FIT_HALF_WINDOW].test != samples[i].test)
+      continue;
+
+    double t_mean = 0, v_mean = 0;
+    for (int j = i - FIT_HALF_WINDOW; j <= i + FIT_HALF_WINDOW; j++)
+    {
+      t_mean += samples[j].time;
+      v_mean += samples[j].velocity;
+    }
+    t_mean /= (2 * FIT_HALF_WINDOW + 1);
+    v_mean /= (2 * FIT_HALF_WINDOW + 1);
+
+    double num = 0, den = 0;
+    for (int j = i - FIT_HALF_WINDOW; j <= i + FIT_HALF_WINDOW; j++)
+    {
+      num += (samples[j].time - t_mean) * (samples[j].velocity - v_mean);
+      den += (samples[j].time - t_mean) * (samples[j].time - t_mean);
+    }
+
+    if (den <= 0 || fabs(v_mean) < STOPPED_FRACTION * max_vel)
+      continue;
+
+    vels.push_back(v_mean);
+    accels.push_back(num / den);
+    outputs.push_back(samples[i].output);
+  }
+
+  int m = vels.size();
+  result.num_samples = m;
+  if (m <= n_terms)
+  {
+    printf("(sysid.cpp): Warning - not enough moving samples to fit (%d)\n", m);
+    return result;
+  }
+
+  // Build the normal equations (X^T X) k = X^T y
+  double xtx[MAX_TERMS][MAX_TERMS] = {};
+  double xty[MAX_TERMS] = {};
+  for (int i = 0; i < m; i++)
+  {
+    double x[MAX_TERMS] = {sign(vels[i]), vels[i], accels[i], 1.0};
+    for (int r = 0; r < n_terms; r++)
+    {
+      for (int c = 0; c < n_terms; c++)
+        xtx[r][c] += x[r] * x[c];
+      xty[r] += x[r] * outputs[i];
+    }
+  }
+
+  double k[MAX_TERMS] = {};
+  if (!solve_linear_system(xtx, xty, k, n_terms))
+  {
+    printf("(sysid.cpp): Warning - data can't be fit. Did the mechanism move in both directions?\n");
+    return result;
+  }
+
+  result.ff.kS = k[0];
+  result.ff.kV = k[1];
+  result.ff.kA = k[2];
+  result.ff.kG = cfg.fit_kg ? k[3] : 0;
+
+  // Goodness of fit
+  double y_mean = 0;
+  for (int i = 0; i < m; i++)
+    y_mean += outputs[i];
+  y_mean /= m;
+
+  double ss_res = 0, ss_tot = 0;
+  for (int i = 0; i < m; i++)
+  {
+    double predicted = (k[0] * sign(vels[i])) + (k[1] * vels[i]) + (k[2] * accels[i]) + result.ff.kG;
+    double residual = outputs[i] - predicted;
+    ss_res += residual * residual;
+    ss_tot += (outputs[i] - y_mean) * (outputs[i] - y_mean);
+    result.max_residual = fmax(result.max_residual, fabs(residual));
+  }
+
+  result.r_squared = (ss_tot > 0) ? 1.0 - (ss_res / ss_tot) : 0;
+  result.rms_residual = sqrt(ss_res / m);
+  result.valid = true;
+
+  return result;
+}
+
+/**
+ * Throw away all recorded data
+ */
+void SysId::clear()
+{
+  samples.clear();
+  num_tests = 0;
+}
+
+/**
+ * Print the results of a fit
+ * @param result the results from run() or solve()
+ */
+void SysId::print_result(const sysid_result_t &result)
+{
+  if (!result.valid)
+  {
+    printf("SysId: no valid fit\n");
+    fflush(stdout);
+    return;
+  }
+
+  printf("SysId: kS: %f, kV: %f, kA: %f, kG: %f\n", result.ff.kS, result.ff.kV, result.ff.kA, result.ff.kG);
+  printf("SysId: R^2: %f, RMS residual: %f, max residual: %f, samples: %d\n", result.r_squared, result.rms_residual, result.max_residual, result.num_samples);
+  fflush(stdout);
+}
@@ -4,22 +4,71 @@
 
 
 TrapezoidProfile::TrapezoidProfile(double max_v, double accel)
-: start(0), end(0), max_v(max_v), accel(accel)  {}
+: start(0), end(0), start_vel(0), end_vel(0), max_v(max_v), accel(accel)
+{
+    precalculate();
+}
 
 void TrapezoidProfile::set_max_v(double max_v)
 {
     this->max_v = max_v;
+    precalculate();
 }
 
 void TrapezoidProfile::set_accel(double accel)
 {
     this->accel = accel;
+    precalculate();
 }
 
 void TrapezoidProfile::set_endpts(double start, double end)
 {
     this->start = start;
     this->end = end;
+    precalculate();
+}
+
+void TrapezoidProfile::set_vel_endpts(double start_vel, double end_vel)
+{
+    this->start_vel = start_vel;
+    this->end_vel = end_vel;
+    precalculate();
+}
+
+/**
+ * Calculate the time spent in the acceleration / maximum velocity / deceleration stages.
+ * All the math here is done on magnitudes; calculate() applies the direction of travel.
+ */
+void TrapezoidProfile::precalculate()
+{
+    double dist = fabs(end - start);
+
+    v_start = clamp(start_vel, 0, max_v);
+
+    // Don't ask for an ending velocity that can't be reached (or slowed down to) within the distance
+    double v_end_min = sqrt(fmax(v_start * v_start - 2 * accel * dist, 0));
+    double v_end_max = fmin(sqrt(v_start * v_start + 2 * accel * dist), max_v);
+    v_end = clamp(end_vel, v_end_min, v_end_max);
+
+    // Distance covered getting up to and down from max_v
+    double accel_dist = (max_v * max_v - v_start * v_start) / (2 * accel);
+    double decel_dist = (max_v * max_v - v_end * v_end) / (2 * accel);
+
+    if (accel_dist + decel_dist <= dist)
+    {
+        // Trapezoid: there is enough room to reach max_v
+        peak_v = max_v;
+        max_vel_time = (dist - accel_dist - decel_dist) / max_v;
+    } else
+    {
+        // S profile: solve for the velocity where the acceleration and deceleration legs meet
+        peak_v = sqrt((2 * accel * dist + v_start * v_start + v_end * v_end) / 2.0);
+        max_vel_time = 0;
+    }
+
+    accel_time = (peak_v - v_start) / accel;
+    decel_time = (peak_v - v_end) / accel;
+    this->time = accel_time + max_vel_time + decel_time;
 }
 
 // Kinematic equations as macros
@@ -34,29 +83,8 @@ void TrapezoidProfile::set_endpts(double start, double end)
  */
 motion_t TrapezoidProfile::calculate(double time_s)
 {
-    double delta_pos = end - start;
-
-    // redefine accel and max_v in this scope for negative calcs
-    double accel_local = this->accel;
-    double max_v_local = this->max_v;
-    if(delta_pos < 0)
-    {
-        accel_local = -this->accel;
-        max_v_local = -this->max_v;
-    }
-
-    // Calculate the time spent during the acceleration / maximum velocity / deceleration stages
-    double accel_time = max_v_local / accel_local;
-    double max_vel_time = (delta_pos - (accel_local * accel_time * accel_time)) / max_v_local;
-    this->time = (2 * accel_time) + max_vel_time;
-
-    // If the time during the "max velocity" state is negative, use an S profile
-    if (max_vel_time < 0)
-    {
-        accel_time = sqrt(fabs(delta_pos / accel));
-        max_vel_time = 0;
-        this->time = 2 * accel_time;
-    }
+    // Direction of travel. Every output is calculated as a magnitude, then multiplied by this.
+    double dir = sign(end - start);
 
     motion_t out;
 
@@ -64,16 +92,16 @@ motion_t TrapezoidProfile::calculate(double time_s)
     if (time_s < 0)
     {
         out.pos = start;
-        out.vel = 0;
+        out.vel = dir * v_start;
         out.accel = 0;
         return out;
     }
 
     // Handle after the setpoint is reached
-    if (time_s > 2*accel_time + max_vel_time)
+    if (time_s > this->time)
     {
         out.pos = end;
-        out.vel = 0;
+        out.vel = dir * v_end;
         out.accel = 0;
         return out;
     }
@@ -83,29 +111,30 @@ motion_t TrapezoidProfile::calculate(double time_s)
     // Displacement from initial acceleration
     if(time_s < accel_time)
     {
-        out.pos = start + CALC_POS(time_s, accel_local, 0, 0);
-        out.vel = CALC_VEL(time_s, accel_local, 0);
-        out.accel = accel_local;
+        out.pos = start + dir * CALC_POS(time_s, accel, v_start, 0);
+        out.vel = dir * CALC_VEL(time_s, accel, v_start);
+        out.accel = dir * accel;
         return out;
     }
 
-    double s_accel = CALC_POS(accel_time, accel_local, 0, 0);
+    double s_accel = CALC_POS(accel_time, accel, v_start, 0);
 
     // Displacement during maximum velocity
     if (time_s < accel_time + max_vel_time)
     {
-        out.pos = start + CALC_POS(time_s - accel_time, 0, max_v_local, s_accel);
-        out.vel = sign(delta_pos) * max_v;
+        out.pos = start + dir * CALC_POS(time_s - accel_time, 0, peak_v, s_accel);
+        out.vel = dir * peak_v;
         out.accel = 0;
         return out;
     }
 
-    double s_max_vel = CALC_POS(max_vel_time, 0, max_v_local, s_accel);
+    double s_max_vel = CALC_POS(max_vel_time, 0, peak_v, s_accel);
 
     // Displacement during deceleration
-    out.pos = start + CALC_POS(time_s - (2*accel_time) - max_vel_time, -accel_local, 0, s_accel + s_max_vel);
-    out.vel = CALC_VEL(time_s - accel_time - max_vel_time, -accel_local, max_v_local);
-    out.accel = -accel_local;
+    double t_decel = time_s - accel_time - max_vel_time;
+    out.pos = start + dir * CALC_POS(t_decel, -accel, peak_v, s_max_vel);
+    out.vel = dir * CALC_VEL(t_decel, -accel, peak_v);
+    out.accel = -dir * accel;
     return out;
 
 }
@@ -114,4 +143,3 @@ double TrapezoidProfile::get_movement_time()
 {
     return time;
 }
-
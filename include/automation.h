@@ -14,6 +14,26 @@ void flap_up();
 
 void flap_down();
 
+/**
+ * @return the RPM table for the current position of the flap
+ */
+RPMTable &current_rpm_table();
+
+/**
+ * @return where the goal we are targeting is on the field
+ */
+point_t current_goal();
+
+/**
+ * @return the distance from the robot to the goal we are targeting (inches)
+ */
+double goal_distance();
+
+/**
+ * @return the RPM to shoot at from where the robot is now. For Flywheel::spinRPMTracking
+ */
+double goal_tracking_rpm();
+
 
 /**
  * SpinRollerCommand is an ACS command that tells the robot spin the roller to the team color
@@ -60,6 +80,11 @@ public:
    * @returns true when execution is complete, false otherwise
    */
   bool run() override;
+  /**
+   * Shooting takes as long as it's set for
+   * Overrides estimate_seconds from AutoCommand
+   */
+  double estimate_seconds(pose_t &pose) override;
 
 private:
   vex::motor &firing_motor;
@@ -82,6 +107,10 @@ public:
    * @returns true when execution is complete, false otherwise
    */
   bool run() override;
+  /**
+   * Starting the intake is instant
+   */
+  double estimate_seconds(pose_t &pose) override;
 
 private:
   vex::motor &intaking_motor;
@@ -117,6 +146,10 @@ public:
    * @returns true when execution is complete, false otherwise
    */
   bool run() override;
+  /**
+   * Stopping the intake is instant
+   */
+  double estimate_seconds(pose_t &pose) override;
 
 private:
   vex::motor &intaking_motor;
@@ -217,11 +250,22 @@ public:
 
   bool run() override;
 
+  /**
+   * Estimate how long the turn takes, and turn the predicted pose to face the point
+   */
+  double estimate_seconds(pose_t &pose) override;
+
+  /**
+   * Stop turning if we're cut off
+   */
+  void on_timeout() override;
+
 private:
   TankDrive &drive_sys;
   OdometryTank &odom;
   Feedback &feedback;
   point_t point;
+  TankDrive::drive_motion_t motion;
 };
 
 class FunctionCommand : public AutoCommand
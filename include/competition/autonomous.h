@@ -5,18 +5,22 @@
 // drive commands
 #define DRIVE_TO_POINT_FAST(x,y,dir) (new DriveToPointCommand(drive_sys, drive_fast_mprofile, x, y, directionType::dir))
 #define DRIVE_TO_POINT_SLOW(x,y,dir) (new DriveToPointCommand(drive_sys, drive_slow_mprofile, x, y, directionType::dir))
+#define DRIVE_ARC_TO_POINT_FAST(px,py,dir) (new DriveArcToPointCommand(drive_sys, drive_fast_mprofile, {.x=px, .y=py}, directionType::dir))
 #define DRIVE_FORWARD_FAST(in, dir) (new DriveForwardCommand(drive_sys, drive_fast_mprofile, in, directionType::dir))
 #define DRIVE_FORWARD_SLOW(in, dir) (new DriveForwardCommand(drive_sys, drive_slow_mprofile, in, directionType::dir))
 
 // turn commands
 #define TURN_TO_HEADING(dir) (new TurnToHeadingCommand(drive_sys, *config.turn_feedback, dir, TURN_SPEED))
+#define TURN_TO_HEADING_PROFILED(dir) (new TurnToHeadingCommand(drive_sys, turn_mprofile, dir, TURN_SPEED))
 #define TURN_DEGREES(dir) (new TurnDegreesCommand(drive_sys, *config.turn_feedback, dir, TURN_SPEED))
 #define TURN_TO_POINT(pt) (new TurnToPointCommand(drive_sys, odometry_sys, *config.turn_feedback, pt))
 
 // shooting commands
 #define SPIN_FW_AT(rpm) (new SpinRPMCommand(flywheel_sys, rpm))
+#define SPIN_FW_FOR_GOAL (new TrackGoalRPMCommand(flywheel_sys, odometry_sys, current_rpm_table, current_goal))
 #define AUTO_AIM (new VisionAimCommand(true, 150, 5))
 #define WAIT_FOR_FLYWHEEL (new WaitUntilUpToSpeedCommand(flywheel_sys, THRESHOLD_RPM))
+#define WAIT_FOR_RECOVERY(min_ms, shot_sec) (new WaitUntilRecoveredCommand(flywheel_sys, min_ms, (shot_sec) * 1000))
 #define SHOOT_DISK (new ShootCommand(intake, SINGLE_SHOT_TIME, SINGLE_SHOT_VOLT))
 #define TRI_SHOT_DISK (new ShootCommand(intake, TRI_SHOT_TIME, TRI_SHOT_VOLT))
 
@@ -29,4 +33,10 @@
 /**
  * Contains all the code run during autonomous.
  */ 
-void autonomous();
\ No newline at end of file
+void autonomous();
+
+// How each command of the last autonomous went, for the profile page on the brain screen. Written by the
+// autonomous task and read by the screen task, so only touch them while holding auto_profile_mutex
+extern CommandController::command_record_t auto_profile[PROFILE_MAX_RECORDS];
+extern int auto_profile_size;
+extern vex::mutex auto_profile_mutex;
\ No newline at end of file
@@ -19,3 +19,7 @@ void page_four(vex::brain::lcd &screen, int x, int y, int width, int height, boo
 void page_five(vex::brain::lcd &screen, int x, int y, int width, int height, bool first_run);
 
 void page_six(vex::brain::lcd &screen, int x, int y, int width, int height, bool first_run);
+
+void page_seven(vex::brain::lcd &screen, int x, int y, int width, int height, bool first_run);
+
+void page_eight(vex::brain::lcd &screen, int x, int y, int width, int height, bool first_run);
@@ -0,0 +1,37 @@
+#pragma once
+#include "core.h"
+#include <string>
+#include <vector>
+
+/**
+ * Load an autonomous script from the SD card and build it (see auto_script.h for the format).
+ * Called at startup, so any errors are on the screen before the match.
+ * @param filename the script on the SD card
+ * @return true if the script loaded and built without errors
+ */
+bool load_script_auto(const char *filename = "auto.txt");
+
+/**
+ * @return true if a script was loaded without errors, and should be run instead of the built-in autonomous
+ */
+bool has_script_auto();
+
+/**
+ * @return the route built from the script. Only run it once
+ */
+CommandController script_auto();
+
+/**
+ * @return where the robot should end up after the script, from its estimate at load time
+ */
+pose_t script_auto_predicted_end();
+
+/**
+ * @return a one line status of the script: where it was loaded from, or that it failed
+ */
+std::string script_auto_status();
+
+/**
+ * @return every error from loading the script
+ */
+std::vector<std::string> script_auto_errors();
@@ -9,14 +9,20 @@
 #include "../core/include/subsystems/mecanum_drive.h"
 #include "../core/include/subsystems/tank_drive.h"
 #include "../core/include/subsystems/flywheel.h"
+#include "../core/include/subsystems/policy_flywheel.h"
 
 // Utils
 #include "../core/include/utils/command_structure/auto_command.h"
+#include "../core/include/utils/command_structure/auto_script.h"
 #include "../core/include/utils/command_structure/command_controller.h"
+#include "../core/include/utils/command_structure/command_groups.h"
 #include "../core/include/utils/command_structure/delay_command.h"
 #include "../core/include/utils/command_structure/drive_commands.h"
 #include "../core/include/utils/command_structure/flywheel_commands.h"
+#include "../core/include/utils/command_structure/lift_commands.h"
 #include "../core/include/utils/auto_chooser.h"
+#include "../core/include/utils/battery_compensation.h"
+#include "../core/include/utils/control_loop.h"
 #include "../core/include/utils/feedforward.h"
 #include "../core/include/utils/generic_auto.h"
 #include "../core/include/utils/math_util.h"
@@ -24,6 +30,9 @@
 #include "../core/include/utils/pid.h"
 #include "../core/include/utils/pidff.h"
 #include "../core/include/utils/pure_pursuit.h"
+#include "../core/include/utils/state_space.h"
+#include "../core/include/utils/sysid.h"
+#include "../core/include/utils/rpm_table.h"
 #include "../core/include/utils/trapezoid_profile.h"
 #include "../core/include/utils/geometry.h"
 #include "../core/include/utils/vector2d.h"
@@ -37,18 +37,23 @@ extern vex::optical roller_sensor;
 // Drive Tuning
 
 
-extern PID::pid_config_t drive_pid_cfg, turn_pid_cfg;
+extern PID::pid_config_t drive_pid_cfg, turn_pid_cfg, turn_mprofile_pid_cfg;
 extern FeedForward::ff_config_t drive_ff_cfg, turn_ff_cfg;
 extern MotionController::m_profile_cfg_t drive_fast_mprofile_cfg, drive_slow_mprofile_cfg;
-// extern MotionController::m_profile_cfg_t turn_fast_mprofile_cfg, turn_slow_mprofile_cfg;
+extern MotionController::m_profile_cfg_t turn_mprofile_cfg;
 
 extern MotionController drive_fast_mprofile, drive_slow_mprofile, drive_super_fast_mprofile;
-// extern MotionController turn_fast_mprofile, turn_slow_mprofile;
+extern MotionController turn_mprofile;
+extern PIDFF turn_pidff;
 extern robot_specs_t config;
 
 // Flywheel Tuning
 extern FeedForward::ff_config_t flywheel_ff_cfg;
 extern PID::pid_config_t flywheel_pid_cfg;
+extern VelocityStateSpace::ss_config_t flywheel_ss_cfg;
+extern Flywheel::shot_config_t flywheel_shot_cfg;
+extern RPMTable flywheel_rpm_table, flywheel_rpm_table_flap;
+extern point_t red_goal_pos, blue_goal_pos;
 
 // ======== SUBSYSTEMS ========
 extern OdometryTank odometry_sys;
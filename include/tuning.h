@@ -20,11 +20,20 @@ void tune_drive_ff_kv(DriveType dt, double ks);
 void tune_drive_pid(DriveType dt);
 void tune_drive_motion_maxv(DriveType dt);
 void tune_drive_motion_accel(DriveType dt, double maxv);
+void tune_drive_relay(DriveType dt);
+void tune_drive_sysid();
+void tune_turn_sysid();
 
 // Flywheel Tuning
 void tune_flywheel_ff();
 void tune_flywheel_pid();
 void tune_flywheel_distcalc();
+void tune_flywheel_relay();
+void tune_flywheel_sysid();
+void calibrate_rpm_table();
+
+// Relay autotuner results
+void load_tuned_gains();
 
 void tune_shooting();
 
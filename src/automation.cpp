@@ -27,11 +27,50 @@ void flap_down()
 {
   flapup_solenoid.set(true);
 }
+
+/**
+ * @return the RPM table for the current position of the flap
+ */
+RPMTable &current_rpm_table()
+{
+  return flapup_solenoid.value() ? flywheel_rpm_table_flap : flywheel_rpm_table;
+}
+
+/**
+ * @return where the goal we are targeting is on the field
+ */
+point_t current_goal()
+{
+  return target_red ? red_goal_pos : blue_goal_pos;
+}
+
+/**
+ * @return the distance from the robot to the goal we are targeting (inches)
+ */
+double goal_distance()
+{
+  pose_t pos = odometry_sys.get_position();
+  point_t here = {.x = pos.x, .y = pos.y};
+  return here.dist(current_goal());
+}
+
+/**
+ * @return the RPM to shoot at from where the robot is now. For Flywheel::spinRPMTracking
+ * If the table for the flap's position hasn't been calibrated, the flywheel stays at the speed it's at
+ */
+double goal_tracking_rpm()
+{
+  RPMTable &table = current_rpm_table();
+  if (table.empty())
+    return flywheel_sys.getDesiredRPM();
+
+  return table.get_rpm(goal_distance());
+}
 /**
  * Construct a FlapUpCommand
  * when run it flaps the flap up
  */
-FlapUpCommand::FlapUpCommand() {}
+FlapUpCommand::FlapUpCommand() { requirements.push_back(&flapup_solenoid); }
 bool FlapUpCommand::run()
 {
   flap_up();
@@ -41,7 +80,7 @@ bool FlapUpCommand::run()
  * Construct a FlapDownCommand
  * when run it flaps the flap down
  */
-FlapDownCommand::FlapDownCommand() {}
+FlapDownCommand::FlapDownCommand() { requirements.push_back(&flapup_solenoid); }
 bool FlapDownCommand::run()
 {
   flap_down();
@@ -73,7 +112,7 @@ Pepsi get_roller_scored()
  * Construct a SpinRollerCommand
  * @param align_pos The motor that will spin the roller
  */
-SpinRollerCommand::SpinRollerCommand(pose_t align_pos): align_pos(align_pos), roller_count(0) {}
+SpinRollerCommand::SpinRollerCommand(pose_t align_pos): align_pos(align_pos), roller_count(0) { requirements.push_back(&drive_sys); }
 
 /**
  * Run roller controller to spin the roller to our color
@@ -83,17 +122,24 @@ SpinRollerCommand::SpinRollerCommand(pose_t align_pos): align_pos(align_pos), ro
 
 bool SpinRollerCommand::run()
 {
+  // Each arena scope ends before its route runs, so nothing another task makes meanwhile ends up in it
   CommandController cmd;
-  cmd.add(new DriveForwardCommand(drive_sys, drive_fast_mprofile, 12, directionType::fwd), 0.5);
-  cmd.add(new FunctionCommand([](){drive_sys.drive_tank(0.2,0.2); return true;}));
-  cmd.add_delay(800);
+  {
+    CommandArena::Scope arena_scope(cmd.get_arena());
+    cmd.add(new DriveForwardCommand(drive_sys, drive_fast_mprofile, 12, directionType::fwd), 0.5);
+    cmd.add(new FunctionCommand([](){drive_sys.drive_tank(0.2,0.2); return true;}));
+    cmd.add_delay(800);
+  }
   cmd.run();
 
   Pepsi cur_roller = get_roller_scored();
 
   CommandController cmd1;
-  cmd1.add(new DriveForwardCommand(drive_sys, drive_fast_mprofile, 6, directionType::rev), 1);
-  cmd1.add(new DriveStopCommand(drive_sys)),
+  {
+    CommandArena::Scope arena_scope1(cmd1.get_arena());
+    cmd1.add(new DriveForwardCommand(drive_sys, drive_fast_mprofile, 6, directionType::rev), 1);
+    cmd1.add(new DriveStopCommand(drive_sys));
+  }
   cmd1.run();
 
   printf("RED? = %d, CUR = %s\n", target_red, cur_roller==RED?"red":cur_roller==BLUE?"blue":"neutral");
@@ -115,7 +161,7 @@ void SpinRollerCommand::on_timeout()
  * Construct a ShootCommand
  * @param firing_motor The motor that will spin the disk into the flywheel
  */
-ShootCommand::ShootCommand(vex::motor &firing_motor, double seconds_to_shoot, double volt) : firing_motor(firing_motor), seconds_to_shoot(seconds_to_shoot), volt(volt) {}
+ShootCommand::ShootCommand(vex::motor &firing_motor, double seconds_to_shoot, double volt) : firing_motor(firing_motor), seconds_to_shoot(seconds_to_shoot), volt(volt) { requirements.push_back(&firing_motor); }
 
 /**
  * Run the intake motor backward to move the disk into the flywheel
@@ -141,12 +187,20 @@ bool ShootCommand::run()
   return false;
 }
 
+/**
+ * Shooting takes as long as it's set for
+ */
+double ShootCommand::estimate_seconds(pose_t &/*pose*/)
+{
+  return seconds_to_shoot;
+}
+
 /**
  * Construct a StartIntakeCommand
  * @param intaking_motor The motor that will pull the disk into the robot
  * @param intaking_voltage The voltage at which to run the intake motor
  */
-StartIntakeCommand::StartIntakeCommand(vex::motor &intaking_motor, double intaking_voltage) : intaking_motor(intaking_motor), intaking_voltage(intaking_voltage) {}
+StartIntakeCommand::StartIntakeCommand(vex::motor &intaking_motor, double intaking_voltage) : intaking_motor(intaking_motor), intaking_voltage(intaking_voltage) { requirements.push_back(&intaking_motor); }
 
 /**
  * Run the StartIntakeCommand
@@ -160,7 +214,15 @@ bool StartIntakeCommand::run()
   return true;
 }
 
-SpinRawCommand::SpinRawCommand(vex::motor &flywheel_motor, double voltage) : flywheel_motor(flywheel_motor), voltage(voltage) {}
+/**
+ * Starting the intake is instant
+ */
+double StartIntakeCommand::estimate_seconds(pose_t &/*pose*/)
+{
+  return 0;
+}
+
+SpinRawCommand::SpinRawCommand(vex::motor &flywheel_motor, double voltage) : flywheel_motor(flywheel_motor), voltage(voltage) { requirements.push_back(&flywheel_motor); }
 
 /**
  * Run the StartIntakeCommand
@@ -178,7 +240,7 @@ bool SpinRawCommand::run()
  * Construct a StartIntakeCommand
  * @param intaking_motor The motor that will be stopped
  */
-StopIntakeCommand::StopIntakeCommand(vex::motor &intaking_motor) : intaking_motor(intaking_motor) {}
+StopIntakeCommand::StopIntakeCommand(vex::motor &intaking_motor) : intaking_motor(intaking_motor) { requirements.push_back(&intaking_motor); }
 
 /**
  * Run the StopIntakeCommand
@@ -191,7 +253,15 @@ bool StopIntakeCommand::run()
   return true;
 }
 
-EndgameCommand::EndgameCommand(vex::digital_out &solenoid) : solenoid(solenoid) {}
+/**
+ * Stopping the intake is instant
+ */
+double StopIntakeCommand::estimate_seconds(pose_t &/*pose*/)
+{
+  return 0;
+}
+
+EndgameCommand::EndgameCommand(vex::digital_out &solenoid) : solenoid(solenoid) { requirements.push_back(&solenoid); }
 bool EndgameCommand::run()
 {
   solenoid.set(true);
@@ -236,7 +306,9 @@ FeedForward::ff_config_t vis_ff_cfg = {
 
 VisionAimCommand::VisionAimCommand(bool odometry_fallback, int vision_center, int fallback_degrees)
     : pidff(vis_pid_cfg, vis_ff_cfg), odometry_fallback(odometry_fallback), first_run(true), fallback_triggered(false), vision_center(vision_center), fallback_degrees(fallback_degrees)
-{}
+{
+  requirements.push_back(&drive_sys);
+}
 
 int VisionAimCommand::get_x(){
 
@@ -356,7 +428,7 @@ void VisionAimCommand::on_timeout()
  * @param drive_sys Reference to the TankDrive system
  * @param point The point we want to turn towards
  */
-TurnToPointCommand::TurnToPointCommand(TankDrive &drive_sys, OdometryTank &odom, Feedback &turn_feedback, point_t point) : drive_sys(drive_sys), odom(odom), feedback(turn_feedback), point(point) {}
+TurnToPointCommand::TurnToPointCommand(TankDrive &drive_sys, OdometryTank &odom, Feedback &turn_feedback, point_t point) : drive_sys(drive_sys), odom(odom), feedback(turn_feedback), point(point) { requirements.push_back(&drive_sys); }
 
 /**
  * Run the TurnToPointCommand
@@ -372,7 +444,27 @@ bool TurnToPointCommand::run()
   // get the angle
   double heading_deg = rad2deg(atan2(delta_y, delta_x));
 
-  return drive_sys.turn_to_heading(heading_deg, feedback);
+  return drive_sys.turn_to_heading(motion, heading_deg, feedback);
+}
+
+/**
+ * Stop turning, and start over the next time we're run
+ */
+void TurnToPointCommand::on_timeout()
+{
+  motion.reset();
+  drive_sys.stop();
+}
+
+/**
+ * Estimate how long the turn takes (the short way), and turn the predicted pose to face the point
+ */
+double TurnToPointCommand::estimate_seconds(pose_t &pose)
+{
+  double heading_deg = rad2deg(atan2(point.y - pose.y, point.x - pose.x));
+  double delta = wrap_angle_deg(heading_deg - pose.rot + 180) - 180;
+  pose.rot = wrap_angle_deg(heading_deg);
+  return feedback.estimate_time(0, fabs(delta));
 }
 
 /**
@@ -400,7 +492,7 @@ bool FunctionCommand::run()
  * @param heading the angle we want to hit the wall at (should never be no change)
  * @param drive_power how fast we want it hit the wall
  */
-WallAlignCommand::WallAlignCommand(TankDrive &drive_sys, OdometryTank &odom, double x, double y, double heading, double drive_power, double time) : drive_sys(drive_sys), odom(odom), x(x), y(y), heading(heading), time(time), func_initialized(false) {}
+WallAlignCommand::WallAlignCommand(TankDrive &drive_sys, OdometryTank &odom, double x, double y, double heading, double drive_power, double time) : drive_sys(drive_sys), odom(odom), x(x), y(y), heading(heading), time(time), func_initialized(false) { requirements.push_back(&drive_sys); }
 
 /**
  * reset the position to that which is specified
@@ -1,5 +1,6 @@
 #include "../include/competition/autonomous.h"
 #include "../include/robot-config.h"
+#include "../include/competition/script_auto.h"
 #include "../core/include/utils/math_util.h"
 
 #define TURN_SPEED 0.6
@@ -8,6 +9,10 @@
 //  CommandController auto_loader_side();
 //  CommandController prog_skills_loader_side();
 
+CommandController::command_record_t auto_profile[PROFILE_MAX_RECORDS];
+int auto_profile_size = 0;
+vex::mutex auto_profile_mutex;
+
 /**
  * Contains all the code run during autonomous.
  */
@@ -20,8 +25,21 @@ void autonomous()
     {
     }
 
-    CommandController current_auto = only_roller_auto();
+    // A script on the SD card takes the place of the built-in auto, so it can be changed without a download
+    CommandController current_auto = has_script_auto() ? script_auto() : only_roller_auto();
     current_auto.run();
+
+    if (has_script_auto())
+    {
+        pose_t predicted = script_auto_predicted_end(), actual = odometry_sys.get_position();
+        printf("Predicted end (%.1f, %.1f) %.0f, actual (%.1f, %.1f) %.0f: off by %.1f in\n", predicted.x, predicted.y, predicted.rot,
+               actual.x, actual.y, actual.rot, sqrt(pow(actual.x - predicted.x, 2) + pow(actual.y - predicted.y, 2)));
+    }
+
+    auto_profile_mutex.lock();
+    auto_profile_size = current_auto.copy_profile(auto_profile, PROFILE_MAX_RECORDS);
+    auto_profile_mutex.unlock();
+    current_auto.save_profile("auto_profile.csv");
     keep_collecting = false;
     while (true)
     {
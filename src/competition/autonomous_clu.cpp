@@ -10,9 +10,11 @@
 #define SINGLE_SHOT_TIME 0.2
 #define SINGLE_SHOT_VOLT 12
 #define SINGLE_SHOT_RECOVER_DELAY_MS 200
+#define SINGLE_SHOT_RECOVER_TIMEOUT 0.5
 #define TRI_SHOT_TIME 1
 #define TRI_SHOT_VOLT 12
 #define TRI_SHOT_RECOVER_DELAY_MS 200
+#define TRI_SHOT_RECOVER_TIMEOUT 0.5
 
 // drive commands
 #define DRIVE_TO_POINT_FAST(x,y,dir) (new DriveToPointCommand(drive_sys, drive_fast_mprofile, x, y, directionType::dir))
@@ -27,6 +29,7 @@
 // shooting commands
 #define AUTO_AIM (new VisionAimCommand(true, 145, 5))
 #define WAIT_FOR_FLYWHEEL (new WaitUntilUpToSpeedCommand(flywheel_sys, THRESHOLD_RPM))
+#define WAIT_FOR_RECOVERY(min_ms, shot_sec) (new WaitUntilRecoveredCommand(flywheel_sys, min_ms, (shot_sec) * 1000))
 #define SHOOT_DISK (new ShootCommand(intake, SINGLE_SHOT_TIME, SINGLE_SHOT_VOLT))
 #define TRI_SHOT_DISK (new ShootCommand(intake, TRI_SHOT_TIME, TRI_SHOT_VOLT))
 
@@ -35,14 +38,14 @@ static void add_single_shot_cmd(CommandController &controller, double timeout=0.
     controller.add(WAIT_FOR_FLYWHEEL, timeout);
     controller.add(AUTO_AIM, timeout);
     controller.add(SHOOT_DISK);
-    controller.add_delay(SINGLE_SHOT_RECOVER_DELAY_MS);
+    controller.add(WAIT_FOR_RECOVERY(SINGLE_SHOT_RECOVER_DELAY_MS, SINGLE_SHOT_TIME), SINGLE_SHOT_RECOVER_TIMEOUT);
 }
 
 static void add_tri_shot_cmd(CommandController &controller, double timeout=0.0)
 {
     controller.add(WAIT_FOR_FLYWHEEL, timeout);
     controller.add(TRI_SHOT_DISK);
-    controller.add_delay(TRI_SHOT_RECOVER_DELAY_MS);
+    controller.add(WAIT_FOR_RECOVERY(TRI_SHOT_RECOVER_DELAY_MS, TRI_SHOT_TIME), TRI_SHOT_RECOVER_TIMEOUT);
 }
 
 void testing()
@@ -87,6 +90,7 @@ CommandController auto_non_loader_side(){
 
     #define PAUSE return nlsa;
     CommandController nlsa;
+    CommandArena::Scope arena_scope(nlsa.get_arena());
 
     // Initialization
     pose_t start_pos = {.x=105.75, .y=86.5, .rot=90}; 
@@ -186,6 +190,7 @@ Map from page 40 of the game manual
 CommandController prog_skills_non_loader_side(){
 
     CommandController nlss;
+    CommandArena::Scope arena_scope(nlss.get_arena());
 
     pose_t start_pos = {.x = 0, .y = 0, .rot = 90};
     nlss.add(new OdomSetPosition(odometry_sys, start_pos));
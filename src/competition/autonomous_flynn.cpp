@@ -23,6 +23,7 @@ int glbl_vision_center = 135;
 const double TRI_SHOT_TIME = 1.0;
 const double TRI_SHOT_VOLT = 2;
 const double TRI_SHOT_RECOVER_DELAY_MS = 200;
+const double TRI_SHOT_RECOVER_TIMEOUT = 0.5;
 
 static void add_single_shot_cmd(CommandController &controller, double vis_timeout = 1.0)
 {
@@ -39,7 +40,7 @@ static void add_tri_shot_cmd(CommandController &controller, double timeout = 0.0
 {
   controller.add(WAIT_FOR_FLYWHEEL, timeout);
   controller.add(TRI_SHOT_DISK, 2.0);
-  controller.add_delay(TRI_SHOT_RECOVER_DELAY_MS);
+  controller.add(WAIT_FOR_RECOVERY(TRI_SHOT_RECOVER_DELAY_MS, TRI_SHOT_TIME), TRI_SHOT_RECOVER_TIMEOUT);
 }
 
 void pleasant_opcontrol();
@@ -177,6 +178,7 @@ CommandController prog_skills_loader_side()
   pose_t roller_in_pos = {.x = 36.0, .y = 4.16, .rot = -90};
 
   CommandController lss;
+  CommandArena::Scope arena_scope(lss.get_arena());
   lss.add(new OdomSetPosition(odometry_sys, start_pos)); // #1
 
   // spin -90 degree roller
@@ -356,6 +358,7 @@ CommandController auto_loader_side()
 {
 
   CommandController lsa;
+  CommandArena::Scope arena_scope(lsa.get_arena());
 
   flap_down();
 
@@ -548,6 +551,7 @@ CommandController auto_loader_side_disks_last()
   point_t pre_roller_pt = {31, 15};
 
   CommandController lsdl;
+  CommandArena::Scope arena_scope(lsdl.get_arena());
   lsdl.add({
       new OdomSetPosition(odometry_sys, start_point_odom),
       TURN_TO_POINT(goal_point),
@@ -583,6 +587,7 @@ CommandController skills_rollers_last()
   auto_tmr.reset();
   flap_down();
   CommandController srl;
+  CommandArena::Scope arena_scope(srl.get_arena());
   srl.add({
               new FlapDownCommand(),
 
@@ -700,8 +705,11 @@ CommandController skills_rollers_last()
                             double needed = 5.0;
                             if (seconds_left > needed){
                               CommandController rollers;
-                              rollers.add(
-                                new SpinRollerCommand({0,0 ,0 }), 4.0); 
+                              {
+                                CommandArena::Scope arena_scope(rollers.get_arena());
+                                rollers.add(
+                                  new SpinRollerCommand({0,0 ,0 }), 4.0);
+                              }
                               rollers.run();
                             }
                           return true; }),
@@ -730,6 +738,7 @@ CommandController disk_rush_auto()
   left_motors.setStopping(vex::brake);
   right_motors.setStopping(vex::brake);
   CommandController dra;
+  CommandArena::Scope arena_scope(dra.get_arena());
   // auto x = new OdomSetPosition()
   dra.add({
               new OdomSetPosition(odometry_sys, {.x = 53.896553, .y = 17.068966, .rot = 135.0}),
@@ -837,6 +846,7 @@ CommandController disk_rush_auto()
 CommandController only_roller_auto()
 {
   CommandController only_r;
+  CommandArena::Scope arena_scope(only_r.get_arena());
   for (int i = 0; i < num_roller_fallback; i++)
   {
     only_r.add({
@@ -857,6 +867,7 @@ CommandController only_roller_auto()
 CommandController only_roller_auto_fancy()
 {
   CommandController only_r;
+  CommandArena::Scope arena_scope(only_r.get_arena());
   only_r.add(new SpinRollerCommand({.x = 32.3, .y = 5.6, .rot = -90}), 35);
   only_r.add({
                  DRIVE_FORWARD_FAST(2, rev),
@@ -869,6 +880,7 @@ CommandController only_roller_auto_fancy()
 CommandController safe_auto()
 {
   CommandController sa;
+  CommandArena::Scope arena_scope(sa.get_arena());
   flap_down();
   sa.add({
              new OdomSetPosition(odometry_sys, {.x = 84.48276, .y = 16.172415, .rot = 90.0}),
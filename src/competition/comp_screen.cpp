@@ -1,4 +1,7 @@
 #include "competition/comp_screen.h"
+#include "competition/autonomous.h"
+#include "competition/script_auto.h"
+#include <algorithm>
 
 void page_one(vex::brain::lcd &screen, int x, int y, int width, int height, bool first_run)
 {
@@ -54,6 +57,8 @@ void page_two(vex::brain::lcd &screen, int x, int y, int width, int height, bool
     screen.printAt(100, 140, "FW setpt: %.2f\t  %.2f", flywheel_sys.getDesiredRPM(), flywheel_sys.getRPM());
 }
 
+static bool inRectangle(int x, int y, int width, int height, int test_x, int test_y);
+
 void page_three(vex::brain::lcd &screen, int x, int y, int width, int height, bool first_run)
 {
     static GraphDrawer setpt(screen, 30, "time", "rpm", vex::red, true, 0, 4000);
@@ -73,6 +78,26 @@ void page_three(vex::brain::lcd &screen, int x, int y, int width, int height, bo
     setpt.draw(x + 4, y, width - 8, height - 40);
     rpm.draw(x + 4, y, width - 8, height - 40);
     screen.printAt(x + width / 2, y + height - 30, "setpt: %.0f, rpm: %.0f", flywheel_sys.getDesiredRPM(), flywheel_sys.getRPM());
+
+    Flywheel::metrics_t metrics = flywheel_sys.getMetrics();
+    screen.printAt(x + 4, y + height - 10, "rise %.2fs os %.0f sse %.0f rec %.2fs (%d)", metrics.rise_time, metrics.overshoot, metrics.steady_state_error, metrics.avg_recovery_time, metrics.shots);
+
+    // Save button, to dump the telemetry after a match
+    static bool saved = false;
+    int save_x = x + width - 70, save_y = y + 4, save_w = 66, save_h = 30;
+    screen.setFillColor(saved ? vex::green : vex::black);
+    screen.drawRectangle(save_x, save_y, save_w, save_h);
+    screen.printAt(save_x + 8, save_y + 22, "Save");
+    screen.setFillColor(vex::transparent);
+
+    // only save once per press
+    static bool was_pressing = false;
+    bool pressing = screen.pressing();
+    if (pressing && !was_pressing && inRectangle(save_x, save_y, save_w, save_h, screen.xPosition(), screen.yPosition()))
+    {
+        saved = flywheel_sys.saveTelemetry("flywheel_telemetry.csv");
+    }
+    was_pressing = pressing;
 }
 
 static bool inRectangle(int x, int y, int width, int height, int test_x, int test_y)
@@ -453,3 +478,75 @@ void page_six(vex::brain::lcd &screen, int x, int y, int width, int height, bool
     }
     was_pressing = pressing;
 }
+
+// profile of the last autonomous: totals, and the commands that took the longest
+void page_seven(vex::brain::lcd &screen, int x, int y, int width, int height, bool first_run)
+{
+    screen.setFillColor(vex::black);
+    screen.setPenColor(vex::black);
+    screen.drawRectangle(x, y, width, height);
+
+    screen.setFont(vex::mono20);
+    screen.setPenColor(vex::white);
+    screen.setFillColor(vex::transparent);
+
+    // Copy the profile out while holding the lock, so the autonomous task can't change it mid-draw
+    static CommandController::command_record_t profile[PROFILE_MAX_RECORDS];
+    auto_profile_mutex.lock();
+    int size = auto_profile_size;
+    for (int i = 0; i < size; i++)
+        profile[i] = auto_profile[i];
+    auto_profile_mutex.unlock();
+
+    if (size == 0)
+    {
+        screen.printAt(x + 10, y + 30, "No auto run yet");
+        return;
+    }
+
+    const CommandController::command_record_t &last = profile[size - 1];
+    double total = (last.start_ms + last.duration_ms) / 1000.0;
+    int timeouts = 0;
+    for (int i = 0; i < size; i++)
+        timeouts += profile[i].timed_out ? 1 : 0;
+
+    screen.printAt(x + 10, y + 30, "Auto: %.2fs  %d cmds  %d timed out", total, size, timeouts);
+
+    // The slowest commands, by index so they can be found in the route
+    int order[PROFILE_MAX_RECORDS];
+    for (int i = 0; i < size; i++)
+        order[i] = i;
+    std::sort(order, order + size, [](int a, int b)
+              { return profile[a].duration_ms > profile[b].duration_ms; });
+
+    const int line_height = 22;
+    screen.printAt(x + 10, y + 30 + line_height, "#    time   ticks  cpu    slack");
+    for (int i = 0; i < size && i < 7; i++)
+    {
+        const CommandController::command_record_t &r = profile[order[i]];
+        screen.setPenColor(r.timed_out ? vex::red : vex::white);
+        screen.printAt(x + 10, y + 30 + (i + 2) * line_height, "%-4d %5.2fs %5d  %5.3fs %5.2fs", order[i] + 1, r.duration_ms / 1000.0,
+                       r.ticks, r.run_us / 1000000.0, r.slack);
+    }
+    screen.setPenColor(vex::white);
+}
+
+// autonomous script from the SD card: where it came from, or what's wrong with it
+void page_eight(vex::brain::lcd &screen, int x, int y, int width, int height, bool first_run)
+{
+    screen.setFillColor(vex::black);
+    screen.setPenColor(vex::black);
+    screen.drawRectangle(x, y, width, height);
+
+    screen.setFont(vex::mono20);
+    screen.setFillColor(vex::transparent);
+    screen.setPenColor(has_script_auto() ? vex::green : vex::white);
+    screen.printAt(x + 10, y + 30, "%s", script_auto_status().c_str());
+
+    const int line_height = 22;
+    std::vector<std::string> errors = script_auto_errors();
+    screen.setPenColor(vex::red);
+    for (size_t i = 0; i < errors.size() && i < 8; i++)
+        screen.printAt(x + 10, y + 30 + (i + 1) * line_height, "%s", errors[i].c_str());
+    screen.setPenColor(vex::white);
+}
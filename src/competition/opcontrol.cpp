@@ -70,8 +70,12 @@ void opcontrol()
   main_controller.ButtonDown.pressed([]()
                                      { flywheel_sys.stop(); });
 
+  // Follow the distance to the goal, once calibrate_rpm_table() has made a table for the flap's position
+  main_controller.ButtonX.pressed([]()
+                                  { if (!current_rpm_table().empty()) flywheel_sys.spinRPMTracking(goal_tracking_rpm); });
+
   main_controller.ButtonR1.pressed([]()
-                                   { intake.spin(reverse, 12, volt); }); // Intake
+                                   { intake.spin(vex::reverse, 12, volt); }); // Intake
   main_controller.ButtonR2.pressed([]()
                                    { intake.spin(fwd, 9.5, volt); }); // Shoot
 
@@ -0,0 +1,198 @@
+#include "competition/script_auto.h"
+#include "robot-config.h"
+#include "automation.h"
+#include <memory>
+
+const double TURN_SPEED = 0.6;
+const double INTAKE_VOLT = 12;
+const double SINGLE_SHOT_TIME = 0.2;
+const double SINGLE_SHOT_VOLT = 6;
+const double TRI_SHOT_TIME = 1.0;
+const double TRI_SHOT_VOLT = 2;
+const double THRESHOLD_RPM = 150;
+const int VISION_CENTER = 150;
+const double AUTO_BUDGET = 15.0;
+
+// The commands a script can use. The order has to match the switch in make_command
+enum ScriptVerb
+{
+  START,
+  DRIVE,
+  DRIVE_TO,
+  TURN_TO,
+  TURN_TO_POINT,
+  PATH,
+  SPIN_RPM,
+  WAIT_FLYWHEEL,
+  SHOOT,
+  TRI_SHOT,
+  AIM,
+  INTAKE,
+  WAIT,
+  STOP
+};
+
+static std::vector<AutoScript::verb_t> script_verbs = {
+    {.name = "start", .min_args = 3, .max_args = 3},         // start x y heading
+    {.name = "drive", .min_args = 2, .max_args = 3},         // drive inches fwd|rev [speed]
+    {.name = "drive_to", .min_args = 3, .max_args = 4},      // drive_to x y fwd|rev [speed]
+    {.name = "turn_to", .min_args = 1, .max_args = 2},       // turn_to heading [speed]
+    {.name = "turn_to_point", .min_args = 2, .max_args = 2}, // turn_to_point x y
+    {.name = "path", .min_args = 3, .max_args = -1},         // path fwd|rev x1 y1 x2 y2 ...
+    {.name = "spin_rpm", .min_args = 1, .max_args = 1},      // spin_rpm rpm
+    {.name = "wait_flywheel", .min_args = 0, .max_args = 0},
+    {.name = "shoot", .min_args = 0, .max_args = 0},
+    {.name = "tri_shot", .min_args = 0, .max_args = 0},
+    {.name = "aim", .min_args = 0, .max_args = 0},
+    {.name = "intake", .min_args = 1, .max_args = 1}, // intake on|off
+    {.name = "wait", .min_args = 1, .max_args = 1},   // wait milliseconds
+    {.name = "stop", .min_args = 0, .max_args = 0},
+};
+
+static std::vector<AutoScript::keyword_t> script_keywords = {
+    {.name = "fwd", .value = 1},
+    {.name = "rev", .value = -1},
+    {.name = "on", .value = 1},
+    {.name = "off", .value = 0},
+};
+
+static vex::directionType to_dir(float val)
+{
+  return (val < 0) ? vex::reverse : vex::forward;
+}
+
+/**
+ * Make the command for one line of the script
+ */
+static AutoCommand *make_command(int verb, const float *args, int argc)
+{
+  switch (verb)
+  {
+  case START:
+    return new OdomSetPosition(odometry_sys, {.x = args[0], .y = args[1], .rot = args[2]});
+  case DRIVE:
+    return new DriveForwardCommand(drive_sys, drive_fast_mprofile, args[0], to_dir(args[1]), (argc > 2) ? args[2] : 1);
+  case DRIVE_TO:
+    return new DriveToPointCommand(drive_sys, drive_fast_mprofile, args[0], args[1], to_dir(args[2]), (argc > 3) ? args[3] : 1);
+  case TURN_TO:
+    return new TurnToHeadingCommand(drive_sys, *config.turn_feedback, args[0], (argc > 1) ? args[1] : TURN_SPEED);
+  case TURN_TO_POINT:
+    return new TurnToPointCommand(drive_sys, odometry_sys, *config.turn_feedback, {.x = args[0], .y = args[1]});
+  case PATH:
+  {
+    if ((argc - 1) % 2 != 0)
+      return NULL;
+
+    // Drive to each point in turn
+    std::vector<point_t> points;
+    for (int i = 1; i < argc; i += 2)
+      points.push_back({.x = args[i], .y = args[i + 1]});
+    vex::directionType dir = to_dir(args[0]);
+    size_t next = 0;
+    // Movements can't be copied, and the function is, so it holds its movement by pointer
+    std::shared_ptr<TankDrive::drive_motion_t> motion = std::make_shared<TankDrive::drive_motion_t>();
+
+    return (new FunctionCommand([points, dir, next, motion]() mutable
+                                {
+      if (drive_sys.drive_to_point(*motion, points[next].x, points[next].y, dir, drive_fast_mprofile))
+        next++;
+      return next >= points.size(); }))
+        ->withRequirement(&drive_sys);
+  }
+  case SPIN_RPM:
+    return new SpinRPMCommand(flywheel_sys, args[0]);
+  case WAIT_FLYWHEEL:
+    return new WaitUntilUpToSpeedCommand(flywheel_sys, THRESHOLD_RPM);
+  case SHOOT:
+    return new ShootCommand(intake, SINGLE_SHOT_TIME, SINGLE_SHOT_VOLT);
+  case TRI_SHOT:
+    return new ShootCommand(intake, TRI_SHOT_TIME, TRI_SHOT_VOLT);
+  case AIM:
+    return new VisionAimCommand(true, VISION_CENTER, 5);
+  case INTAKE:
+    if (args[0] != 0)
+      return new StartIntakeCommand(intake, INTAKE_VOLT);
+    return new StopIntakeCommand(intake);
+  case WAIT:
+    if (args[0] < 0)
+      return NULL;
+    return new DelayCommand(args[0]);
+  case STOP:
+    return new DriveStopCommand(drive_sys);
+  }
+  return NULL;
+}
+
+static AutoScript script(script_verbs, script_keywords, make_command);
+static CommandController script_ctrl;
+static bool script_ok = false;
+static std::string script_status = "No script loaded";
+static pose_t script_end = {};
+
+/**
+ * Load an autonomous script from the SD card and build it (see auto_script.h for the format).
+ * Called at startup, so any errors are on the screen before the match.
+ * @param filename the script on the SD card
+ * @return true if the script loaded and built without errors
+ */
+bool load_script_auto(const char *filename)
+{
+  script_ctrl = CommandController();
+  script_ok = script.load(filename) && script.build(script_ctrl);
+
+  char buf[80];
+  if (script_ok)
+  {
+    // The script sets its own start position, so it doesn't matter where the estimate starts
+    double worst = 0;
+    double est = script_ctrl.estimate(OdometryBase::zero_pos, AUTO_BUDGET, &script_end, &worst);
+    snprintf(buf, sizeof(buf), "%s: %d lines (%s), est %.1fs (worst %.1fs)%s", filename, script.get_num_instructions(),
+             script.is_from_cache() ? "cached" : "parsed", est, worst, (est > AUTO_BUDGET) ? " OVER" : "");
+  }
+  else
+    snprintf(buf, sizeof(buf), "%s: %d errors", filename, (int)script.get_errors().size());
+  script_status = buf;
+
+  printf("%s\n", buf);
+  return script_ok;
+}
+
+/**
+ * @return true if a script was loaded without errors, and should be run instead of the built-in autonomous
+ */
+bool has_script_auto()
+{
+  return script_ok;
+}
+
+/**
+ * @return the route built from the script. Only run it once
+ */
+CommandController script_auto()
+{
+  return script_ctrl;
+}
+
+/**
+ * @return where the robot should end up after the script, from its estimate at load time
+ */
+pose_t script_auto_predicted_end()
+{
+  return script_end;
+}
+
+/**
+ * @return a one line status of the script: where it was loaded from, or that it failed
+ */
+std::string script_auto_status()
+{
+  return script_status;
+}
+
+/**
+ * @return every error from loading the script
+ */
+std::vector<std::string> script_auto_errors()
+{
+  return script.get_errors();
+}
@@ -1,5 +1,7 @@
 #include <map>
 #include "../include/robot-config.h"
+#include "../include/tuning.h"
+#include "../include/competition/script_auto.h"
 
 using namespace vex;
 
@@ -86,12 +88,47 @@ PID::pid_config_t turn_pid_cfg = {
     .i = 0.00001,
     .d = .00085,
     .deadband = 2.0,
-    .on_target_time = .2};
+    .on_target_time = .2,
+    .error_method = PID::ERROR_TYPE::LINEAR,
+    .d_filter_time = .04,
+    .deriv_method = PID::DERIV_TYPE::MEASUREMENT_DERIV};
 
 FeedForward::ff_config_t turn_ff_cfg =
     {
         .kS = 0.08};
 
+// Profiled turns. Velocity in deg/s, accel in deg/s^2
+// Estimated from the linear constants (kV * wheelbase/2 * pi/180) until tuned with tune_turn_sysid()
+FeedForward::ff_config_t turn_mprofile_ff_cfg = {
+    .kS = 0.08,
+    .kV = 0.00105,
+    .kA = 0.000145};
+
+// The profile's feedforward does the turning, so its PID only corrects the tracking error. It takes the derivative
+// of the error: turn_pid_cfg's derivative of the measurement brakes against the profile's whole speed
+PID::pid_config_t turn_mprofile_pid_cfg = {
+    .p = .03,
+    .i = 0,
+    .d = .0005,
+    .deadband = 2.0,
+    .on_target_time = .2,
+    .error_method = PID::ERROR_TYPE::LINEAR,
+    .d_filter_time = .04,
+    .deriv_method = PID::DERIV_TYPE::ERROR_DERIV};
+
+// Top speed is (1 - kS) / kV = 876 deg/s. At 500 deg/s and 2000 deg/s^2 the feedforward asks for
+// kS + 500*kV + 2000*kA = 0.9, which leaves 10% for the PID
+MotionController::m_profile_cfg_t turn_mprofile_cfg = {
+    .max_v = 500,
+    .accel = 2000,
+    .pid_cfg = turn_mprofile_pid_cfg,
+    .ff_cfg = turn_mprofile_ff_cfg};
+
+MotionController turn_mprofile(turn_mprofile_cfg);
+
+// The turn PID has no profile, so route estimates use a rate fit to its turns (see init)
+PIDFF turn_pidff(turn_pid_cfg, turn_ff_cfg);
+
 MotionController drive_fast_mprofile(drive_fast_mprofile_cfg), drive_slow_mprofile(drive_slow_mprofile_cfg), drive_super_fast_mprofile(drive_fast_mprofile_cfg);
 
 robot_specs_t config = {
@@ -103,7 +140,7 @@ robot_specs_t config = {
     .drive_correction_cutoff = 6,
 
     .drive_feedback = &drive_fast_mprofile,
-    .turn_feedback = new PIDFF(turn_pid_cfg, turn_ff_cfg),
+    .turn_feedback = &turn_pidff,
     .correction_pid = {
         .p = .012,
         .i = 0,
@@ -117,6 +154,31 @@ PID::pid_config_t flywheel_pid_cfg = {
     .p = .0000, // 5,
 };
 
+// State space control needs kA in flywheel_ff_cfg (tune_flywheel_sysid)
+VelocityStateSpace::ss_config_t flywheel_ss_cfg = {
+    .max_error = 50,    // rpm
+    .max_effort = 1,
+    .closed_loop_pole = 0,
+    .model_stdev = 20,  // rpm
+    .encoder_stdev = 0.02, // flywheel revolutions
+    .period_ms = 10};
+
+Flywheel::shot_config_t flywheel_shot_cfg = {
+    .drop_rpm = 250,
+    .current_spike = 0,  // amps, 0 = only look at the RPM drop
+    .recovered_rpm = 150, // same as THRESHOLD_RPM in auto
+    .boost = 0.3,
+    .max_boost_time = 0.3};
+
+// Flywheel RPM by distance to the goal (inches), for each position of the flap.
+// Empty until calibrate_rpm_table() saves real ones, which load_tuned_gains() loads at startup
+RPMTable flywheel_rpm_table;
+RPMTable flywheel_rpm_table_flap;
+
+// Where the high goals are on the field (inches)
+point_t red_goal_pos = {17, 127};
+point_t blue_goal_pos = {127, 17};
+
 // ======== SUBSYSTEMS ========
 
 // OdometryTank odometry_sys(left_enc, right_enc, config);
@@ -126,6 +188,7 @@ TankDrive drive_sys(left_motors, right_motors, config, &odometry_sys);
 
 Flywheel flywheel_sys(flywheel_motors, flywheel_ff_cfg, 18);
 // Flywheel flywheel_sys(flywheel_motors, flywheel_pid_cfg, flywheel_ff_cfg, 18);
+// Flywheel flywheel_sys(flywheel_motors, flywheel_ff_cfg, flywheel_ss_cfg, 18);
 vex::timer oneshot_tmr;
 vex::timer auto_tmr;
 
@@ -141,8 +204,21 @@ int num_roller_fallback = 3;
  */
 void vexcodeInit(void)
 {
-    StartScreen(Brain.Screen, {page_one, page_two, page_three, page_four, page_five, page_six}, 4);
+    StartScreen(Brain.Screen, {page_one, page_two, page_three, page_four, page_five, page_six, page_seven, page_eight}, 4);
 
     endgame_solenoid.set(false); // TODO figure out if false or true shoots
     imu.calibrate();
+
+    // Scale all motor voltages as if the battery were always at 12V
+    static Logger battery_log("battery_log.txt");
+    BatteryCompensation::start(Brain.Battery, 12.0, 0.5, 20, &battery_log);
+
+    load_tuned_gains();
+    // deg/s and deg/s^2 that match turn_pidff's 45 to 180 degree turns in test/sim within 0.1 s
+    turn_pidff.set_estimate_rate(480, 1200);
+
+    flywheel_sys.setShotDetection(flywheel_shot_cfg);
+    flywheel_sys.startTelemetry();
+
+    load_script_auto();
 }
\ No newline at end of file
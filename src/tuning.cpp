@@ -3,6 +3,7 @@
 #include "math.h"
 #include "core.h"
 #include "automation.h"
+#include "../core/include/utils/relay_autotuner.h"
 
 #define ENC_IN(enc) (enc.position(rev) * PI * config.odom_wheel_diam)
 #define ENC_DIFF_IN(left, right) (fabs(ENC_IN(left) - ENC_IN(right)) / 2.0)
@@ -30,6 +31,101 @@ void reset_avg_counter()
     stored_num = 0;
 }
 
+// Where the relay autotuner saves its results
+Serializer &tuned_gains()
+{
+    static Serializer serializer("tuned_gains.txt");
+    return serializer;
+}
+
+/**
+ * Copy just the gains from one PID config to another
+ */
+static void copy_gains(const PID::pid_config_t &from, PID::pid_config_t &to)
+{
+    to.p = from.p;
+    to.i = from.i;
+    to.d = from.d;
+}
+
+/**
+ * Put the gains in drive_pid_cfg, turn_pid_cfg or flywheel_pid_cfg into every controller that runs on them.
+ * The drive motion profiles were given copies of drive_pid_cfg, and their PIDs use those copies,
+ * so the gains have to be copied over for them to see it.
+ * @param name "drive", "turn" or "flywheel"
+ */
+static void apply_gains(const char *name)
+{
+    if (strcmp(name, "drive") == 0)
+    {
+        copy_gains(drive_pid_cfg, drive_fast_mprofile_cfg.pid_cfg);
+        copy_gains(drive_pid_cfg, drive_slow_mprofile_cfg.pid_cfg);
+        printf("drive gains %f %f %f -> drive_fast_mprofile, drive_super_fast_mprofile, drive_slow_mprofile\n", drive_pid_cfg.p, drive_pid_cfg.i, drive_pid_cfg.d);
+    }
+    else if (strcmp(name, "turn") == 0)
+    {
+        // turn_mprofile has its own gains (turn_mprofile_pid_cfg), since its PID only corrects the tracking error
+        printf("turn gains %f %f %f -> config.turn_feedback\n", turn_pid_cfg.p, turn_pid_cfg.i, turn_pid_cfg.d);
+    }
+    else if (strcmp(name, "flywheel") == 0)
+    {
+        // flywheel_sys is feedforward only. The gains are used once it's built with flywheel_pid_cfg
+        printf("flywheel gains %f %f %f -> flywheel_pid_cfg (not used by the feedforward only flywheel_sys)\n", flywheel_pid_cfg.p, flywheel_pid_cfg.i, flywheel_pid_cfg.d);
+    }
+    fflush(stdout);
+}
+
+/**
+ * Replace the hand tuned gains with any that were found by the relay autotuner,
+ * and the RPM tables with any that were calibrated
+ */
+void load_tuned_gains()
+{
+    if (flywheel_rpm_table.load(tuned_gains(), "rpm_table"))
+        printf("Loaded calibrated RPM table\n");
+    if (flywheel_rpm_table_flap.load(tuned_gains(), "rpm_table_flap"))
+        printf("Loaded calibrated RPM table (flap)\n");
+    if (RelayAutotuner::load(tuned_gains(), "drive", drive_pid_cfg))
+        apply_gains("drive");
+    if (RelayAutotuner::load(tuned_gains(), "turn", turn_pid_cfg))
+        apply_gains("turn");
+    if (RelayAutotuner::load(tuned_gains(), "flywheel", flywheel_pid_cfg))
+        apply_gains("flywheel");
+}
+
+/**
+ * Show the results of a relay test on the controller, and save them when it's done.
+ * Returns true once the test is over.
+ */
+static bool relay_tune_report(RelayAutotuner &tuner, const char *name, RelayAutotuner::TuningRule rule, PID::pid_config_t &cfg, bool &saved)
+{
+    if (!tuner.is_done())
+        return false;
+
+    if (!saved && tuner.has_result())
+    {
+        tuner.save(tuned_gains(), name, rule);
+        cfg = tuner.get_gains(rule, cfg);
+        printf("%s: Ku: %f Tu: %f -> p: %f i: %f d: %f\n", name, tuner.get_ultimate_gain(), tuner.get_ultimate_period(), cfg.p, cfg.i, cfg.d);
+        apply_gains(name);
+        saved = true;
+    }
+
+    main_controller.Screen.clearScreen();
+    main_controller.Screen.setCursor(1, 1);
+    if (tuner.has_result())
+    {
+        main_controller.Screen.print("Ku %.4f Tu %.3f", tuner.get_ultimate_gain(), tuner.get_ultimate_period());
+        main_controller.Screen.setCursor(2, 1);
+        main_controller.Screen.print("p%.4f i%.4f d%.4f", cfg.p, cfg.i, cfg.d);
+    }
+    else
+    {
+        main_controller.Screen.print("relay test failed");
+    }
+    return true;
+}
+
 // Odometry Tuning
 void tune_odometry_gear_ratio_right_wheel()
 {
@@ -346,6 +442,122 @@ void tune_drive_motion_accel(DriveType dt, double maxv)
     }
 }
 
+/**
+ * Find the drive or turn PID gains with a relay test, oscillating around where the robot was when A was pressed.
+ * Hold A to run.
+ */
+void tune_drive_relay(DriveType dt)
+{
+    static RelayAutotuner::relay_config_t drive_relay_cfg = {
+        .setpoint = 0,
+        .amplitude = 0.3,
+        .bias = 0,
+        .hysteresis = 0.25,
+        .cycles = 5,
+        .timeout = 20};
+    static RelayAutotuner::relay_config_t turn_relay_cfg = {
+        .setpoint = 0,
+        .amplitude = 0.4,
+        .bias = 0,
+        .hysteresis = 1.0,
+        .cycles = 5,
+        .timeout = 20};
+    static RelayAutotuner drive_tuner(drive_relay_cfg), turn_tuner(turn_relay_cfg);
+    static bool new_press = true;
+    static bool saved = false;
+    static pose_t start_pos;
+
+    RelayAutotuner &tuner = (dt == DRIVE) ? drive_tuner : turn_tuner;
+
+    if (main_controller.ButtonA.pressing())
+    {
+        if (new_press)
+        {
+            start_pos = odometry_sys.get_position();
+            tuner.init();
+            new_press = false;
+            saved = false;
+        }
+
+        if (relay_tune_report(tuner, (dt == DRIVE) ? "drive" : "turn", RelayAutotuner::NO_OVERSHOOT, (dt == DRIVE) ? drive_pid_cfg : turn_pid_cfg, saved))
+        {
+            drive_sys.stop();
+            return;
+        }
+
+        pose_t pos = odometry_sys.get_position();
+        if (dt == DRIVE)
+        {
+            // distance travelled along the starting heading
+            double dist = ((pos.x - start_pos.x) * cos(deg2rad(start_pos.rot))) + ((pos.y - start_pos.y) * sin(deg2rad(start_pos.rot)));
+            double out = tuner.update(dist);
+            drive_sys.drive_tank(out, out);
+        }
+        else
+        {
+            double out = tuner.update(OdometryBase::smallest_angle(start_pos.rot, pos.rot));
+            drive_sys.drive_tank(-out, out);
+        }
+    }
+    else
+    {
+        drive_sys.stop();
+        new_press = true;
+    }
+}
+
+/**
+ * Characterize the drivetrain (see MotionController::tune_feedforward). Press A to run - the robot will drive
+ * forwards and backwards about 4 feet, so give it room.
+ */
+void tune_drive_sysid()
+{
+    static bool new_press = true;
+    static FeedForward::ff_config_t result = {};
+
+    if (main_controller.ButtonA.pressing() && new_press)
+    {
+        new_press = false;
+        result = MotionController::tune_feedforward(drive_sys, odometry_sys, 0.6, 2);
+    }
+    else if (!main_controller.ButtonA.pressing())
+    {
+        new_press = true;
+    }
+
+    main_controller.Screen.clearScreen();
+    main_controller.Screen.setCursor(1, 1);
+    main_controller.Screen.print("kS %.3f kV %.4f", result.kS, result.kV);
+    main_controller.Screen.setCursor(2, 1);
+    main_controller.Screen.print("kA %.5f", result.kA);
+}
+
+/**
+ * Characterize the drivetrain while turning (see MotionController::tune_feedforward_angular). Press A to run -
+ * the robot will spin in place in both directions.
+ */
+void tune_turn_sysid()
+{
+    static bool new_press = true;
+    static FeedForward::ff_config_t result = {};
+
+    if (main_controller.ButtonA.pressing() && new_press)
+    {
+        new_press = false;
+        result = MotionController::tune_feedforward_angular(drive_sys, imu, 0.5, 2);
+    }
+    else if (!main_controller.ButtonA.pressing())
+    {
+        new_press = true;
+    }
+
+    main_controller.Screen.clearScreen();
+    main_controller.Screen.setCursor(1, 1);
+    main_controller.Screen.print("kS %.3f kV %.5f", result.kS, result.kV);
+    main_controller.Screen.setCursor(2, 1);
+    main_controller.Screen.print("kA %.6f", result.kA);
+}
+
 // Flywheel Tuning
 //.5 .000340
 //.75 .000316
@@ -438,6 +650,138 @@ void tune_flywheel_pid()
     }
 }
 
+/**
+ * Find the flywheel PID gains with a relay test around 2500 RPM. Hold A to run.
+ * The relay switches +/-10% around the feedforward output, so the flywheel stays near the setpoint the whole time.
+ */
+void tune_flywheel_relay()
+{
+    static RelayAutotuner::relay_config_t relay_cfg = {
+        .setpoint = 2500,
+        .amplitude = 0.1,
+        .bias = 2500 * flywheel_ff_cfg.kV,
+        .hysteresis = 20,
+        .cycles = 5,
+        .timeout = 30};
+    static RelayAutotuner tuner(relay_cfg);
+    static bool new_press = true;
+    static bool saved = false;
+
+    if (main_controller.ButtonA.pressing())
+    {
+        if (new_press)
+        {
+            tuner.init();
+            new_press = false;
+            saved = false;
+        }
+
+        if (relay_tune_report(tuner, "flywheel", RelayAutotuner::ZIEGLER_NICHOLS_PI, flywheel_pid_cfg, saved))
+        {
+            flywheel_sys.stop();
+            return;
+        }
+
+        flywheel_sys.spin_raw(tuner.update(flywheel_sys.measureRPM()));
+    }
+    else
+    {
+        flywheel_sys.stop();
+        new_press = true;
+    }
+}
+
+/**
+ * Characterize the flywheel (see SysId). Press A to run
+ */
+void tune_flywheel_sysid()
+{
+    static bool new_press = true;
+    static SysId::sysid_result_t result = {};
+
+    if (main_controller.ButtonA.pressing() && new_press)
+    {
+        new_press = false;
+
+        SysId::sysid_cfg_t cfg = {
+            .ramp_rate = 0.1,
+            .step_pct = 0.8,
+            .quasistatic_time = 8,
+            .dynamic_time = 3,
+            .period_ms = 10,
+            .fit_kg = false};
+
+        SysId sysid(
+            [](double output){ flywheel_sys.spin_raw(output); },
+            [](){ return flywheel_sys.measureRPM(); },
+            cfg, 2500);
+
+        // The flywheel takes a while to spin down between tests
+        result = sysid.run(5.0);
+        flywheel_sys.stop();
+    }
+    else if (!main_controller.ButtonA.pressing())
+    {
+        new_press = true;
+    }
+
+    main_controller.Screen.clearScreen();
+    main_controller.Screen.setCursor(1, 1);
+    main_controller.Screen.print("kS %.3f kV %.6f", result.ff.kS, result.ff.kV);
+    main_controller.Screen.setCursor(2, 1);
+    main_controller.Screen.print("kA %.6f", result.ff.kA);
+    main_controller.Screen.setCursor(3, 1);
+    main_controller.Screen.print("R2 %.4f", result.r_squared);
+}
+
+/**
+ * Calibrate the RPM tables by shooting from different distances. Drive around and shoot as usual, and after each
+ * shot tell it how it went. Shots are recorded into the table for whichever position the flap is in.
+ * Up/Down: +/-250 RPM, Right/Left: +/-50 RPM, L1: toggle flap, R2: feed discs
+ * A: hit, B: short, X: long, Y: fit the tables to the shots and save them
+ */
+void calibrate_rpm_table()
+{
+    static bool first_run = true;
+    static std::atomic<int> setpt_rpm(2700);
+
+    if (first_run)
+    {
+        first_run = false;
+
+        main_controller.ButtonUp.pressed([]() { setpt_rpm = setpt_rpm + 250; });
+        main_controller.ButtonDown.pressed([]() { setpt_rpm = setpt_rpm - 250; });
+        main_controller.ButtonRight.pressed([]() { setpt_rpm = setpt_rpm + 50; });
+        main_controller.ButtonLeft.pressed([]() { setpt_rpm = setpt_rpm - 50; });
+
+        main_controller.ButtonL1.pressed([]() { flapup_solenoid.set(!flapup_solenoid.value()); });
+        main_controller.ButtonR2.pressed([]() { intake.spin(fwd, 9.5, volt); });
+        main_controller.ButtonR2.released([]() { intake.stop(); });
+
+        main_controller.ButtonA.pressed([]() { current_rpm_table().record_shot(goal_distance(), setpt_rpm, RPMTable::HIT); });
+        main_controller.ButtonB.pressed([]() { current_rpm_table().record_shot(goal_distance(), setpt_rpm, RPMTable::SHORT); });
+        main_controller.ButtonX.pressed([]() { current_rpm_table().record_shot(goal_distance(), setpt_rpm, RPMTable::LONG); });
+
+        main_controller.ButtonY.pressed([]() {
+            if (flywheel_rpm_table.fit())
+                flywheel_rpm_table.save(tuned_gains(), "rpm_table");
+            if (flywheel_rpm_table_flap.fit())
+                flywheel_rpm_table_flap.save(tuned_gains(), "rpm_table_flap");
+        });
+    }
+
+    drive_sys.drive_tank(main_controller.Axis3.position() / 100.0, main_controller.Axis2.position() / 100.0);
+    flywheel_sys.spinRPM(setpt_rpm);
+
+    main_controller.Screen.clearScreen();
+    main_controller.Screen.setCursor(1, 1);
+    main_controller.Screen.print("rpm %d table %.0f", (int)setpt_rpm, current_rpm_table().get_rpm(goal_distance()));
+    main_controller.Screen.setCursor(2, 1);
+    main_controller.Screen.print("dist %.1f flap %d", goal_distance(), (int)flapup_solenoid.value());
+    main_controller.Screen.setCursor(3, 1);
+    main_controller.Screen.print("shots %d", current_rpm_table().get_num_shots());
+}
+
 void tune_flywheel_distcalc()
 {
     static bool first_run = true;
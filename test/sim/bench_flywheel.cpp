@@ -0,0 +1,113 @@
+/**
+ * File: bench_flywheel.cpp
+ * Desc:
+ *    CPU time of one control tick: Flywheel, which picks its control scheme at runtime, against PolicyFlywheel
+ *    with the same scheme picked at compile time. Each pair runs the same controller and filter math.
+ *
+ *    Times are from this computer, not the V5 brain, so only compare them with each other. Both ticks include
+ *    ControlLoop's own timing, which is on the "tick overhead" line.
+ */
+#include <chrono>
+#include "core.h"
+#include "plants.h"
+#include "sim.h"
+
+using namespace vex;
+
+#define TICKS 200000
+#define REPEATS 20
+
+plant_model_t flywheel_model = {
+    .kS = 0.02,
+    .kV = 0.0003,
+    .kA = 0.00015};
+
+FeedForward::ff_config_t fw_ff_cfg = {
+    .kS = flywheel_model.kS,
+    .kV = flywheel_model.kV,
+    .kA = flywheel_model.kA};
+PID::pid_config_t fw_pid_cfg = {
+    .p = .001};
+VelocityStateSpace::ss_config_t fw_ss_cfg = {
+    .max_error = 50,
+    .max_effort = 1,
+    .closed_loop_pole = 0,
+    .model_stdev = 20,
+    .encoder_stdev = 0.02,
+    .period_ms = 10};
+
+// The same schemes as policies. Flywheel averages 2 readings at 10ms
+PIDFFControl::config_t policy_pidff_cfg = {.pid = fw_pid_cfg, .ff = fw_ff_cfg};
+MovingAverageFilter::config_t policy_avg_cfg = {.window_size = 2};
+StateSpaceControl::config_t policy_ss_cfg = {.ff = fw_ff_cfg, .ss = fw_ss_cfg};
+KalmanFilter::config_t policy_kalman_cfg = {.accel_stdev = fw_ss_cfg.model_stdev, .encoder_stdev = fw_ss_cfg.encoder_stdev};
+TBHControl::config_t policy_tbh_cfg = {.gain = .00001};
+
+motor m1(PORT1), m2(PORT2), m3(PORT3), m4(PORT4), m5(PORT5), m6(PORT6);
+motor_group g1(m1), g2(m2), g3(m3), g4(m4), g5(m5), g6(m6);
+
+Flywheel pidff_flywheel(g1, fw_pid_cfg, fw_ff_cfg, 18);
+PolicyFlywheel<PIDFFControl, MovingAverageFilter> pidff_policy(g2, policy_pidff_cfg, policy_avg_cfg, 18);
+Flywheel ss_flywheel(g3, fw_ff_cfg, fw_ss_cfg, 18);
+PolicyFlywheel<StateSpaceControl, KalmanFilter> ss_policy(g4, policy_ss_cfg, policy_kalman_cfg, 18);
+Flywheel tbh_flywheel(g5, .00001, 18);
+PolicyFlywheel<TBHControl, MovingAverageFilter> tbh_policy(g6, policy_tbh_cfg, policy_avg_cfg, 18);
+
+/**
+ * @return the fastest of REPEATS runs of TICKS calls to tick, in nanoseconds per call
+ */
+template <typename Tick>
+static double time_ticks(Tick tick)
+{
+  double best = 1e9;
+  for (int r = 0; r < REPEATS; r++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TICKS; i++)
+      tick();
+    auto end = std::chrono::steady_clock::now();
+    best = fmin(best, std::chrono::duration<double, std::nano>(end - start).count() / TICKS);
+  }
+  return best;
+}
+
+template <typename Runtime, typename Policy>
+static void compare(const char *name, Runtime runtime, Policy policy)
+{
+  double t_runtime = time_ticks(runtime);
+  double t_policy = time_ticks(policy);
+  printf("%-14s %12.1f %16.1f %10.2f\n", name, t_runtime, t_policy, t_runtime / t_policy);
+}
+
+int main()
+{
+  motor_group *groups[] = {&g1, &g2, &g3, &g4, &g5, &g6};
+  std::vector<FlywheelPlant *> plants;
+  for (motor_group *g : groups)
+  {
+    plants.push_back(new FlywheelPlant(*g, flywheel_model, 18, 20));
+    plants.back()->attach();
+  }
+
+  // Spin everything up first, so the controllers are working on real readings
+  pidff_flywheel.spinRPM(3000);
+  pidff_policy.spinRPM(3000);
+  ss_flywheel.spinRPM(3000);
+  ss_policy.spinRPM(3000);
+  tbh_flywheel.spinRPM(3000);
+  tbh_policy.spinRPM(3000);
+  vexDelay(3000);
+
+  // Simulated time stands still from here: only the ticks are timed, the tasks don't run
+  ControlLoop::tick_stats_t overhead_stats = {};
+  double overhead = time_ticks([&]() { ControlLoop::end_tick(overhead_stats, ControlLoop::start_tick(), 10); });
+
+  printf("Nanoseconds per tick, fastest of %d runs of %d ticks\n", REPEATS, TICKS);
+  printf("%-14s %12s %16s %10s\n", "scheme", "Flywheel", "PolicyFlywheel", "ratio");
+  compare("PID+FF", [&]() { pidff_flywheel.controlTick(); }, [&]() { pidff_policy.controlTick(); });
+  compare("State space", [&]() { ss_flywheel.controlTick(); }, [&]() { ss_policy.controlTick(); });
+  compare("TBH", [&]() { tbh_flywheel.controlTick(); }, [&]() { tbh_policy.controlTick(); });
+  printf("%-14s %12.1f\n", "tick overhead", overhead);
+
+  sim::finish();
+}
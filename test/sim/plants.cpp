@@ -0,0 +1,256 @@
+/**
+ * File: plants.cpp
+ * Desc:
+ *    Simulated mechanisms for the host simulation. See plants.h
+ */
+#include <math.h>
+#include "plants.h"
+#include "sim.h"
+
+#ifndef PI
+#define PI 3.141592654
+#endif
+
+// Coasting motors have no back EMF slowing them down, only the bearings. This is how much of kV is left
+#define COAST_DRAG 0.1
+
+// Stall current of a motor at full output (amps)
+#define STALL_AMPS 2.5
+
+// The intake (see plants.h)
+#define MAX_DISCS 3
+#define FEED_PER_DISC 0.65  // volt-seconds
+#define PICKUP_PER_DISC 6.0 // volt-seconds
+
+// The roller (see plants.h)
+#define PUSH_MIN 0.05
+#define PUSH_MAX 0.3
+#define PUSH_TIME 0.5 // seconds
+
+static int sign(double x)
+{
+  return (x > 0) - (x < 0);
+}
+
+/**
+ * @return the average output of a motor group, -1.0 -> 1.0
+ */
+static double group_output(vex::motor_group &motors)
+{
+  double total = 0;
+  for (vex::motor *m : motors.motors)
+    total += m->sim_volts / 12.0;
+  return total / motors.motors.size();
+}
+
+/**
+ * @return true if every motor in the group is stopped and set to coast
+ */
+static bool group_coasting(vex::motor_group &motors)
+{
+  for (vex::motor *m : motors.motors)
+    if (!m->sim_stopped || m->sim_stopping != vex::coast)
+      return false;
+  return true;
+}
+
+/**
+ * Advance the velocity
+ * @param u the output, -1.0 -> 1.0
+ * @param coasting true if the motors are stopped and coasting: no output, and no back EMF to slow them
+ * @param dt seconds
+ * @param friction how much of kS acts while moving, 0.0 -> 1.0. Starting from a stop always takes all of it
+ * @return the new velocity
+ */
+double VelocityPlant::step(double u, bool coasting, double dt, double friction)
+{
+  double kv = coasting ? model.kV * COAST_DRAG : model.kV;
+  if (coasting)
+    u = 0;
+
+  double v = velocity;
+  double accel;
+  if (v == 0)
+  {
+    // Static friction holds it until the output beats kS
+    if (fabs(u) <= model.kS)
+      return velocity;
+    accel = (u - (model.kS * (u > 0 ? 1 : -1))) / model.kA;
+  }
+  else
+    accel = (u - (friction * model.kS * (v > 0 ? 1 : -1)) - (kv * v)) / model.kA;
+
+  double next = v + (accel * dt);
+
+  // Friction can stop it, but can't push it backwards
+  if (v != 0 && (next > 0) != (v > 0) && fabs(u) <= friction * model.kS)
+    next = 0;
+
+  velocity = next;
+  return velocity;
+}
+
+FlywheelPlant::FlywheelPlant(vex::motor_group &motors, plant_model_t model, double ratio, double noise_rpm, unsigned seed)
+    : motors(motors), wheel(model), ratio(ratio), rng(seed), noise(0, noise_rpm > 0 ? noise_rpm : 1e-9)
+{
+}
+
+void FlywheelPlant::attach()
+{
+  sim::add_plant([this](double dt) { step(dt); });
+}
+
+void FlywheelPlant::shoot(double drop)
+{
+  wheel.velocity *= (1.0 - drop);
+}
+
+double FlywheelPlant::true_rpm()
+{
+  return wheel.velocity;
+}
+
+void FlywheelPlant::step(double dt)
+{
+  double u = group_output(motors);
+  double rpm = wheel.step(u, group_coasting(motors), dt);
+  position += rpm / 60.0 * dt;
+
+  double amps = STALL_AMPS * fmax(0, fabs(u) - (wheel.model.kV * fabs(rpm)));
+  double measured = rpm + noise(rng);
+  for (vex::motor *m : motors.motors)
+  {
+    m->sim_position = position / ratio;
+    m->sim_velocity = measured / ratio;
+    m->sim_current = amps / motors.motors.size();
+  }
+}
+
+IntakePlant::IntakePlant(vex::motor &motor, FlywheelPlant &flywheel, double drop, int discs)
+    : discs(discs), motor(motor), flywheel(flywheel), drop(drop)
+{
+}
+
+void IntakePlant::attach()
+{
+  sim::add_plant([this](double dt) { step(dt); });
+}
+
+void IntakePlant::step(double dt)
+{
+  double volts = motor.sim_volts;
+  if (volts > 0)
+  {
+    picked = 0;
+    fed += volts * dt;
+    if (fed >= FEED_PER_DISC)
+    {
+      fed -= FEED_PER_DISC;
+      if (discs > 0)
+      {
+        discs--;
+        shots++;
+        flywheel.shoot(drop);
+      }
+    }
+  }
+  else if (volts < 0)
+  {
+    // Intaking pulls the discs back from the flywheel
+    fed = 0;
+    picked -= volts * dt;
+    if (picked >= PICKUP_PER_DISC)
+    {
+      picked -= PICKUP_PER_DISC;
+      if (discs < MAX_DISCS)
+        discs++;
+    }
+  }
+}
+
+RollerPlant::RollerPlant(vex::motor_group &left, vex::motor_group &right, vex::optical &sensor, double red_hue,
+                         double blue_hue, bool red)
+    : red(red), left(left), right(right), sensor(sensor), red_hue(red_hue), blue_hue(blue_hue)
+{
+}
+
+void RollerPlant::attach()
+{
+  sim::add_plant([this](double dt) { step(dt); });
+}
+
+void RollerPlant::step(double dt)
+{
+  double u_left = group_output(left), u_right = group_output(right);
+  bool pushing = u_left >= PUSH_MIN && u_left <= PUSH_MAX && u_right >= PUSH_MIN && u_right <= PUSH_MAX;
+
+  pushed = pushing ? pushed + dt : 0;
+  if (pushed >= PUSH_TIME)
+  {
+    red = !red;
+    pushed = 0;
+  }
+  sensor.sim_hue = red ? red_hue : blue_hue;
+}
+
+TankDrivePlant::TankDrivePlant(vex::motor_group &left, vex::motor_group &right, vex::inertial &imu,
+                               plant_model_t linear, plant_model_t angular, double track_width, double wheel_diam)
+    : left(left), right(right), imu(imu), linear(linear), angular(angular), track_width(track_width), wheel_diam(wheel_diam)
+{
+}
+
+void TankDrivePlant::attach()
+{
+  sim::add_plant([this](double dt) { step(dt); });
+}
+
+void TankDrivePlant::place(double x, double y, double heading)
+{
+  this->x = x;
+  this->y = y;
+  this->heading = heading;
+  linear.velocity = 0;
+  angular.velocity = 0;
+}
+
+void TankDrivePlant::step(double dt)
+{
+  double u_left = group_output(left), u_right = group_output(right);
+  bool coasting = group_coasting(left) && group_coasting(right);
+
+  // Each side's friction is against the way it's rolling (see plants.h). Stopped, both start from a stop
+  double turn_speed = angular.velocity * PI / 180.0 * track_width / 2.0;
+  int left_dir = sign(linear.velocity - turn_speed), right_dir = sign(linear.velocity + turn_speed);
+  double linear_friction = abs(left_dir + right_dir) / 2.0;
+  double angular_friction = abs(right_dir - left_dir) / 2.0;
+
+  double v = linear.step((u_left + u_right) / 2.0, coasting, dt, linear_friction);
+  double w = angular.step((u_right - u_left) / 2.0, coasting, dt, angular_friction);
+
+  heading += w * dt;
+  x += v * cos(heading * PI / 180.0) * dt;
+  y += v * sin(heading * PI / 180.0) * dt;
+  distance += fabs(v) * dt;
+
+  // Each side's speed: forward speed, plus or minus the turn
+  turn_speed = w * PI / 180.0 * track_width / 2.0;
+  double v_left = v - turn_speed, v_right = v + turn_speed;
+  double inches_per_rev = PI * wheel_diam;
+  left_pos += v_left / inches_per_rev * dt;
+  right_pos += v_right / inches_per_rev * dt;
+
+  for (vex::motor *m : left.motors)
+  {
+    m->sim_position = left_pos;
+    m->sim_velocity = v_left / inches_per_rev * 60.0;
+  }
+  for (vex::motor *m : right.motors)
+  {
+    m->sim_position = right_pos;
+    m->sim_velocity = v_right / inches_per_rev * 60.0;
+  }
+
+  // The inertial sensor counts clockwise
+  imu.sim_rotation -= w * dt;
+  imu.sim_rate = -w;
+}
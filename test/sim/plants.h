@@ -0,0 +1,215 @@
+/**
+ * File: plants.h
+ * Desc:
+ *    Simulated mechanisms for the host simulation. Each is a first order model in the same form the library's
+ *    feedforward uses, so a tuning routine's result can be checked against the constants the plant really has:
+ *
+ *      kA * dv/dt = u - kS*sgn(v) - kV*v      u is the motor output, -1.0 -> 1.0 (volts / 12)
+ *
+ *    Call attach() once the plant is set up, to have it stepped every simulated millisecond (see sim.h).
+ */
+#pragma once
+
+#include <random>
+#include "vex.h"
+
+/**
+ * The constants of a simulated mechanism, in percent output per unit of its velocity
+ */
+struct plant_model_t
+{
+  double kS; ///< output needed to start moving
+  double kV; ///< output per unit of velocity
+  double kA; ///< output per unit of acceleration
+};
+
+/**
+ * One first order velocity, with static friction
+ */
+class VelocityPlant
+{
+public:
+  VelocityPlant(plant_model_t model) : model(model) {}
+
+  /**
+   * Advance the velocity
+   * @param u the output, -1.0 -> 1.0
+   * @param coasting true if the motors are stopped and coasting: no output, and no back EMF to slow them
+   * @param dt seconds
+   * @param friction how much of kS acts while moving, 0.0 -> 1.0. Starting from a stop always takes all of it
+   * @return the new velocity
+   */
+  double step(double u, bool coasting, double dt, double friction = 1.0);
+
+  plant_model_t model;
+  double velocity = 0;
+};
+
+/**
+ * A flywheel on a motor group, spinning ratio times as fast as the motors
+ */
+class FlywheelPlant
+{
+public:
+  /**
+   * @param motors       the flywheel's motors
+   * @param model        the flywheel's constants, per flywheel RPM
+   * @param ratio        flywheel RPM per motor RPM
+   * @param noise_rpm    standard deviation of the motors' velocity reading, in flywheel RPM
+   * @param seed         seed for the noise, so runs repeat
+   */
+  FlywheelPlant(vex::motor_group &motors, plant_model_t model, double ratio, double noise_rpm, unsigned seed = 1);
+
+  /**
+   * Step the plant every simulated millisecond
+   */
+  void attach();
+
+  /**
+   * A disc goes through: the flywheel loses a fraction of its speed at once
+   * @param drop how much speed it loses, 0.0 -> 1.0
+   */
+  void shoot(double drop);
+
+  /**
+   * @return the flywheel's real speed, without the sensor noise
+   */
+  double true_rpm();
+
+private:
+  void step(double dt);
+
+  vex::motor_group &motors;
+  VelocityPlant wheel;
+  double ratio;
+  double position = 0; // flywheel revolutions
+  std::mt19937 rng;
+  std::normal_distribution<double> noise;
+};
+
+/**
+ * The intake, and the discs in the robot. Spinning forward feeds the discs into the flywheel, one for every
+ * 0.65 volt-seconds of feeding: a single shot (6 V for 0.2 s) feeds one, a tri shot (2 V for 1 s) feeds three.
+ * There are no discs on the simulated field, so spinning in reverse picks one up every half second at 12 V, up to
+ * three, as if the route had driven over them.
+ */
+class IntakePlant
+{
+public:
+  /**
+   * @param motor     the intake motor
+   * @param flywheel  the flywheel the discs are fed into
+   * @param drop      how much of its speed the flywheel loses to each disc, 0.0 -> 1.0
+   * @param discs     how many discs the robot starts with
+   */
+  IntakePlant(vex::motor &motor, FlywheelPlant &flywheel, double drop, int discs);
+
+  /**
+   * Step the plant every simulated millisecond
+   */
+  void attach();
+
+  int discs;     ///< discs in the robot
+  int shots = 0; ///< discs fed into the flywheel
+
+private:
+  void step(double dt);
+
+  vex::motor &motor;
+  FlywheelPlant &flywheel;
+  double drop;
+  double fed = 0;    // volt-seconds fed toward the flywheel since the last disc went in
+  double picked = 0; // volt-seconds of intaking since the last disc was picked up
+};
+
+/**
+ * The roller on the field, in front of the optical sensor. There are no field walls, so the robot turns the roller
+ * whenever it pushes forward gently (both sides between 5% and 30% output), the way SpinRollerCommand presses into
+ * it. Half a second of pushing turns it to the other color.
+ */
+class RollerPlant
+{
+public:
+  /**
+   * @param left, right  the drive motors
+   * @param sensor       the optical sensor, given the hue of the color facing it
+   * @param red_hue      the hue the sensor reads for red
+   * @param blue_hue     the hue the sensor reads for blue
+   * @param red          true if the roller starts with red facing the sensor
+   */
+  RollerPlant(vex::motor_group &left, vex::motor_group &right, vex::optical &sensor, double red_hue, double blue_hue,
+              bool red);
+
+  /**
+   * Step the plant every simulated millisecond
+   */
+  void attach();
+
+  bool red; ///< true if red is facing the sensor
+
+private:
+  void step(double dt);
+
+  vex::motor_group &left, &right;
+  vex::optical &sensor;
+  double red_hue, blue_hue;
+  double pushed = 0; // seconds the robot has been pushing without stopping
+};
+
+/**
+ * A tank drive on two motor groups with an inertial sensor. Its forward speed and its turning speed are two
+ * separate first order plants: the output common to both sides drives one, the difference drives the other.
+ *
+ * Friction acts on each side's wheels, against the way that side is rolling. Turning in place, the sides roll
+ * opposite ways, so all of the friction resists the turn and none the forward speed. Driving forward, both roll
+ * forward, so a small turn meets no friction: steering while driving doesn't have to overcome the turning kS.
+ */
+class TankDrivePlant
+{
+public:
+  /**
+   * @param left, right  the drive motors
+   * @param imu          the inertial sensor, given the heading and turn rate
+   * @param linear       constants for driving straight, per inch/second
+   * @param angular      constants for turning in place, per degree/second
+   * @param track_width  distance between the left and right wheels (inches)
+   * @param wheel_diam   inches of travel per motor revolution, divided by pi
+   */
+  TankDrivePlant(vex::motor_group &left, vex::motor_group &right, vex::inertial &imu, plant_model_t linear,
+                 plant_model_t angular, double track_width, double wheel_diam);
+
+  /**
+   * Step the plant every simulated millisecond
+   */
+  void attach();
+
+  /**
+   * Put the robot somewhere, stopped. The sensors keep counting from where they are
+   * @param x, y     inches
+   * @param heading  degrees, counterclockwise from the x axis
+   */
+  void place(double x, double y, double heading);
+
+  double x = 0, y = 0;   ///< where the robot really is (inches)
+  double heading = 90;   ///< where the robot is really pointing (degrees, counterclockwise from the x axis)
+  double distance = 0;   ///< how far the center of the robot has travelled (inches)
+
+  /**
+   * @return the robot's forward speed (inches/second)
+   */
+  double speed() { return linear.velocity; }
+
+  /**
+   * @return the robot's turn rate (degrees/second, counterclockwise)
+   */
+  double turn_rate() { return angular.velocity; }
+
+private:
+  void step(double dt);
+
+  vex::motor_group &left, &right;
+  vex::inertial &imu;
+  VelocityPlant linear, angular;
+  double track_width, wheel_diam;
+  double left_pos = 0, right_pos = 0; // motor revolutions
+};
@@ -0,0 +1,206 @@
+/**
+ * File: robot.cpp
+ * Desc:
+ *    The simulated robot. The devices, gains and robot_specs_t below are copied from src/robot-config.cpp, so keep
+ *    them in step with it. The drive's plant constants are the feedforward constants from the same file: the
+ *    simulated robot is exactly the robot the feedforward was tuned for, so the programs compare controllers, not
+ *    tuning. The flywheel is the one in sim_flywheel.
+ *
+ *    robot-config.h is included so the definitions are checked against what the route files expect.
+ */
+#include "robot-config.h"
+#include "robot.h"
+#include "sim.h"
+
+using namespace vex;
+
+brain Brain;
+controller main_controller;
+
+// ======== OUTPUTS ========
+
+motor left_front(PORT13, vex::gearSetting::ratio18_1, true), left_mid(PORT12, vex::gearSetting::ratio18_1, true), left_rear(PORT11, vex::gearSetting::ratio18_1, true);
+motor right_front(PORT18, vex::gearSetting::ratio18_1), right_mid(PORT19, vex::gearSetting::ratio18_1), right_rear(PORT20, vex::gearSetting::ratio18_1);
+
+motor_group left_motors(left_front, left_mid, left_rear);
+motor_group right_motors(right_front, right_mid, right_rear);
+
+inertial imu(PORT2);
+
+motor flywheel(PORT10);
+motor intake(PORT1);
+
+motor_group flywheel_motors(flywheel);
+
+vex::digital_out endgame_solenoid(Brain.ThreeWirePort.A);
+vex::digital_out flapup_solenoid(Brain.ThreeWirePort.C);
+vex::digital_out intake_solenoid(Brain.ThreeWirePort.B);
+
+optical roller_sensor(PORT17);
+
+// ======== UTILS ========
+// Drive Tuning
+PID::pid_config_t drive_pid_cfg = {
+    .p = .035,
+    .i = 0,
+    .d = 0,
+    .deadband = 2,
+    .on_target_time = 0.2};
+
+FeedForward::ff_config_t drive_ff_cfg = {
+    .kS = 0.07,
+    .kV = .011,
+    .kA = 0.0015};
+
+MotionController::m_profile_cfg_t drive_fast_mprofile_cfg = {
+    .max_v = 60,
+    .accel = 140,
+    .pid_cfg = drive_pid_cfg,
+    .ff_cfg = drive_ff_cfg};
+
+MotionController::m_profile_cfg_t drive_slow_mprofile_cfg = {
+    .max_v = 15,
+    .accel = 100,
+    .pid_cfg = drive_pid_cfg,
+    .ff_cfg = drive_ff_cfg};
+
+// Turn Tuning
+PID::pid_config_t turn_pid_cfg = {
+    .p = .013,
+    .i = 0.00001,
+    .d = .00085,
+    .deadband = 2.0,
+    .on_target_time = .2,
+    .error_method = PID::ERROR_TYPE::LINEAR,
+    .d_filter_time = .04,
+    .deriv_method = PID::DERIV_TYPE::MEASUREMENT_DERIV};
+
+FeedForward::ff_config_t turn_ff_cfg = {
+    .kS = 0.08};
+
+FeedForward::ff_config_t turn_mprofile_ff_cfg = {
+    .kS = 0.08,
+    .kV = 0.00105,
+    .kA = 0.000145};
+
+PID::pid_config_t turn_mprofile_pid_cfg = {
+    .p = .03,
+    .i = 0,
+    .d = .0005,
+    .deadband = 2.0,
+    .on_target_time = .2,
+    .error_method = PID::ERROR_TYPE::LINEAR,
+    .d_filter_time = .04,
+    .deriv_method = PID::DERIV_TYPE::ERROR_DERIV};
+
+MotionController::m_profile_cfg_t turn_mprofile_cfg = {
+    .max_v = 500,
+    .accel = 2000,
+    .pid_cfg = turn_mprofile_pid_cfg,
+    .ff_cfg = turn_mprofile_ff_cfg};
+
+MotionController turn_mprofile(turn_mprofile_cfg);
+
+PIDFF turn_pidff(turn_pid_cfg, turn_ff_cfg);
+
+MotionController drive_fast_mprofile(drive_fast_mprofile_cfg), drive_slow_mprofile(drive_slow_mprofile_cfg);
+
+robot_specs_t config = {
+    .robot_radius = 10,
+    .odom_wheel_diam = 6.424194,
+    .odom_gear_ratio = 1,
+    .dist_between_wheels = 10.99,
+
+    .drive_correction_cutoff = 6,
+
+    .drive_feedback = &drive_fast_mprofile,
+    .turn_feedback = &turn_pidff,
+    .correction_pid = {
+        .p = .012,
+        .i = 0,
+        .d = 0.0012}};
+
+// Flywheel Tuning
+FeedForward::ff_config_t flywheel_ff_cfg = {
+    .kV = 0.0003};
+
+Flywheel::shot_config_t flywheel_shot_cfg = {
+    .drop_rpm = 250,
+    .current_spike = 0,
+    .recovered_rpm = 150,
+    .boost = 0.3,
+    .max_boost_time = 0.3};
+
+RPMTable flywheel_rpm_table;
+RPMTable flywheel_rpm_table_flap;
+
+point_t red_goal_pos = {17, 127};
+point_t blue_goal_pos = {127, 17};
+
+// ======== SUBSYSTEMS ========
+
+OdometryTank odometry_sys(left_motors, right_motors, config, &imu);
+
+TankDrive drive_sys(left_motors, right_motors, config, &odometry_sys);
+
+Flywheel flywheel_sys(flywheel_motors, flywheel_ff_cfg, 18);
+vex::timer oneshot_tmr;
+vex::timer auto_tmr;
+
+bool target_red = true;
+bool vision_enabled = true;
+int num_roller_fallback = 3;
+
+// ======== SIMULATION ========
+
+// Driving straight, per inch/second. Top speed is (1 - kS) / kV = 85 in/s
+plant_model_t drive_linear_model = {
+    .kS = drive_ff_cfg.kS,
+    .kV = drive_ff_cfg.kV,
+    .kA = drive_ff_cfg.kA};
+
+// Turning in place, per degree/second
+plant_model_t drive_angular_model = {
+    .kS = turn_mprofile_ff_cfg.kS,
+    .kV = turn_mprofile_ff_cfg.kV,
+    .kA = turn_mprofile_ff_cfg.kA};
+
+TankDrivePlant drive_plant(left_motors, right_motors, imu, drive_linear_model, drive_angular_model,
+                           config.dist_between_wheels, config.odom_wheel_diam);
+
+// Per flywheel RPM. The configured feedforward has no kS, so it holds a little under its target
+plant_model_t flywheel_model = {
+    .kS = 0.02,
+    .kV = 0.0003,
+    .kA = 0.00015};
+
+FlywheelPlant flywheel_plant(flywheel_motors, flywheel_model, 18, 20);
+
+// Two preloads. Each disc takes 10% of the flywheel's speed
+IntakePlant intake_plant(intake, flywheel_plant, 0.10, 2);
+
+// The hues get_roller_scored() (src/automation.cpp) tells apart. The roller starts on blue, so a red robot has to
+// turn it
+RollerPlant roller_plant(left_motors, right_motors, roller_sensor, 44, 27, false);
+
+void sim_robot_init()
+{
+  drive_plant.attach();
+  flywheel_plant.attach();
+  intake_plant.attach();
+  roller_plant.attach();
+  turn_pidff.set_estimate_rate(480, 1200);
+  flywheel_sys.setShotDetection(flywheel_shot_cfg);
+}
+
+double sim_run_until(std::function<bool(void)> step, double timeout_sec)
+{
+  uint32_t start = sim::now_ms();
+  while (!step())
+  {
+    if (sim::now_ms() - start > timeout_sec * 1000)
+      return -1;
+    vexDelay(10);
+  }
+  return (sim::now_ms() - start) / 1000.0;
+}
@@ -0,0 +1,58 @@
+/**
+ * File: robot.h
+ * Desc:
+ *    The simulated robot: the devices, tuning and subsystems from src/robot-config.cpp, on simulated mechanisms
+ *    (plants.h). It defines everything the robot's routes use from robot-config.h, so the route files in src/
+ *    link against it unchanged.
+ */
+#pragma once
+
+#include "core.h"
+#include "plants.h"
+
+// ======== OUTPUTS ========
+extern vex::motor left_front, left_mid, left_rear;
+extern vex::motor right_front, right_mid, right_rear;
+extern vex::motor intake, flywheel;
+extern vex::motor_group left_motors, right_motors;
+extern vex::motor_group flywheel_motors;
+extern vex::digital_out endgame_solenoid, flapup_solenoid, intake_solenoid;
+
+// ======== INPUTS ========
+extern vex::inertial imu;
+extern vex::optical roller_sensor;
+
+// ======== UTILS ========
+extern PID::pid_config_t drive_pid_cfg, turn_pid_cfg, turn_mprofile_pid_cfg;
+extern FeedForward::ff_config_t drive_ff_cfg, turn_ff_cfg, turn_mprofile_ff_cfg;
+extern MotionController::m_profile_cfg_t drive_fast_mprofile_cfg, drive_slow_mprofile_cfg, turn_mprofile_cfg;
+extern MotionController drive_fast_mprofile, drive_slow_mprofile, turn_mprofile;
+extern PIDFF turn_pidff;
+extern robot_specs_t config;
+extern FeedForward::ff_config_t flywheel_ff_cfg;
+extern Flywheel::shot_config_t flywheel_shot_cfg;
+
+// ======== SUBSYSTEMS ========
+extern OdometryTank odometry_sys;
+extern TankDrive drive_sys;
+extern Flywheel flywheel_sys;
+
+// ======== SIMULATION ========
+extern plant_model_t drive_linear_model, drive_angular_model, flywheel_model;
+extern TankDrivePlant drive_plant;
+extern FlywheelPlant flywheel_plant;
+extern IntakePlant intake_plant;
+extern RollerPlant roller_plant;
+
+/**
+ * Start simulating the mechanisms, and finish the setup vexcodeInit() does for these subsystems
+ */
+void sim_robot_init();
+
+/**
+ * Run a movement until it reports it's done, or until it times out
+ * @param step        one call of a movement function, true when it's finished
+ * @param timeout_sec give up after this long
+ * @return how long the movement took (seconds), or -1 if it timed out
+ */
+double sim_run_until(std::function<bool(void)> step, double timeout_sec);
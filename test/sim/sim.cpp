@@ -0,0 +1,631 @@
+/**
+ * File: sim.cpp
+ * Desc:
+ *    Simulated time, and the parts of the stand-in V5 API the simulation links. See sim.h
+ */
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <math.h>
+#include <unistd.h>
+#include <string>
+#include <sys/stat.h>
+#include "vex.h"
+#include "sim.h"
+
+// ======================== SCHEDULER ========================
+
+namespace
+{
+  /**
+   * A task's thread, and where it is in the schedule
+   */
+  struct sim_task_t
+  {
+    int (*callback)(void *);
+    void *arg;
+    uint32_t wake_ms; ///< the simulated time it's sleeping until
+    bool running;     ///< true while it has the turn
+    bool done;        ///< its callback returned
+    bool stopped;     ///< task::stop() was called. It never gets another turn
+  };
+
+  /**
+   * Everything the scheduler keeps. Made on first use, because the library's global subsystems start tasks while
+   * the program's globals are still being constructed
+   */
+  struct scheduler_t
+  {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<sim_task_t *> tasks; // never freed, task handles refer to them by index
+    std::vector<std::function<void(double)>> plants;
+    uint32_t now = 0;
+  };
+
+  scheduler_t &sched()
+  {
+    static scheduler_t *s = new scheduler_t;
+    return *s;
+  }
+
+  thread_local sim_task_t *current_task = NULL; // NULL on the main thread
+
+  int call_void(void *fn)
+  {
+    return ((int (*)(void))fn)();
+  }
+
+  void task_main(sim_task_t *t)
+  {
+    current_task = t;
+    {
+      std::unique_lock<std::mutex> lock(sched().mutex);
+      sched().cv.wait(lock, [t]() { return t->running; });
+    }
+
+    t->callback(t->arg);
+
+    std::unique_lock<std::mutex> lock(sched().mutex);
+    t->done = true;
+    t->running = false;
+    sched().cv.notify_all();
+  }
+
+  /**
+   * Advance simulated time by one millisecond: step the plants, then give every task that is due its turn
+   */
+  void step_one_ms()
+  {
+    std::unique_lock<std::mutex> lock(sched().mutex);
+    sched().now++;
+
+    for (size_t i = 0; i < sched().plants.size(); i++)
+      sched().plants[i](0.001);
+
+    // By index: a task may start another one during its turn
+    for (size_t i = 0; i < sched().tasks.size(); i++)
+    {
+      sim_task_t *t = sched().tasks[i];
+      if (t->done || t->stopped || (int32_t)(sched().now - t->wake_ms) < 0)
+        continue;
+
+      t->running = true;
+      sched().cv.notify_all();
+      sched().cv.wait(lock, [t]() { return !t->running; });
+    }
+  }
+}
+
+void sim::add_plant(std::function<void(double dt)> step)
+{
+  std::unique_lock<std::mutex> lock(sched().mutex);
+  sched().plants.push_back(step);
+}
+
+uint32_t sim::now_ms()
+{
+  return sched().now;
+}
+
+void sim::finish(int code)
+{
+  fflush(stdout);
+  fflush(stderr);
+  _exit(code);
+}
+
+void vexDelay(uint32_t ms)
+{
+  sim_task_t *t = current_task;
+  if (t == NULL)
+  {
+    for (uint32_t i = 0; i < ms; i++)
+      step_one_ms();
+    return;
+  }
+
+  // Give the turn back, and wait until simulated time catches up
+  std::unique_lock<std::mutex> lock(sched().mutex);
+  t->wake_ms = sched().now + ms;
+  t->running = false;
+  sched().cv.notify_all();
+  sched().cv.wait(lock, [t]() { return t->running; });
+}
+
+uint32_t vexSystemTimeGet()
+{
+  return sched().now;
+}
+
+uint64_t vexSystemHighResTimeGet()
+{
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+int32_t vex_vsnprintf(char *out, uint32_t max_len, const char *format, va_list args)
+{
+  return vsnprintf(out, max_len, format, args);
+}
+
+void vex::wait(double time, timeUnits units)
+{
+  vexDelay((uint32_t)(units == timeUnits::sec ? time * 1000 : time));
+}
+
+vex::task::task() : id(-1) {}
+
+vex::task::task(int (*callback)(void)) : task(call_void, (void *)callback) {}
+
+vex::task::task(int (*callback)(void *), void *arg)
+{
+  sim_task_t *t = new sim_task_t{callback, arg, 0, false, false, false};
+  {
+    // Its first turn is the next simulated millisecond, like a new task on the brain running when its creator yields
+    std::unique_lock<std::mutex> lock(sched().mutex);
+    t->wake_ms = sched().now + 1;
+    id = (int)sched().tasks.size();
+    sched().tasks.push_back(t);
+  }
+  std::thread(task_main, t).detach();
+}
+
+vex::thread::thread(int (*callback)(void)) : t(callback) {}
+
+void vex::task::stop()
+{
+  if (id < 0)
+    return;
+  std::unique_lock<std::mutex> lock(sched().mutex);
+  sched().tasks[id]->stopped = true;
+}
+
+void vex::task::sleep(uint32_t ms)
+{
+  vexDelay(ms);
+}
+
+void vex::mutex::lock()
+{
+  while (!m.try_lock())
+    vexDelay(1);
+}
+
+// A task gives up its turn when it unlocks. On the brain, other tasks get to run between a loop's iterations even
+// if it never sleeps (OdometryBase's doesn't); here, a loop like that would stop simulated time
+void vex::mutex::unlock()
+{
+  m.unlock();
+  if (current_task != NULL)
+    vexDelay(1);
+}
+
+bool vex::mutex::try_lock()
+{
+  return m.try_lock();
+}
+
+// ======================== TIMER ========================
+
+vex::timer::timer() : start_ms(sched().now) {}
+
+void vex::timer::reset()
+{
+  start_ms = sched().now;
+}
+
+void vex::timer::clear()
+{
+  reset();
+}
+
+uint32_t vex::timer::time()
+{
+  return sched().now - start_ms;
+}
+
+double vex::timer::time(timeUnits units)
+{
+  return (units == timeUnits::sec) ? time() / 1000.0 : time();
+}
+
+double vex::timer::value()
+{
+  return time() / 1000.0;
+}
+
+uint32_t vex::timer::system()
+{
+  return sched().now;
+}
+
+uint64_t vex::timer::systemHighResolution()
+{
+  return vexSystemHighResTimeGet();
+}
+
+// ======================== DEVICES ========================
+
+bool vex::device::installed()
+{
+  return true;
+}
+
+int32_t vex::device::index()
+{
+  return 0;
+}
+
+/**
+ * @return the free speed of a motor with this encoder resolution: 100, 200 or 600 RPM
+ */
+static double max_rpm(double ticks_per_rev)
+{
+  return 12000.0 / ticks_per_rev * 15.0;
+}
+
+vex::motor::motor(int32_t, bool) {}
+
+vex::motor::motor(int32_t, gearSetting gears, bool)
+{
+  sim_ticks_per_rev = (gears == ratio36_1) ? 1800 : (gears == ratio6_1) ? 300 : 900;
+}
+
+void vex::motor::spin(directionType dir, double voltage, voltageUnits units)
+{
+  double volts = (units == voltageUnits::mV) ? voltage / 1000.0 : voltage;
+  volts = fmax(-12.0, fmin(12.0, volts));
+  sim_volts = (dir == directionType::rev) ? -volts : volts;
+  sim_stopped = false;
+}
+
+// The simulated motors have no velocity control of their own, so percent velocity is treated as percent voltage
+void vex::motor::spin(directionType dir, double velocity, percentUnits)
+{
+  spin(dir, velocity * 12.0 / 100.0, voltageUnits::volt);
+}
+
+void vex::motor::spin(directionType dir, double velocity, velocityUnits units)
+{
+  double free_rpm = max_rpm(sim_ticks_per_rev);
+  double pct = (units == velocityUnits::pct) ? velocity / 100.0 : (units == velocityUnits::dps) ? velocity / 6.0 / free_rpm : velocity / free_rpm;
+  spin(dir, pct * 12.0, voltageUnits::volt);
+}
+
+void vex::motor::stop()
+{
+  sim_volts = 0;
+  sim_stopped = true;
+}
+
+void vex::motor::stop(brakeType mode)
+{
+  sim_stopping = mode;
+  stop();
+}
+
+void vex::motor::setStopping(brakeType mode)
+{
+  sim_stopping = mode;
+}
+
+double vex::motor::velocity(velocityUnits units)
+{
+  if (units == velocityUnits::dps)
+    return sim_velocity * 6.0;
+  if (units == velocityUnits::pct)
+    return sim_velocity / max_rpm(sim_ticks_per_rev) * 100.0;
+  return sim_velocity;
+}
+
+double vex::motor::velocity(percentUnits)
+{
+  return velocity(velocityUnits::pct);
+}
+
+double vex::motor::position(rotationUnits units)
+{
+  // Whole encoder ticks only
+  double ticks = floor((sim_position - sim_position_offset) * sim_ticks_per_rev);
+  if (units == rotationUnits::raw)
+    return ticks;
+  if (units == rotationUnits::deg)
+    return ticks / sim_ticks_per_rev * 360.0;
+  return ticks / sim_ticks_per_rev;
+}
+
+double vex::motor::rotation(rotationUnits units)
+{
+  return position(units);
+}
+
+double vex::motor::current(currentUnits)
+{
+  return sim_current;
+}
+
+double vex::motor::voltage(voltageUnits units)
+{
+  return (units == voltageUnits::mV) ? sim_volts * 1000.0 : sim_volts;
+}
+
+void vex::motor::resetPosition()
+{
+  sim_position_offset = sim_position;
+}
+
+void vex::motor::resetRotation()
+{
+  resetPosition();
+}
+
+void vex::motor::setPosition(double value, rotationUnits units)
+{
+  double revs = (units == rotationUnits::deg) ? value / 360.0 : (units == rotationUnits::raw) ? value / sim_ticks_per_rev : value;
+  sim_position_offset = sim_position - revs;
+}
+
+void vex::motor_group::spin(directionType dir, double voltage, voltageUnits units)
+{
+  for (motor *m : motors)
+    m->spin(dir, voltage, units);
+}
+
+void vex::motor_group::spin(directionType dir, double velocity, percentUnits units)
+{
+  for (motor *m : motors)
+    m->spin(dir, velocity, units);
+}
+
+void vex::motor_group::spin(directionType dir, double velocity, velocityUnits units)
+{
+  for (motor *m : motors)
+    m->spin(dir, velocity, units);
+}
+
+void vex::motor_group::stop()
+{
+  for (motor *m : motors)
+    m->stop();
+}
+
+void vex::motor_group::stop(brakeType mode)
+{
+  for (motor *m : motors)
+    m->stop(mode);
+}
+
+void vex::motor_group::setStopping(brakeType mode)
+{
+  for (motor *m : motors)
+    m->setStopping(mode);
+}
+
+double vex::motor_group::velocity(velocityUnits units)
+{
+  double total = 0;
+  for (motor *m : motors)
+    total += m->velocity(units);
+  return total / motors.size();
+}
+
+double vex::motor_group::velocity(percentUnits units)
+{
+  double total = 0;
+  for (motor *m : motors)
+    total += m->velocity(units);
+  return total / motors.size();
+}
+
+double vex::motor_group::position(rotationUnits units)
+{
+  double total = 0;
+  for (motor *m : motors)
+    total += m->position(units);
+  return total / motors.size();
+}
+
+double vex::motor_group::rotation(rotationUnits units)
+{
+  return position(units);
+}
+
+double vex::motor_group::current(currentUnits units)
+{
+  double total = 0;
+  for (motor *m : motors)
+    total += m->current(units);
+  return total;
+}
+
+double vex::motor_group::voltage(voltageUnits units)
+{
+  double total = 0;
+  for (motor *m : motors)
+    total += m->voltage(units);
+  return total / motors.size();
+}
+
+void vex::motor_group::resetPosition()
+{
+  for (motor *m : motors)
+    m->resetPosition();
+}
+
+void vex::motor_group::resetRotation()
+{
+  resetPosition();
+}
+
+void vex::motor_group::setPosition(double value, rotationUnits units)
+{
+  for (motor *m : motors)
+    m->setPosition(value, units);
+}
+
+vex::inertial::inertial(int32_t) {}
+
+void vex::inertial::calibrate() {}
+
+bool vex::inertial::isCalibrating()
+{
+  return false;
+}
+
+double vex::inertial::rotation(rotationUnits)
+{
+  return sim_rotation - sim_offset;
+}
+
+double vex::inertial::heading(rotationUnits)
+{
+  double h = fmod(rotation(rotationUnits::deg), 360.0);
+  return (h < 0) ? h + 360.0 : h;
+}
+
+double vex::inertial::gyroRate(axisType, velocityUnits)
+{
+  return sim_rate;
+}
+
+void vex::inertial::resetRotation()
+{
+  sim_offset = sim_rotation;
+}
+
+vex::digital_out::digital_out(triport::port &) {}
+
+void vex::digital_out::set(bool value)
+{
+  state = value;
+}
+
+int32_t vex::digital_out::value()
+{
+  return state;
+}
+
+vex::optical::optical(int32_t) {}
+
+double vex::optical::hue()
+{
+  return sim_hue;
+}
+
+bool vex::vision::installed()
+{
+  return false;
+}
+
+int32_t vex::vision::takeSnapshot(signature &)
+{
+  objectCount = 0;
+  largestObject = object();
+  return 0;
+}
+
+// Nothing simulates the three wire encoders: they never move
+vex::encoder::encoder(triport::port &) {}
+
+double vex::encoder::position(rotationUnits)
+{
+  return 0;
+}
+
+double vex::encoder::rotation(rotationUnits)
+{
+  return 0;
+}
+
+double vex::encoder::velocity(velocityUnits)
+{
+  return 0;
+}
+
+void vex::encoder::resetRotation() {}
+
+void vex::encoder::setPosition(double, rotationUnits) {}
+
+void vex::encoder::setRotation(double, rotationUnits) {}
+
+// The SD card is a directory on the host, once sim::set_sdcard() has put one in. Files are read from it, but
+// nothing is ever written: a run can't change what the next one loads. Made on first use, like the scheduler,
+// since globals may look for a card while the program's globals are still being constructed
+static std::string &sdcard_dir()
+{
+  static std::string *dir = new std::string;
+  return *dir;
+}
+
+void sim::set_sdcard(const char *dir)
+{
+  sdcard_dir() = dir;
+}
+
+static std::string sdcard_path(const char *name)
+{
+  return sdcard_dir() + "/" + name;
+}
+
+bool vex::brain::sdcard::isInserted()
+{
+  return !sdcard_dir().empty();
+}
+
+int32_t vex::brain::sdcard::size(const char *name)
+{
+  struct stat st;
+  if (!isInserted() || stat(sdcard_path(name).c_str(), &st) != 0)
+    return 0;
+  return (int32_t)st.st_size;
+}
+
+bool vex::brain::sdcard::exists(const char *name)
+{
+  struct stat st;
+  return isInserted() && stat(sdcard_path(name).c_str(), &st) == 0;
+}
+
+int32_t vex::brain::sdcard::loadfile(const char *name, uint8_t *buf, int32_t len)
+{
+  if (!isInserted())
+    return 0;
+  FILE *f = fopen(sdcard_path(name).c_str(), "rb");
+  if (f == NULL)
+    return 0;
+  int32_t n = (int32_t)fread(buf, 1, len, f);
+  fclose(f);
+  return n;
+}
+
+int32_t vex::brain::sdcard::savefile(const char *, uint8_t *, int32_t)
+{
+  return 0;
+}
+
+int32_t vex::brain::sdcard::appendfile(const char *, uint8_t *, int32_t)
+{
+  return 0;
+}
+
+// Nobody is holding the controller
+bool vex::controller::button::pressing()
+{
+  return false;
+}
+
+void vex::controller::button::pressed(void (*)(void)) {}
+
+int32_t vex::controller::axis::position(percentUnits)
+{
+  return 0;
+}
+
+// A battery that never sags, so BatteryCompensation leaves outputs alone
+double vex::brain::battery::voltage(voltageUnits units)
+{
+  return (units == voltageUnits::mV) ? 12000.0 : 12.0;
+}
+
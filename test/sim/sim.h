@@ -0,0 +1,46 @@
+/**
+ * File: sim.h
+ * Desc:
+ *    Simulated time for the host simulation. The library runs unchanged on top of the stand-in V5 API in
+ *    test/sim/vex, and everything it does happens in simulated time:
+ *
+ *    - vexDelay() from the main program advances time one millisecond at a time. Each millisecond, every plant
+ *      is stepped, then every task that is due runs until it calls vexDelay() again.
+ *    - vex::task starts a real thread, but only one thread runs at a time, in the order the tasks were made.
+ *      A run gives the same results every time, however loaded the host is.
+ *    - A task that unlocks a vex::mutex gives up its turn for a millisecond, the way the brain would run other
+ *      tasks between iterations of a loop that never sleeps.
+ *    - vex::timer::system() is simulated time. vex::timer::systemHighResolution() is the host's clock, so the
+ *      library's CPU time measurements (ControlLoop tick stats, command run time) are real.
+ */
+#pragma once
+
+#include <functional>
+#include <stdint.h>
+
+namespace sim
+{
+  /**
+   * Add a plant, stepped every simulated millisecond before any task runs
+   * @param step advances the plant by dt seconds: reads the motor commands, writes the sensors
+   */
+  void add_plant(std::function<void(double dt)> step);
+
+  /**
+   * @return the simulated time, in milliseconds
+   */
+  uint32_t now_ms();
+
+  /**
+   * Put an SD card in the simulated brain: vex::brain::sdcard reads its files from a directory on the host, and
+   * never writes to it. Without one, there's no card
+   * @param dir the directory
+   */
+  void set_sdcard(const char *dir);
+
+  /**
+   * End the program. Tasks loop forever, so this exits without waiting for them
+   * @param code the exit code
+   */
+  void finish(int code = 0);
+}
@@ -0,0 +1,86 @@
+/**
+ * File: sim_blend.cpp
+ * Desc:
+ *    Chained drive commands on the simulated drive, with and without CommandController::set_blend_speed(): how
+ *    long each route takes, and how far from its last point the robot ends up. Blended commands carry their
+ *    speed into the next one instead of stopping at each point.
+ */
+#include <math.h>
+#include "robot.h"
+#include "sim.h"
+
+using namespace vex;
+
+#define BLEND_SPEED 48 // inches/second
+#define COMMAND_TIMEOUT 5 // seconds
+
+/**
+ * Run one route from (0, 0) facing +y, and measure it
+ * @param name what the route is
+ * @param blend_speed passed to set_blend_speed(). 0 to stop at each point
+ * @param end where the route should end
+ * @param route the route's commands, built fresh for each run
+ */
+static void run(const char *name, double blend_speed, point_t end, std::function<std::vector<AutoCommand *>(void)> route)
+{
+  drive_plant.place(0, 0, 90);
+  odometry_sys.set_position({.x = 0, .y = 0, .rot = 90});
+  vexDelay(20);
+
+  CommandController ctrl;
+  ctrl.set_blend_speed(blend_speed);
+  ctrl.add(route(), COMMAND_TIMEOUT);
+
+  uint32_t start = timer::system();
+  ctrl.run();
+  double time = (timer::system() - start) / 1000.0;
+
+  int timed_out = 0;
+  for (CommandController::command_record_t &record : ctrl.get_profile())
+    timed_out += record.timed_out;
+
+  // Where it ends up once it has stopped
+  vexDelay(500);
+  double error = sqrt(pow(drive_plant.x - end.x, 2) + pow(drive_plant.y - end.y, 2));
+  printf("%-34s %-8s %6.2f %10.2f %10d\n", name, (blend_speed > 0) ? "blended" : "stops", time, error, timed_out);
+}
+
+int main()
+{
+  sim_robot_init();
+
+  printf("Blend speed %d in/s. Time in seconds, distances in inches\n", BLEND_SPEED);
+  printf("%-34s %-8s %6s %10s %10s\n", "route", "", "time", "final err", "timed out");
+
+  for (double blend : {0.0, (double)BLEND_SPEED})
+    run("DriveForward 24 x3", blend, {0, 72}, []() {
+      return std::vector<AutoCommand *>{
+          new DriveForwardCommand(drive_sys, drive_fast_mprofile, 24, fwd),
+          new DriveForwardCommand(drive_sys, drive_fast_mprofile, 24, fwd),
+          new DriveForwardCommand(drive_sys, drive_fast_mprofile, 24, fwd)};
+    });
+
+  for (double blend : {0.0, (double)BLEND_SPEED})
+    run("DriveForward 24, DriveToPoint x2", blend, {0, 72}, []() {
+      return std::vector<AutoCommand *>{
+          new DriveForwardCommand(drive_sys, drive_fast_mprofile, 24, fwd),
+          new DriveToPointCommand(drive_sys, drive_fast_mprofile, 0, 48, fwd),
+          new DriveToPointCommand(drive_sys, drive_fast_mprofile, 0, 72, fwd)};
+    });
+
+  for (double blend : {0.0, (double)BLEND_SPEED})
+    run("DriveToPoint, DriveForward 24", blend, {0, 48}, []() {
+      return std::vector<AutoCommand *>{
+          new DriveToPointCommand(drive_sys, drive_fast_mprofile, 0, 24, fwd),
+          new DriveForwardCommand(drive_sys, drive_fast_mprofile, 24, fwd)};
+    });
+
+  for (double blend : {0.0, (double)BLEND_SPEED})
+    run("DriveToPoint, 30 degree corner", blend, {12, 44.8}, []() {
+      return std::vector<AutoCommand *>{
+          new DriveToPointCommand(drive_sys, drive_fast_mprofile, 0, 24, fwd),
+          new DriveToPointCommand(drive_sys, drive_fast_mprofile, 12, 44.8, fwd)};
+    });
+
+  sim::finish();
+}
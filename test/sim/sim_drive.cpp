@@ -0,0 +1,116 @@
+/**
+ * File: sim_drive.cpp
+ * Desc:
+ *    Driving to a point off to the side on the simulated drive, four ways:
+ *    - turn, then drive: turn_to_heading() then drive_to_point(), the way the routes do it
+ *    - drive_to_point() alone, correcting the heading as it goes
+ *    - drive_to_point(), then turn_to_heading() to the heading the arc would end at
+ *    - drive_arc_to_point(), along one arc
+ *    All of them drive with drive_fast_mprofile and turn with turn_pidff. Positions are measured on the plant,
+ *    not from odometry.
+ */
+#include <math.h>
+#include "robot.h"
+#include "sim.h"
+
+using namespace vex;
+
+#define MOVE_TIMEOUT 5 // seconds
+
+enum drive_style_t
+{
+  TURN_THEN_DRIVE,
+  DRIVE_TO_POINT,
+  DRIVE_THEN_TURN,
+  DRIVE_ARC
+};
+
+const char *style_names[] = {"turn, drive", "drive_to_point", "drive, turn", "drive_arc"};
+
+/**
+ * How far the robot is from the path it planned to drive: the straight line from the start to (x, y), or for the
+ * arc, the circle tangent to +y at the origin that goes through (x, y)
+ */
+static double off_plan(drive_style_t style, double x, double y)
+{
+  double px = drive_plant.x, py = drive_plant.y;
+  if (style != DRIVE_ARC || fabs(x) < 1e-6)
+    return fabs((px * y) - (py * x)) / sqrt((x * x) + (y * y));
+
+  double radius = ((x * x) + (y * y)) / (2 * x); // center is at (radius, 0)
+  return fabs(sqrt(pow(px - radius, 2) + (py * py)) - fabs(radius));
+}
+
+/**
+ * Put the robot at the origin facing +y, drive to (x, y) and measure how it went
+ */
+static void drive(drive_style_t style, double x, double y)
+{
+  drive_plant.place(0, 0, 90);
+  odometry_sys.set_position({.x = 0, .y = 0, .rot = 90});
+  vexDelay(20);
+
+  // The arc from here to (x, y) turns twice the angle between the heading and the line to the point
+  double line_heading = atan2(y, x) * 180.0 / PI;
+  double arc_heading = 90 + 2 * (line_heading - 90);
+
+  double max_off = 0;
+  auto step = [&](std::function<bool(void)> move) {
+    return [&, move]() {
+      max_off = fmax(max_off, off_plan(style, x, y));
+      return move();
+    };
+  };
+  auto drive_line = step([&]() { return drive_sys.drive_to_point(x, y, fwd, drive_fast_mprofile); });
+
+  double time = 0;
+  if (style == TURN_THEN_DRIVE)
+  {
+    double turn_time = sim_run_until(step([&]() { return drive_sys.turn_to_heading(line_heading, turn_pidff); }),
+                                     MOVE_TIMEOUT);
+    double drive_time = sim_run_until(drive_line, MOVE_TIMEOUT);
+    time = (turn_time < 0 || drive_time < 0) ? -1 : turn_time + drive_time;
+  }
+  else if (style == DRIVE_TO_POINT)
+    time = sim_run_until(drive_line, MOVE_TIMEOUT);
+  else if (style == DRIVE_THEN_TURN)
+  {
+    double drive_time = sim_run_until(drive_line, MOVE_TIMEOUT);
+    double turn_time = sim_run_until([&]() { return drive_sys.turn_to_heading(arc_heading, turn_pidff); },
+                                     MOVE_TIMEOUT);
+    time = (turn_time < 0 || drive_time < 0) ? -1 : turn_time + drive_time;
+  }
+  else
+    time = sim_run_until(step([&]() { return drive_sys.drive_arc_to_point(x, y, fwd, drive_fast_mprofile); }),
+                         MOVE_TIMEOUT);
+
+  if (time < 0)
+  {
+    drive_sys.stop();
+    drive_sys.reset_auto();
+  }
+
+  // Where it ends up once it has stopped
+  vexDelay(500);
+  double error = sqrt(pow(drive_plant.x - x, 2) + pow(drive_plant.y - y, 2));
+
+  printf("(%3.0f, %3.0f)  %-15s %6.2f %10.2f %8.0f %9.1f\n", x, y, style_names[style], time, error,
+         wrap_angle_deg(drive_plant.heading), max_off);
+}
+
+int main()
+{
+  sim_robot_init();
+
+  printf("Start at (0, 0) facing +y. Time in seconds until the movement reports it's done, -1 = timed out after "
+         "%ds. Distances in inches, headings in degrees\n",
+         MOVE_TIMEOUT);
+  printf("%-12s  %-15s %6s %10s %8s %9s\n", "target", "drive", "time", "final err", "heading", "off plan");
+
+  double targets[][2] = {{0, 48}, {12, 48}, {24, 48}, {-24, 48}, {36, 36}, {48, 24}, {24, 24}};
+  for (auto &target : targets)
+    for (int style = TURN_THEN_DRIVE; style <= DRIVE_ARC; style++)
+      drive((drive_style_t)style, target[0], target[1]);
+
+  sim::finish();
+}
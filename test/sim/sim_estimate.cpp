@@ -0,0 +1,131 @@
+/**
+ * File: sim_estimate.cpp
+ * Desc:
+ *    Runs one of the robot's autonomous routes on the simulated robot, and checks it against its time budget.
+ *    The route is built by the same function the robot calls (src/competition), or loaded from an AutoScript file
+ *    the way script_auto.cpp loads one from the SD card. CommandController::estimate() prints its estimate of each
+ *    command first, then the route runs, and each command's real time is printed next to it.
+ *
+ *      sim_estimate <route> [budget]
+ *
+ *    route is only_roller_auto, skills_rollers_last, or the path to an AutoScript file. budget is in seconds, 15
+ *    (a match) if it isn't given. Exits with 1 if the route takes longer than its budget in the simulation.
+ *
+ *    There is no camera, so VisionAimCommand finishes at once, and nothing on the field: see IntakePlant and
+ *    RollerPlant in plants.h for how the discs and the roller are simulated.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include "robot.h"
+#include "sim.h"
+#include "competition/autonomous_flynn.h"
+#include "competition/script_auto.h"
+
+using namespace vex;
+
+#define DEFAULT_BUDGET 15 // seconds
+
+static int saved_stdout = -1;
+
+/**
+ * Throw away everything printed until quiet(false). The commands print as they run (ShootCommand prints the
+ * flywheel's speed every tick), which would bury the results
+ */
+static void quiet(bool on)
+{
+  fflush(stdout);
+  if (on)
+  {
+    saved_stdout = dup(STDOUT_FILENO);
+    if (freopen("/dev/null", "w", stdout) == NULL)
+      sim::finish(2);
+  }
+  else
+  {
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+  }
+}
+
+/**
+ * Build the route named on the command line
+ * @param name a route builder's name, or the path to an AutoScript file
+ * @param ctrl filled in with the route
+ * @return false if there's no such route, or the script didn't load
+ */
+static bool build_route(const std::string &name, CommandController &ctrl)
+{
+  if (name == "only_roller_auto")
+    ctrl = only_roller_auto();
+  else if (name == "skills_rollers_last")
+    ctrl = skills_rollers_last();
+  else
+  {
+    // The script's directory is the SD card. Loading prints an estimate too, which would be printed twice
+    size_t slash = name.rfind('/');
+    std::string dir = (slash == std::string::npos) ? "." : name.substr(0, slash);
+    std::string file = (slash == std::string::npos) ? name : name.substr(slash + 1);
+    sim::set_sdcard(dir.c_str());
+    quiet(true);
+    bool loaded = load_script_auto(file.c_str());
+    quiet(false);
+    if (!loaded)
+    {
+      printf("%s didn't load:\n", name.c_str());
+      for (std::string &err : script_auto_errors())
+        printf("  %s\n", err.c_str());
+      return false;
+    }
+    ctrl = script_auto();
+  }
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    printf("usage: %s <only_roller_auto | skills_rollers_last | script file> [budget seconds]\n", argv[0]);
+    sim::finish(2);
+  }
+  std::string name = argv[1];
+  double budget = (argc > 2) ? atof(argv[2]) : DEFAULT_BUDGET;
+
+  sim_robot_init();
+
+  CommandController ctrl;
+  if (!build_route(name, ctrl))
+    sim::finish(2);
+
+  printf("CommandController::estimate():\n");
+  double worst = 0;
+  double estimate = ctrl.estimate(odometry_sys.get_position(), budget, NULL, &worst);
+
+  quiet(true);
+  uint32_t start = timer::system();
+  ctrl.run();
+  double actual = (timer::system() - start) / 1000.0;
+  quiet(false);
+
+  std::vector<CommandController::command_record_t> profile = ctrl.get_profile();
+  printf("\nRun on the simulated robot. Times in seconds\n");
+  printf("%-8s %8s %10s\n", "command", "actual", "timed out");
+  for (size_t i = 0; i < profile.size(); i++)
+    printf("%-8d %8.2f %10s\n", (int)i + 1, profile[i].duration_ms / 1000.0, profile[i].timed_out ? "yes" : "");
+  if (profile.size() == PROFILE_MAX_RECORDS)
+    printf("(the profile only records the first %d commands)\n", PROFILE_MAX_RECORDS);
+
+  printf("\n%s, %.0f second budget\n", name.c_str(), budget);
+  printf("  estimated  %6.2f  (worst case %.2f)\n", estimate, worst);
+  printf("  simulated  %6.2f  (estimate off by %+.2f)\n", actual, estimate - actual);
+  printf("  discs shot %6d\n", intake_plant.shots);
+  if (actual > budget)
+    printf("  OVER BUDGET by %.2f\n", actual - budget);
+  else
+    printf("  within budget, %.2f to spare\n", budget - actual);
+
+  sim::finish(actual > budget ? 1 : 0);
+}
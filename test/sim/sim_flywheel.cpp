@@ -0,0 +1,142 @@
+/**
+ * File: sim_flywheel.cpp
+ * Desc:
+ *    Flywheel control styles on a simulated flywheel: how fast each spins up, how much the speed ripples once it
+ *    is there, and how fast it recovers from a shot. Everything is measured on the plant's real speed, not the
+ *    noisy reading the controller sees.
+ *
+ *    The flywheel has the constants tune_flywheel_sysid() would find, and a motor on the 18:1 cartridge
+ *    (900 ticks per revolution) through an 18:1 ratio, like flywheel_sys in src/robot-config.cpp.
+ */
+#include <math.h>
+#include "core.h"
+#include "plants.h"
+#include "sim.h"
+
+using namespace vex;
+
+#define TARGET_RPM 3000
+#define SETTLED_RPM 50 // within this of the target counts as at speed
+#define SHOT_PERIOD_MS 2000
+
+// The flywheel's real constants, per flywheel RPM. Top speed is (1 - kS) / kV = 3267 RPM
+plant_model_t flywheel_model = {
+    .kS = 0.02,
+    .kV = 0.0003,
+    .kA = 0.00015};
+
+// Standard deviation of the motor's velocity reading, in flywheel RPM
+#define VELOCITY_NOISE_RPM 20
+
+// The feedforward in src/robot-config.cpp: kV only, no PID
+FeedForward::ff_config_t ff_only_cfg = {
+    .kV = 0.0003};
+PID::pid_config_t no_pid_cfg = {
+    .p = 0};
+
+// The identified constants, with a P term on top
+FeedForward::ff_config_t identified_ff_cfg = {
+    .kS = flywheel_model.kS,
+    .kV = flywheel_model.kV,
+    .kA = flywheel_model.kA};
+PID::pid_config_t fw_pid_cfg = {
+    .p = .001};
+
+// flywheel_ss_cfg in src/robot-config.cpp
+VelocityStateSpace::ss_config_t fw_ss_cfg = {
+    .max_error = 50,
+    .max_effort = 1,
+    .closed_loop_pole = 0,
+    .model_stdev = 20,
+    .encoder_stdev = 0.02,
+    .period_ms = 10};
+
+// One motor and one simulated flywheel for each control style, so every run starts from a stopped flywheel
+motor ff_motor(PORT10), pidff_motor(PORT11), ss_motor(PORT12);
+motor_group ff_motors(ff_motor), pidff_motors(pidff_motor), ss_motors(ss_motor);
+
+FlywheelPlant ff_plant(ff_motors, flywheel_model, 18, VELOCITY_NOISE_RPM);
+FlywheelPlant pidff_plant(pidff_motors, flywheel_model, 18, VELOCITY_NOISE_RPM);
+FlywheelPlant ss_plant(ss_motors, flywheel_model, 18, VELOCITY_NOISE_RPM);
+
+Flywheel ff_flywheel(ff_motors, no_pid_cfg, ff_only_cfg, 18);
+Flywheel pidff_flywheel(pidff_motors, fw_pid_cfg, identified_ff_cfg, 18);
+Flywheel ss_flywheel(ss_motors, identified_ff_cfg, fw_ss_cfg, 18);
+
+/**
+ * Wait until the flywheel is within SETTLED_RPM of the target
+ * @return how long it took (seconds), or -1 if it didn't get there within max_ms
+ */
+static double time_to_settle(FlywheelPlant &plant, int max_ms)
+{
+  for (int ms = 0; ms < max_ms; ms++)
+  {
+    if (fabs(TARGET_RPM - plant.true_rpm()) < SETTLED_RPM)
+      return ms / 1000.0;
+    vexDelay(1);
+  }
+  return -1;
+}
+
+/**
+ * Spin one flywheel up, hold it, then shoot three discs that take 5%, 10% and 15% of its speed
+ */
+static void run(const char *name, Flywheel &flywheel, FlywheelPlant &plant)
+{
+  flywheel.spinRPM(TARGET_RPM);
+  double rise = time_to_settle(plant, 5000);
+
+  // Overshoot over the first second at speed, then the ripple over the next two
+  double overshoot = 0;
+  for (int ms = 0; ms < 1000; ms++)
+  {
+    overshoot = fmax(overshoot, plant.true_rpm() - TARGET_RPM);
+    vexDelay(1);
+  }
+
+  double sum = 0, sum_sq = 0, lo = 1e9, hi = -1e9;
+  int n = 2000;
+  for (int ms = 0; ms < n; ms++)
+  {
+    double rpm = plant.true_rpm();
+    sum += rpm;
+    sum_sq += rpm * rpm;
+    lo = fmin(lo, rpm);
+    hi = fmax(hi, rpm);
+    vexDelay(1);
+  }
+  double mean = sum / n;
+  double stdev = sqrt(fmax(0, (sum_sq / n) - (mean * mean)));
+
+  double recovery[3];
+  double drops[3] = {0.05, 0.10, 0.15};
+  for (int i = 0; i < 3; i++)
+  {
+    plant.shoot(drops[i]);
+    recovery[i] = time_to_settle(plant, SHOT_PERIOD_MS);
+    vexDelay(SHOT_PERIOD_MS - (recovery[i] < 0 ? SHOT_PERIOD_MS : (int)(recovery[i] * 1000)));
+  }
+
+  flywheel.stop();
+
+  printf("%-14s %8.2f %10.0f %10.1f %8.1f %8.0f %8.2f %8.2f %8.2f\n", name, rise, overshoot, TARGET_RPM - mean, stdev,
+         hi - lo, recovery[0], recovery[1], recovery[2]);
+}
+
+int main()
+{
+  ff_plant.attach();
+  pidff_plant.attach();
+  ss_plant.attach();
+
+  printf("Target %d RPM. Times in seconds to within %d RPM, -1 = never. RPM measured on the real flywheel speed\n",
+         TARGET_RPM, SETTLED_RPM);
+  printf("%-14s %8s %10s %10s %8s %8s %8s %8s %8s\n", "control", "spin-up", "overshoot", "mean err", "ripple",
+         "p-p", "shot 5%", "shot 10%", "shot 15%");
+
+  run("FF (config)", ff_flywheel, ff_plant);
+  run("PID+FF", pidff_flywheel, pidff_plant);
+  run("State space", ss_flywheel, ss_plant);
+
+  sim::finish();
+}
@@ -0,0 +1,86 @@
+/**
+ * File: sim_shot.cpp
+ * Desc:
+ *    A shot followed by WaitUntilRecoveredCommand, the way the routes in src/competition shoot: the disc is fed
+ *    while the shoot command runs, so the flywheel usually sees it before the wait starts. The wait has to end
+ *    once the flywheel recovers, not run out its timeout. Exits with 1 if any wait times out.
+ *
+ *    The flywheel is flywheel_sys from src/robot-config.cpp (feedforward only, with flywheel_shot_cfg) on the
+ *    flywheel from sim_flywheel (see robot.cpp).
+ */
+#include <math.h>
+#include "robot.h"
+#include "sim.h"
+
+using namespace vex;
+
+#define TARGET_RPM 3000
+#define DISC_DROP 0.10      // fraction of its speed the flywheel loses to a disc
+#define DISC_TRAVEL_MS 100  // from starting to feed until the disc reaches the flywheel
+#define RECOVER_DELAY_MS 200
+#define RECOVER_TIMEOUT 0.5 // seconds
+
+/**
+ * Stands in for ShootCommand (src/automation.cpp): feeds for `seconds`, split evenly between `discs` discs. Each
+ * disc reaches the flywheel DISC_TRAVEL_MS after it starts being fed
+ */
+class SimShootCommand : public AutoCommand
+{
+public:
+  SimShootCommand(double seconds, int discs) : seconds(seconds), discs(discs) {}
+
+  bool run() override
+  {
+    if (!started)
+    {
+      started = true;
+      start_ms = timer::system();
+    }
+    int elapsed = timer::system() - start_ms;
+    int period_ms = (int)(seconds * 1000) / discs;
+    if (fired < discs && elapsed >= fired * period_ms + DISC_TRAVEL_MS)
+    {
+      flywheel_plant.shoot(DISC_DROP);
+      fired++;
+    }
+    return elapsed >= seconds * 1000;
+  }
+
+private:
+  double seconds;
+  int discs;
+  int fired = 0;
+  bool started = false;
+  uint32_t start_ms = 0;
+};
+
+/**
+ * Shoot, then wait for the flywheel to recover, the way add_single_shot_cmd() and add_tri_shot_cmd() do
+ * @return true if the wait ended before its timeout
+ */
+static bool run(const char *name, double shot_seconds, int discs)
+{
+  CommandController ctrl;
+  ctrl.add(new WaitUntilUpToSpeedCommand(flywheel_sys, 150), 3.0);
+  ctrl.add(new SimShootCommand(shot_seconds, discs), 2.0);
+  ctrl.add(new WaitUntilRecoveredCommand(flywheel_sys, RECOVER_DELAY_MS, shot_seconds * 1000), RECOVER_TIMEOUT);
+  ctrl.run();
+
+  CommandController::command_record_t wait = ctrl.get_profile().back();
+  printf("%-12s %8.2f %8.2f %10s\n", name, wait.duration_ms / 1000.0, RECOVER_TIMEOUT, wait.timed_out ? "yes" : "no");
+  return !wait.timed_out;
+}
+
+int main()
+{
+  sim_robot_init();
+  flywheel_sys.spinRPM(TARGET_RPM);
+
+  printf("Target %d RPM, each disc takes %.0f%% of the flywheel's speed. Times in seconds\n", TARGET_RPM, DISC_DROP * 100);
+  printf("%-12s %8s %8s %10s\n", "shot", "wait", "timeout", "timed out");
+
+  bool ok = run("single", 0.2, 1);
+  ok = run("tri", 1.0, 3) && ok;
+
+  sim::finish(ok ? 0 : 1);
+}
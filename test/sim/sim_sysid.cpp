@@ -0,0 +1,88 @@
+/**
+ * File: sim_sysid.cpp
+ * Desc:
+ *    How closely SysId finds the constants of a mechanism whose constants are known: the simulated drive (kS .07,
+ *    kV .011, kA .0015 per inch/second, see robot.cpp) and flywheel.
+ *
+ *    The drive is characterized three ways: with its exact velocity, with noise added to it, and with
+ *    MotionController::tune_feedforward(), which gets velocity from odometry on the motor encoders. The flywheel is
+ *    characterized the way tune_flywheel_sysid() does it.
+ */
+#include <math.h>
+#include <random>
+#include "robot.h"
+#include "sim.h"
+
+using namespace vex;
+
+#define VELOCITY_NOISE 0.5 // inches/second
+
+// Same tests as MotionController::tune_feedforward() with its defaults (60%, 2 seconds)
+SysId::sysid_cfg_t drive_sysid_cfg = {
+    .ramp_rate = 0.6 / 2,
+    .step_pct = 0.6,
+    .quasistatic_time = 2,
+    .dynamic_time = 2,
+    .period_ms = 10,
+    .fit_kg = false};
+
+// Same tests as tune_flywheel_sysid()
+SysId::sysid_cfg_t flywheel_sysid_cfg = {
+    .ramp_rate = 0.1,
+    .step_pct = 0.8,
+    .quasistatic_time = 8,
+    .dynamic_time = 3,
+    .period_ms = 10,
+    .fit_kg = false};
+
+/**
+ * Print one fitted constant next to the real one
+ */
+static void print_constant(const char *name, double real, double fit)
+{
+  printf("  %-3s %10.6f %10.6f %8.1f%%\n", name, real, fit, 100.0 * (fit - real) / real);
+}
+
+static void print_fit(const char *name, plant_model_t real, FeedForward::ff_config_t fit)
+{
+  printf("%s\n", name);
+  printf("  %-3s %10s %10s %9s\n", "", "real", "found", "error");
+  print_constant("kS", real.kS, fit.kS);
+  print_constant("kV", real.kV, fit.kV);
+  print_constant("kA", real.kA, fit.kA);
+}
+
+int main()
+{
+  sim_robot_init();
+
+  std::mt19937 rng(1);
+  std::normal_distribution<double> noise(0, VELOCITY_NOISE);
+
+  SysId exact([](double pct) { drive_sys.drive_tank(pct, pct, 1); }, []() { return drive_plant.speed(); },
+              drive_sysid_cfg);
+  SysId::sysid_result_t exact_result = exact.run();
+  drive_sys.stop();
+
+  SysId noisy([](double pct) { drive_sys.drive_tank(pct, pct, 1); },
+              [&]() { return drive_plant.speed() + noise(rng); }, drive_sysid_cfg);
+  SysId::sysid_result_t noisy_result = noisy.run();
+  drive_sys.stop();
+  vexDelay(2000);
+
+  FeedForward::ff_config_t odom_ff = MotionController::tune_feedforward(drive_sys, odometry_sys);
+  vexDelay(2000);
+
+  SysId flywheel_sysid([](double pct) { flywheel_sys.spin_raw(pct); }, []() { return flywheel_sys.measureRPM(); },
+                       flywheel_sysid_cfg, 2500);
+  SysId::sysid_result_t flywheel_result = flywheel_sysid.run(5.0);
+  flywheel_sys.stop();
+
+  printf("\n");
+  print_fit("Drive, exact velocity", drive_linear_model, exact_result.ff);
+  print_fit("Drive, velocity + 0.5 in/s noise", drive_linear_model, noisy_result.ff);
+  print_fit("Drive, MotionController::tune_feedforward (odometry)", drive_linear_model, odom_ff);
+  print_fit("Flywheel, tune_flywheel_sysid tests (measureRPM, 20 RPM noise)", flywheel_model, flywheel_result.ff);
+
+  sim::finish();
+}
@@ -0,0 +1,66 @@
+/**
+ * File: sim_turn.cpp
+ * Desc:
+ *    Turns on the simulated drive: the PID turn that the robot's routes use (turn_pidff) against the profiled
+ *    turn (turn_mprofile), and how closely MotionController::tune_feedforward_angular() finds the drive's turning
+ *    constants. Headings are measured on the plant, not from odometry.
+ */
+#include <math.h>
+#include "robot.h"
+#include "sim.h"
+
+using namespace vex;
+
+#define TURN_TIMEOUT 5 // seconds
+
+/**
+ * Turn in place, and measure how it went
+ */
+static void turn(const char *name, Feedback &feedback, double degrees)
+{
+  double start = drive_plant.heading;
+  double target = start + degrees;
+  double overshoot = 0;
+
+  double time = sim_run_until([&]() {
+    overshoot = fmax(overshoot, (drive_plant.heading - target) * (degrees > 0 ? 1 : -1));
+    return drive_sys.turn_degrees(degrees, feedback);
+  }, TURN_TIMEOUT);
+  if (time < 0)
+    drive_sys.stop();
+
+  // Where it ends up once it has stopped
+  vexDelay(500);
+  double error = drive_plant.heading - target;
+
+  printf("%-14s %8.0f %8.2f %8.2f %10.2f %10.2f\n", name, degrees, time, feedback.estimate_time(0, fabs(degrees)),
+         overshoot, error);
+  vexDelay(500);
+}
+
+int main()
+{
+  sim_robot_init();
+
+  printf("Time in seconds until the turn reports it's done, -1 = timed out after %ds. Angles in degrees\n",
+         TURN_TIMEOUT);
+  printf("%-14s %8s %8s %8s %10s %10s\n", "feedback", "turn", "time", "estimate", "overshoot", "final err");
+
+  double turns[] = {45, 90, 135, 180, -90};
+  for (double degrees : turns)
+    turn("turn_pidff", turn_pidff, degrees);
+  for (double degrees : turns)
+    turn("turn_mprofile", turn_mprofile, degrees);
+
+  FeedForward::ff_config_t found = MotionController::tune_feedforward_angular(drive_sys, imu);
+  printf("\ntune_feedforward_angular\n");
+  printf("  %-3s %10s %10s %9s\n", "", "real", "found", "error");
+  printf("  %-3s %10.6f %10.6f %8.1f%%\n", "kS", drive_angular_model.kS, found.kS,
+         100.0 * (found.kS - drive_angular_model.kS) / drive_angular_model.kS);
+  printf("  %-3s %10.6f %10.6f %8.1f%%\n", "kV", drive_angular_model.kV, found.kV,
+         100.0 * (found.kV - drive_angular_model.kV) / drive_angular_model.kV);
+  printf("  %-3s %10.6f %10.6f %8.1f%%\n", "kA", drive_angular_model.kA, found.kA,
+         100.0 * (found.kA - drive_angular_model.kA) / drive_angular_model.kA);
+
+  sim::finish();
+}
@@ -0,0 +1,16 @@
+/**
+ * File: v5.h
+ * Desc:
+ *    Host stand-in for the V5 SDK's C API, for the simulation in test/sim. Only what the library uses is here.
+ *    Time is simulated: vexDelay() advances it (see sim.h).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+void vexDelay(uint32_t ms);
+uint32_t vexSystemTimeGet();
+uint64_t vexSystemHighResTimeGet();
+int32_t vex_vsnprintf(char *out, uint32_t max_len, const char *format, va_list args);
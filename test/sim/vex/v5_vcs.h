@@ -0,0 +1,413 @@
+/**
+ * File: v5_vcs.h
+ * Desc:
+ *    Host stand-in for the V5 SDK's C++ API, for the simulation in test/sim. The declarations follow the SDK,
+ *    but only the parts the library uses are here, and only the parts the simulation links are implemented
+ *    (in sim.cpp).
+ *
+ *    Devices don't talk to hardware: a motor keeps the last command it was given, and the sensor values that a
+ *    simulated plant (see plants.h) writes into it every millisecond.
+ */
+#pragma once
+
+#include "v5.h"
+#include <functional>
+#include <vector>
+#include <mutex>
+
+namespace vex
+{
+  enum class directionType { fwd, rev, undefined };
+  enum class rotationUnits { deg, rev, raw };
+  struct rev_t
+  {
+    operator directionType() const { return directionType::rev; }
+    operator rotationUnits() const { return rotationUnits::rev; }
+  };
+  const rev_t rev = {};
+  const directionType fwd = directionType::fwd, forward = fwd, reverse = directionType::rev;
+  const rotationUnits deg = rotationUnits::deg, raw = rotationUnits::raw;
+  enum class voltageUnits { volt, mV };
+  const voltageUnits volt = voltageUnits::volt;
+  enum class percentUnits { pct };
+  const percentUnits pct = percentUnits::pct;
+  enum class velocityUnits { pct, rpm, dps };
+  const velocityUnits rpm = velocityUnits::rpm, dps = velocityUnits::dps;
+  enum class currentUnits { amp };
+  const currentUnits amp = currentUnits::amp;
+  enum class timeUnits { sec, msec };
+  const timeUnits sec = timeUnits::sec, msec = timeUnits::msec;
+  const timeUnits seconds = sec;
+  enum temperatureUnits { celsius, fahrenheit };
+  enum powerUnits { watt };
+  enum torqueUnits { Nm, InLb };
+  enum brakeType { coast, brake, hold };
+  enum gearSetting { ratio36_1, ratio18_1, ratio6_1 };
+  enum ledState { off, on };
+  enum fontType { mono12, mono15, mono20, mono30, mono40, mono60, prop20 };
+  enum analogUnits { pct_ };
+  enum axisType { xaxis, yaxis, zaxis };
+  enum { PORT1 = 0, PORT2, PORT3, PORT4, PORT5, PORT6, PORT7, PORT8, PORT9, PORT10, PORT11, PORT12, PORT13, PORT14,
+         PORT15, PORT16, PORT17, PORT18, PORT19, PORT20, PORT21 };
+
+  void wait(double time, timeUnits units);
+
+  class color
+  {
+  public:
+    color() {}
+    color(int, int, int) {}
+    color(int) {}
+    static const color white, black, red, green, blue, purple, orange, transparent, yellow;
+  };
+  extern const color black, white, red, green, blue, purple, orange, transparent, yellow;
+
+  class device
+  {
+  public:
+    bool installed();
+    int32_t index();
+  };
+
+  class motor : public device
+  {
+  public:
+    motor(int32_t port, bool reverse = false);
+    motor(int32_t port, gearSetting gears, bool reverse = false);
+    void spin(directionType dir, double voltage, voltageUnits units);
+    void spin(directionType dir, double velocity, percentUnits units);
+    void spin(directionType dir, double velocity, velocityUnits units);
+    void spin(directionType dir);
+    void setMaxTorque(double value, percentUnits units);
+    void stop();
+    void stop(brakeType mode);
+    void setStopping(brakeType mode);
+    double velocity(velocityUnits units);
+    double velocity(percentUnits units);
+    double position(rotationUnits units);
+    double rotation(rotationUnits units);
+    double current(currentUnits units = amp);
+    double current(percentUnits units);
+    double temperature(temperatureUnits units);
+    double voltage(voltageUnits units = volt);
+    double torque(torqueUnits units = Nm);
+    double power(powerUnits units = watt);
+    void resetPosition();
+    void resetRotation();
+    void setPosition(double value, rotationUnits units);
+
+    // Simulation state. The code under test sets the command, a plant sets the rest
+    double sim_volts = 0;            ///< commanded voltage. 0 while stopped
+    bool sim_stopped = true;         ///< true after stop(), until the next spin()
+    brakeType sim_stopping = coast;  ///< what stop() does
+    double sim_position = 0;         ///< true position of the output shaft, revolutions
+    double sim_velocity = 0;         ///< measured velocity of the output shaft, RPM
+    double sim_current = 0;          ///< amps
+    double sim_position_offset = 0;  ///< set by resetPosition() / setPosition()
+    double sim_ticks_per_rev = 900;  ///< encoder resolution, from the gear cartridge
+  };
+
+  class motor_group
+  {
+  public:
+    template <typename... Motors>
+    motor_group(Motors &...motors) : motors{&motors...} {}
+    void spin(directionType dir, double voltage, voltageUnits units);
+    void spin(directionType dir, double velocity, percentUnits units);
+    void spin(directionType dir, double velocity, velocityUnits units);
+    void spin(directionType dir);
+    void setMaxTorque(double value, percentUnits units);
+    void stop();
+    void stop(brakeType mode);
+    void setStopping(brakeType mode);
+    double velocity(velocityUnits units);
+    double velocity(percentUnits units);
+    double position(rotationUnits units);
+    double rotation(rotationUnits units);
+    double current(currentUnits units = amp);
+    double temperature(temperatureUnits units);
+    double voltage(voltageUnits units = volt);
+    void resetPosition();
+    void resetRotation();
+    void setPosition(double value, rotationUnits units);
+
+    std::vector<motor *> motors;
+  };
+
+  class timer
+  {
+  public:
+    timer();
+    void reset();
+    uint32_t time();
+    double time(timeUnits units);
+    double value();
+    void clear();
+    static uint32_t system();
+    static uint64_t systemHighResolution();
+
+  private:
+    uint32_t start_ms;
+  };
+
+  /**
+   * A task is a handle. Creating one starts a thread that the simulation runs in lockstep with simulated time
+   */
+  class task
+  {
+  public:
+    task();
+    task(int (*callback)(void));
+    task(int (*callback)(void *), void *arg);
+    void stop();
+    static void sleep(uint32_t ms);
+    bool suspend();
+    bool resume();
+    void setPriority(int32_t priority);
+
+  private:
+    int id;
+  };
+
+  /**
+   * Like a task, the thread keeps running once the handle is gone
+   */
+  class thread
+  {
+  public:
+    thread(int (*callback)(void));
+
+  private:
+    task t;
+  };
+
+  /**
+   * Waits in simulated time instead of blocking, so a task that holds the lock while it sleeps doesn't stop the
+   * simulation
+   */
+  class mutex
+  {
+  public:
+    void lock();
+    void unlock();
+    bool try_lock();
+
+  private:
+    std::mutex m;
+  };
+
+  class triport
+  {
+  public:
+    class port
+    {
+    };
+    port A, B, C, D, E, F, G, H;
+  };
+
+  class digital_out : public device
+  {
+  public:
+    digital_out(triport::port &port);
+    void set(bool value);
+    int32_t value();
+
+  private:
+    bool state = false;
+  };
+
+  class limit : public device
+  {
+  public:
+    limit(triport::port &port);
+    int32_t pressing();
+  };
+
+  class pot : public device
+  {
+  public:
+    pot(triport::port &port);
+    double angle(rotationUnits units = deg);
+  };
+
+  class encoder : public device
+  {
+  public:
+    encoder(triport::port &port);
+    double position(rotationUnits units);
+    double rotation(rotationUnits units);
+    double velocity(velocityUnits units);
+    void resetRotation();
+    void setPosition(double value, rotationUnits units);
+    void setRotation(double value, rotationUnits units);
+  };
+
+  class rotation : public device
+  {
+  public:
+    rotation(int32_t port, bool reverse = false);
+    double position(rotationUnits units);
+    double velocity(velocityUnits units);
+    void resetPosition();
+  };
+
+  class inertial : public device
+  {
+  public:
+    inertial(int32_t port);
+    void calibrate();
+    bool isCalibrating();
+    double rotation(rotationUnits units = deg);
+    double heading(rotationUnits units = deg);
+    double gyroRate(axisType axis, velocityUnits units);
+    void resetRotation();
+
+    // Simulation state, set by a plant. Clockwise positive, like the real sensor
+    double sim_rotation = 0; ///< degrees
+    double sim_rate = 0;     ///< degrees per second
+    double sim_offset = 0;   ///< set by resetRotation()
+  };
+
+  class optical : public device
+  {
+  public:
+    optical(int32_t port);
+    double hue();
+    void setLight(ledState state);
+    void setLightPower(double value, percentUnits units = pct);
+
+    double sim_hue = 0; ///< set by a plant
+  };
+
+  /**
+   * No camera is simulated: installed() is false, and a snapshot never finds anything
+   */
+  class vision : public device
+  {
+  public:
+    class signature
+    {
+    public:
+      signature(int32_t id, int32_t uMin, int32_t uMax, int32_t uMean, int32_t vMin, int32_t vMax, int32_t vMean,
+                float range, int32_t type) {}
+    };
+    class object
+    {
+    public:
+      int16_t id = 0;
+      int16_t originX = 0, originY = 0;
+      int16_t centerX = 0, centerY = 0;
+      int16_t width = 0, height = 0;
+      double angle = 0;
+      bool exists = false;
+    };
+
+    template <typename... Signatures>
+    vision(int32_t port, uint8_t brightness, Signatures &...sigs) {}
+    bool installed();
+    int32_t takeSnapshot(signature &sig);
+
+    int32_t objectCount = 0;
+    object largestObject;
+    object objects[16];
+  };
+
+  class controller
+  {
+  public:
+    class button
+    {
+    public:
+      bool pressing();
+      void pressed(void (*callback)(void));
+      void released(void (*callback)(void));
+    };
+    class axis
+    {
+    public:
+      int32_t position(percentUnits units = pct);
+      int32_t value();
+    };
+    class lcd
+    {
+    public:
+      void setCursor(int32_t row, int32_t col);
+      void print(const char *format, ...);
+      void clearScreen();
+      void clearLine(int32_t row);
+      void clearLine();
+      void newLine();
+    };
+    button ButtonA, ButtonB, ButtonX, ButtonY, ButtonUp, ButtonDown, ButtonLeft, ButtonRight, ButtonL1, ButtonL2,
+        ButtonR1, ButtonR2;
+    axis Axis1, Axis2, Axis3, Axis4;
+    lcd Screen;
+  };
+
+  class brain
+  {
+  public:
+    class lcd
+    {
+    public:
+      void setFont(fontType font);
+      void setPenColor(const color &c);
+      void setFillColor(const color &c);
+      void setPenWidth(uint32_t width);
+      void drawRectangle(int x, int y, int width, int height);
+      void drawRectangle(int x, int y, int width, int height, const color &c);
+      void drawLine(int x1, int y1, int x2, int y2);
+      void drawCircle(int x, int y, int radius);
+      void drawPixel(int x, int y);
+      void printAt(int x, int y, const char *format, ...);
+      void print(const char *format, ...);
+      void setCursor(int32_t row, int32_t col);
+      void newLine();
+      void clearScreen();
+      void clearScreen(const color &c);
+      bool pressing();
+      int32_t xPosition();
+      int32_t yPosition();
+      int32_t getStringWidth(const char *str);
+      bool drawImageFromBuffer(uint8_t *buf, int x, int y, int width, int height);
+      bool drawImageFromBuffer(uint32_t *buf, int x, int y, int width, int height);
+      bool render();
+      bool render(bool vsync, bool run_scheduler = false);
+      void clearLine(int32_t row);
+      void pressed(void (*callback)(void));
+      void pressed(void (*callback)(void *), void *arg);
+    };
+    class sdcard
+    {
+    public:
+      bool isInserted();
+      int32_t size(const char *name);
+      bool exists(const char *name);
+      int32_t loadfile(const char *name, uint8_t *buf, int32_t len);
+      int32_t savefile(const char *name, uint8_t *buf, int32_t len);
+      int32_t appendfile(const char *name, uint8_t *buf, int32_t len);
+    };
+    class battery
+    {
+    public:
+      double voltage(voltageUnits units = volt);
+      double current(currentUnits units = amp);
+      uint32_t capacity(percentUnits units = pct);
+      double temperature(temperatureUnits units = celsius);
+    };
+    lcd Screen;
+    sdcard SDcard;
+    battery Battery;
+    triport ThreeWirePort;
+    timer Timer;
+  };
+
+  class competition
+  {
+  public:
+    void autonomous(void (*callback)(void));
+    void drivercontrol(void (*callback)(void));
+    static bool isAutonomous();
+    static bool isEnabled();
+  };
+}